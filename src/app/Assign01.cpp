@@ -41,10 +41,9 @@ int main(int argc, char **argv) {
     };
     
     // Create Vulkan mesh
-    VulkanMesh mesh = createVulkanMesh(vkInitData, renderEngine->getCommandPool(), hostMesh); 
-    vector<VulkanMesh> allMeshes {
-        { mesh }
-    };
+    VulkanMesh mesh = createVulkanMesh(vkInitData, renderEngine->getStagingRing(), hostMesh); 
+    vector<VulkanMesh> allMeshes;
+    allMeshes.push_back(std::move(mesh));
 
     float timeElapsed = 1.0f;
     int framesRendered = 0;
@@ -55,12 +54,16 @@ int main(int argc, char **argv) {
     while (!glfwWindowShouldClose(window)) {
         // Get start time        
         auto startTime = getTime();
+        beginFrameStatsFrame(renderEngine->getFrameStats());
 
         // Poll events for window
-        glfwPollEvents();  
+        beginFrameStage(renderEngine->getFrameStats());
+        glfwPollEvents();
+        endFrameStage(renderEngine->getFrameStats(), FrameStage::Poll);
 
         // Draw frame
         renderEngine->drawFrame(&allMeshes);  
+        endFrameStatsFrame(renderEngine->getFrameStats());
 
         // Increment frame count
         framesRendered++;
@@ -82,9 +85,18 @@ int main(int argc, char **argv) {
         
     // Make sure all queues on GPU are done
     vkInitData.device.waitIdle();
+
+    // Frame time percentiles (catches hitches the FPS average hides)
+    FrameStatsSummary frameSummary = computeFrameStatsSummary(renderEngine->getFrameStats());
+    printFrameStatsSummary(frameSummary);
+    writeFrameStatsCSV(renderEngine->getFrameStats(), "Assign01_frames.csv");
+    writeFrameStatsJSON(frameSummary, "Assign01_frames.json");
     
     // Cleanup  
-    cleanupVulkanMesh(vkInitData, mesh);
+    for (auto &mesh : allMeshes) {
+        cleanupVulkanMesh(vkInitData, mesh);
+    }
+    allMeshes.clear();
     delete renderEngine;
     cleanupVulkanBootstrap(vkInitData);
     cleanupGLFWWindow(window);
@@ -5,6 +5,7 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include "MeshData.hpp"
+#include "MeshOptimize.hpp"
 
 // Hold information for a vertex
 struct Vertex {
@@ -186,16 +187,24 @@ int main(int argc, char **argv) {
     VulkanRenderEngine *renderEngine = new Assign02RenderEngine(vkInitData);
     renderEngine->initialize(&params);
 
+    // Queue every mesh upload in one batch
+    VulkanUploadBatch uploadBatch = beginVulkanUploadBatch(vkInitData, renderEngine->getStagingRing());
+
     // Create a mesh vertex obj. inside the loop
     for (unsigned int i = 0; i < sceneData.scene->mNumMeshes; i++) {
         aiMesh *aiMesh = sceneData.scene->mMeshes[i];
         Mesh<Vertex> mesh;
         extractMeshData(aiMesh, mesh);
+        optimizeMesh(mesh);
 
-        VulkanMesh vulkanMesh = createVulkanMesh(vkInitData, renderEngine->getCommandPool(), mesh);
-        sceneData.allMeshes.push_back(vulkanMesh);
+        VulkanMesh vulkanMesh = queueVulkanMeshUpload(uploadBatch, mesh);
+        sceneData.allMeshes.push_back(std::move(vulkanMesh));
     }
 
+    // Submit all uploads at once and wait before rendering
+    VulkanUploadToken uploadToken = submitVulkanUploadBatch(uploadBatch);
+    waitForVulkanUpload(vkInitData.device, uploadToken);
+
     /* Comment out the current code that creates hostMesh, VulkanMesh, & list
     // Create very simple quad on host    
     Mesh<SimpleVertex> hostMesh = {
@@ -209,7 +218,7 @@ int main(int argc, char **argv) {
     };
 
     // Create Vulkan mesh
-    VulkanMesh mesh = createVulkanMesh(vkInitData, renderEngine->getCommandPool(), hostMesh);
+    VulkanMesh mesh = createVulkanMesh(vkInitData, renderEngine->getStagingRing(), hostMesh);
     vector<VulkanMesh> allMeshes {
         { mesh }
     };
@@ -224,12 +233,16 @@ int main(int argc, char **argv) {
     while (!glfwWindowShouldClose(window)) {
         // Get start time
         auto startTime = getTime();
+        beginFrameStatsFrame(renderEngine->getFrameStats());
 
         // Poll events for window
+        beginFrameStage(renderEngine->getFrameStats());
         glfwPollEvents();
+        endFrameStage(renderEngine->getFrameStats(), FrameStage::Poll);
 
         // Draw frame
         renderEngine->drawFrame(&sceneData);
+        endFrameStatsFrame(renderEngine->getFrameStats());
 
         // Increment frame count
         framesRendered++;
@@ -252,6 +265,12 @@ int main(int argc, char **argv) {
     // Make sure all queues on GPU are done
     vkInitData.device.waitIdle();
 
+    // Frame time percentiles (catches hitches the FPS average hides)
+    FrameStatsSummary frameSummary = computeFrameStatsSummary(renderEngine->getFrameStats());
+    printFrameStatsSummary(frameSummary);
+    writeFrameStatsCSV(renderEngine->getFrameStats(), "Assign02_frames.csv");
+    writeFrameStatsJSON(frameSummary, "Assign02_frames.json");
+
     // Cleanup & After drawing loop
     //cleanupVulkanMesh(vkInitData, mesh);
     for (auto &mesh : sceneData.allMeshes) {
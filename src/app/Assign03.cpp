@@ -1,11 +1,13 @@
 #include "VKSetup.hpp"
 #include "VKRender.hpp"
+#include "SceneGraph.hpp"
 #include "VKImage.hpp"
 #include "VKUtility.hpp"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include "MeshData.hpp"
+#include "MeshOptimize.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #define GLM_ENABLE_EXPERIMENTAL
 #include "glm/gtx/transform.hpp"
@@ -21,7 +23,7 @@ struct Vertex {
 // Hold scene data
 struct SceneData {
     vector<VulkanMesh> allMeshes;
-    const aiScene *scene = nullptr;
+    SceneGraph graph;                   // Flattened copy of the aiScene node tree
     float rotAngle = 0.0f;
 };
 
@@ -105,7 +107,7 @@ class Assign03RenderEngine : public VulkanRenderEngine{
         //}
 
         // Instead of loop with recordDrawVulkan, call renderScene
-        renderScene(commandBuffer, sceneData, sceneData->scene->mRootNode, glm::mat4(1.0f), 0);
+        renderScene(commandBuffer, sceneData);
 
         // Stop render pass
         commandBuffer.endRenderPass();
@@ -126,44 +128,40 @@ class Assign03RenderEngine : public VulkanRenderEngine{
         return {vertexPushConstantRange};
     }
 
-    // Function for rendering a scene recursively
-    void renderScene(vk::CommandBuffer &commandBuffer,
-                     SceneData *sceneData, aiNode *node, 
-                     glm::mat4 parentMat, int level)
+    // Function for rendering the scene (one pass over the flattened nodes)
+    void renderScene(vk::CommandBuffer &commandBuffer, SceneData *sceneData)
     {
-        // Get the transformation for the current node
-        aiMatrix4x4 aiTrans = node->mTransformation;
-        glm::mat4 nodeT;
-
-        // Convert the transformation to a glm mat 4 nodeT
-        aiMatToGLM4(aiTrans, nodeT);
-
-        // Compute the current model matrix
-        glm::mat4 modelMat = parentMat * nodeT;
-
-        // Get location of current node
-        glm::vec3 pos = glm::vec3(modelMat[3]);
-        glm::mat4 R = makeRotateZ(sceneData->rotAngle, pos);
-        glm::mat4 tmpModel = R * modelMat;
-
-        UPushVertex uPush;
-        uPush.modelMat = tmpModel;
-
-        commandBuffer.pushConstants<UPushVertex>(
-            this->pipelineData.pipelineLayout,
-            vk::ShaderStageFlagBits::eVertex,
-            0,
-            uPush);
-
-        for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-            unsigned int meshIndex = node->mMeshes[i];
-            if (meshIndex < sceneData->allMeshes.size()) {
-                recordDrawVulkanMesh(commandBuffer, sceneData->allMeshes[meshIndex]);
+        SceneGraph &graph = sceneData->graph;
+
+        // Only nodes that changed get new world matrices
+        updateSceneGraph(graph);
+
+        // Same rotation for every node (about the origin; translation is fixed up per node)
+        glm::mat4 rotZ = makeRotateZ(sceneData->rotAngle, glm::vec3(0.0f));
+
+        for (unsigned int node = 0; node < getSceneNodeCnt(graph); node++) {
+            if (graph.meshCnt[node] == 0) {
+                continue;
             }
-        }
 
-        for (unsigned int i = 0; i < node->mNumChildren; i++) {
-            renderScene(commandBuffer, sceneData, node->mChildren[i], modelMat, level + 1);
+            // Rotating around the node's own position keeps that position
+            UPushVertex uPush;
+            uPush.modelMat = rotZ * graph.world[node];
+            uPush.modelMat[3] = graph.world[node][3];
+
+            commandBuffer.pushConstants<UPushVertex>(
+                this->pipelineData.pipelineLayout,
+                vk::ShaderStageFlagBits::eVertex,
+                0,
+                uPush);
+
+            unsigned int meshEnd = graph.meshStart[node] + graph.meshCnt[node];
+            for (unsigned int i = graph.meshStart[node]; i < meshEnd; i++) {
+                unsigned int meshIndex = graph.meshIndices[i];
+                if (meshIndex < sceneData->allMeshes.size()) {
+                    recordDrawVulkanMesh(commandBuffer, sceneData->allMeshes[meshIndex]);
+                }
+            }
         }
     }
 };
@@ -244,7 +242,7 @@ int main(int argc, char **argv) {
     Assimp::Importer importer;
 
     // Load the model using Assimp to get an aiScene
-    sceneData.scene = importer.ReadFile(
+    const aiScene *scene = importer.ReadFile(
                                   modelPath,
                                   aiProcess_Triangulate |
                                   aiProcess_FlipUVs |
@@ -252,7 +250,7 @@ int main(int argc, char **argv) {
                                   aiProcess_JoinIdenticalVertices);
 
     // Check to make sure the model loaded correctly
-    if (!sceneData.scene || sceneData.scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !sceneData.scene->mRootNode){
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode){
         cerr << "Error loading model: " << importer.GetErrorString() << endl;
         return -1;
     }
@@ -294,16 +292,29 @@ int main(int argc, char **argv) {
 
     //VulkanMesh vulkanMesh;
 
+    // Queue every mesh upload in one batch
+    VulkanUploadBatch uploadBatch = beginVulkanUploadBatch(vkInitData, renderEngine->getStagingRing());
+
     // Create a mesh vertex obj. inside the loop
-    for (unsigned int i = 0; i < sceneData.scene->mNumMeshes; i++) {
-        aiMesh *aiMesh = sceneData.scene->mMeshes[i];
+    for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+        aiMesh *aiMesh = scene->mMeshes[i];
         Mesh<Vertex> mesh;
         extractMeshData(aiMesh, mesh);
+        optimizeMesh(mesh);
 
-        VulkanMesh vulkanMesh = createVulkanMesh(vkInitData, renderEngine->getCommandPool(), mesh);
-        sceneData.allMeshes.push_back(vulkanMesh);
+        VulkanMesh vulkanMesh = queueVulkanMeshUpload(uploadBatch, mesh);
+        sceneData.allMeshes.push_back(std::move(vulkanMesh));
     }
 
+    // Keep only the node tree (flattened) and let Assimp free everything else
+    sceneData.graph = createSceneGraph(scene);
+    importer.FreeScene();
+    scene = nullptr;
+
+    // Submit all uploads at once and wait before rendering
+    VulkanUploadToken uploadToken = submitVulkanUploadBatch(uploadBatch);
+    waitForVulkanUpload(vkInitData.device, uploadToken);
+
     /* Comment out the current code that creates hostMesh, VulkanMesh, & list
     // Create very simple quad on host    
     Mesh<SimpleVertex> hostMesh = {
@@ -317,7 +328,7 @@ int main(int argc, char **argv) {
     };
 
     // Create Vulkan mesh
-    VulkanMesh mesh = createVulkanMesh(vkInitData, renderEngine->getCommandPool(), hostMesh);
+    VulkanMesh mesh = createVulkanMesh(vkInitData, renderEngine->getStagingRing(), hostMesh);
     vector<VulkanMesh> allMeshes {
         { mesh }
     };
@@ -332,12 +343,16 @@ int main(int argc, char **argv) {
     while (!glfwWindowShouldClose(window)) {
         // Get start time
         auto startTime = getTime();
+        beginFrameStatsFrame(renderEngine->getFrameStats());
 
         // Poll events for window
+        beginFrameStage(renderEngine->getFrameStats());
         glfwPollEvents();
+        endFrameStage(renderEngine->getFrameStats(), FrameStage::Poll);
 
         // Draw frame
         renderEngine->drawFrame(&sceneData);
+        endFrameStatsFrame(renderEngine->getFrameStats());
 
         // Increment frame count
         framesRendered++;
@@ -360,6 +375,12 @@ int main(int argc, char **argv) {
     // Make sure all queues on GPU are done
     vkInitData.device.waitIdle();
 
+    // Frame time percentiles (catches hitches the FPS average hides)
+    FrameStatsSummary frameSummary = computeFrameStatsSummary(renderEngine->getFrameStats());
+    printFrameStatsSummary(frameSummary);
+    writeFrameStatsCSV(renderEngine->getFrameStats(), "Assign03_frames.csv");
+    writeFrameStatsJSON(frameSummary, "Assign03_frames.json");
+
     // Cleanup & After drawing loop
     //cleanupVulkanMesh(vkInitData, mesh);
     for (auto &vulkanMesh : sceneData.allMeshes) {
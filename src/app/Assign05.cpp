@@ -1,8 +1,18 @@
 #include "VKSetup.hpp"
 #include "VKRender.hpp"
+#include "SceneGraph.hpp"
+#include "Frustum.hpp"
+#include "VKDrawList.hpp"
+#include "VKGPUCull.hpp"
+#include "MeshSimplify.hpp"
+#include "MeshOptimize.hpp"
+#include "VertexQuantize.hpp"
+#include "VKMeshCache.hpp"
 #include "VKImage.hpp"
 #include "VKUtility.hpp"
 #include "VKUniform.hpp"
+#include "VKMemoryTelemetry.hpp"
+#include "VKCompactor.hpp"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -13,6 +23,10 @@
 #include "glm/gtx/string_cast.hpp"
 #include "glm/gtc/type_ptr.hpp"
 #include <vulkan/vulkan_structs.hpp>
+#include <cctype>
+#include <cmath>
+#include <limits>
+#include <sstream>
 
 
 // Hold information for a vertex
@@ -32,7 +46,15 @@ struct PointLight {
 // Hold scene data
 struct SceneData {
     vector<VulkanMesh> allMeshes;
-    const aiScene *scene = nullptr;
+    VulkanMeshBuffers sceneBuffers;     // ALL meshes live in these two buffers
+    bool meshesReady = false;
+    SceneGraph graph;                   // Flattened copy of the aiScene node tree
+    vector<MeshBounds> meshBounds;      // Object-space bounds, one per mesh in allMeshes
+
+    // Compact vertices (QuantizedVertex); positions are dequantized by the model matrix
+    bool quantizedVertices = false;
+    vector<VertexDequantize> meshDequants;
+    vector<glm::mat4> meshDequantMats;
     float rotAngle = 0.0f;
     
     glm::vec3 eye = glm::vec3(0,0,1);
@@ -49,6 +71,42 @@ struct SceneData {
 
     float metallic = 0.0f;
     float roughness = 0.1f;
+
+    // Use the back-face culling pipeline variant (once it is compiled)
+    bool cullBackFaces = false;
+
+    // Cull and build the draws on the GPU (if the device supports it)
+    bool gpuCulling = false;
+
+    // Pick a coarser LOD as objects get smaller on screen (full detail at
+    // lodFullDetailPixels across, one level down every time that halves)
+    bool useLODs = true;
+    float lodFullDetailPixels = 256.0f;
+    float screenHeight = 600.0f;
+
+    // Last recorded frame went through the GPU-driven path; only drawCnt is
+    // updated then (the rest stays on the GPU)
+    bool drawnOnGPU = false;
+
+    // Frustum culling results from the last recorded frame
+    unsigned int drawCnt = 0;
+    unsigned int visibleDrawCnt = 0;
+
+    // Command encoder results from the last recorded frame (CPU path only)
+    unsigned int bindCnt = 0;
+    unsigned int skippedBindCnt = 0;
+    unsigned int instancedDrawCnt = 0;
+
+    // LOD results from the last recorded frame (CPU path only)
+    unsigned int lodDrawCnt = 0;            // Visible draws using a coarser LOD
+    size_t drawnTriangleCnt = 0;
+
+    // Extra copies of the whole scene (laid out on a grid in XZ)
+    vector<glm::vec3> copyOffsets = {glm::vec3(0.0f)};
+
+    // Frame capture (handled by the main loop)
+    bool screenshotRequested = false;
+    bool sequenceRequested = false;
 };
 
 // Hold Vertex shader UBO host data
@@ -57,10 +115,10 @@ struct UBOVertex {
     alignas(16) glm::mat4 projMat;
 };
 
-// Hold vertex shader push constants
-struct UPushVertex {
-    alignas(16)glm::mat4 modelMat;
-    alignas(16)glm::mat4 normMat;
+// Hold per-instance vertex data (binding 1, eInstance rate)
+struct InstanceData {
+    glm::mat4 modelMat;
+    glm::mat4 normMat;
 };
 
 // Hold fragment shader UBO host data
@@ -72,7 +130,6 @@ struct UBOFragment {
 
 // Global instance of struct
 SceneData sceneData;
-UPushVertex uPush;
 
 // Function for generating a transformation to rotate around Z
 glm::mat4 makeRotateZ(float rotAngle, glm::vec3 offset){
@@ -147,16 +204,50 @@ static void mouse_position_callback(GLFWwindow* window, double xpos, double ypos
 class Assign05RenderEngine : public VulkanRenderEngine{
     protected:
         UBOVertex hostUBOVert;
-        UBOData deviceUBOVert;
         UBOFragment hostUBOFrag;
-        UBOData deviceUBOFrag;
+
+        // Per-frame uniform space (bound with dynamic offsets)
+        const vk::DeviceSize FRAME_UNIFORM_SIZE = 64 * 1024;
+        VulkanFrameUniformAllocator frameUniforms;
 
         vk::DescriptorPool descriptorPool;
-        vector<vk::DescriptorSet> descriptorSets;
+        vk::DescriptorSet descriptorSet;
+
+        // Pipeline variant (compiled in the background)
+        uint64_t cullPipelineKey = 0;
+
+        // Frustum culling scratch (reused every frame)
+        FrustumSpheres cullSpheres;
+        vector<uint8_t> cullVisible;
+        vector<unsigned int> cullDrawNodes;
+        vector<unsigned int> cullDrawMeshes;
+        vector<glm::mat4> cullModelMats;
+
+        // Sorted draws for the frame
+        VulkanDrawList drawList;
+        VulkanCommandEncoder encoder;
+        uint32_t frameDynamicOffsets[2] = {0, 0};
+
+        // Per-frame instance transforms (binding 1); grown by reserveInstances() once the scene is known
+        const vk::DeviceSize MIN_FRAME_INSTANCE_SIZE = 64 * 1024;
+        VulkanFrameUniformAllocator frameInstances;
+
+        // GPU-driven path (created the first time it is used)
+        VulkanGPUCuller gpuCuller;
+        bool gpuCullerCreated = false;
+        vector<VulkanGPUCullObject> gpuObjects;
+
+        // Vertex format (fixed once the pipeline is created)
+        bool quantizedVertices = false;
+
+        // SceneData::projMat is GL-style; the vertex shader gets it with Y flipped
+        // for Vulkan's NDC, which also decides which winding faces the camera
+        const bool FLIP_PROJECTION_Y = true;
 
     // Constructor
     public:
-        Assign05RenderEngine(VulkanInitData &vkInitData): VulkanRenderEngine(vkInitData){}
+        Assign05RenderEngine(VulkanInitData &vkInitData, bool quantizedVertices = false)
+            : VulkanRenderEngine(vkInitData), quantizedVertices(quantizedVertices){}
 
     // Overrides initialize function
     virtual bool initialize(VulkanInitRenderParams *params) override {
@@ -164,64 +255,68 @@ class Assign05RenderEngine : public VulkanRenderEngine{
             return false;
         }
 
-        // Create deviceUBOVert
-        deviceUBOVert = createVulkanUniformBufferData(
+        // Start compiling the back-face culling variant right away
+        VulkanPipelineDesc cullDesc = getBasePipelineDesc();
+        cullDesc.cullMode = vk::CullModeFlagBits::eBack;
+        cullDesc.frontFace = FLIP_PROJECTION_Y ? vk::FrontFace::eCounterClockwise : vk::FrontFace::eClockwise;
+        cullPipelineKey = requestPipeline(cullDesc);
+
+        // Create per-frame uniform allocator
+        frameUniforms = createVulkanFrameUniformAllocator(
             vkInitData.device, vkInitData.physicalDevice, 
-            sizeof(UBOVertex), MAX_FRAMES_IN_FLIGHT);
+            FRAME_UNIFORM_SIZE, MAX_FRAMES_IN_FLIGHT);
 
-        // Create deviceUBOVert Frag
-        deviceUBOFrag = createVulkanUniformBufferData(
+        // Instance data is streamed the same way, but bound as a vertex buffer
+        frameInstances = createVulkanFrameUniformAllocator(
             vkInitData.device, vkInitData.physicalDevice, 
-            sizeof(UBOFragment), MAX_FRAMES_IN_FLIGHT);
+            MIN_FRAME_INSTANCE_SIZE, MAX_FRAMES_IN_FLIGHT,
+            vk::BufferUsageFlagBits::eVertexBuffer);
 
         // Create descriptor pool
         std::vector<vk::DescriptorPoolSize> poolSizes = {
-            {vk::DescriptorType::eUniformBuffer, 2 * static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT)}
+            {vk::DescriptorType::eUniformBufferDynamic, 2}
         };
         
         vk::DescriptorPoolCreateInfo poolCreateInfo = {};
         poolCreateInfo.setPoolSizes(poolSizes)
-                      .setMaxSets(MAX_FRAMES_IN_FLIGHT);
+                      .setMaxSets(1);
         
         descriptorPool = vkInitData.device.createDescriptorPool(poolCreateInfo);
 
-        // Create descriptor sets
-        std::vector<vk::DescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, pipelineData.descriptorSetLayouts[0]);
+        // Create ONE descriptor set (frames differ only by dynamic offset)
         vk::DescriptorSetAllocateInfo allocInfo = {};
         allocInfo.setDescriptorPool(descriptorPool)
-                 .setSetLayouts(layouts);
-        descriptorSets = vkInitData.device.allocateDescriptorSets(allocInfo);
-
-        // Configure descriptor sets
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-            vk::DescriptorBufferInfo bufferInfo = {};
-            bufferInfo.setBuffer(deviceUBOVert.bufferData[i].buffer)
+                 .setSetLayouts(pipelineData.descriptorSetLayouts[0]);
+        descriptorSet = vkInitData.device.allocateDescriptorSets(allocInfo)[0];
+
+        // Configure descriptor set
+        vk::DescriptorBufferInfo bufferInfo = {};
+        bufferInfo.setBuffer(frameUniforms.buffer.buffer)
+                  .setOffset(0)
+                  .setRange(sizeof(UBOVertex));
+
+        vk::WriteDescriptorSet write = {};
+        write.setDstSet(descriptorSet)
+             .setDstBinding(0)
+             .setDstArrayElement(0)
+             .setDescriptorType(vk::DescriptorType::eUniformBufferDynamic)
+             .setDescriptorCount(1)
+             .setBufferInfo(bufferInfo);
+
+        vk::DescriptorBufferInfo bufferFragInfo = {};
+        bufferFragInfo.setBuffer(frameUniforms.buffer.buffer)
                       .setOffset(0)
-                      .setRange(sizeof(UBOVertex));
+                      .setRange(sizeof(UBOFragment));
 
-            vk::WriteDescriptorSet write = {};
-            write.setDstSet(descriptorSets[i])
-                 .setDstBinding(0)
-                 .setDstArrayElement(0)
-                 .setDescriptorType(vk::DescriptorType::eUniformBuffer)
-                 .setDescriptorCount(1)
-                 .setBufferInfo(bufferInfo);
+        vk::WriteDescriptorSet descFragWrites = {};
+        descFragWrites.setDstSet(descriptorSet)
+                      .setDstBinding(1)
+                      .setDstArrayElement(0)
+                      .setDescriptorType(vk::DescriptorType::eUniformBufferDynamic)
+                      .setDescriptorCount(1)
+                      .setBufferInfo(bufferFragInfo);
 
-            vk::DescriptorBufferInfo bufferFragInfo = {};
-            bufferFragInfo.setBuffer(deviceUBOFrag.bufferData[i].buffer)
-                          .setOffset(0)
-                          .setRange(sizeof(UBOFragment));
-
-            vk::WriteDescriptorSet descFragWrites = {};
-            descFragWrites.setDstSet(descriptorSets[i])
-                          .setDstBinding(1)
-                          .setDstArrayElement(0)
-                          .setDescriptorType(vk::DescriptorType::eUniformBuffer)
-                          .setDescriptorCount(1)
-                          .setBufferInfo(bufferFragInfo);
-
-            vkInitData.device.updateDescriptorSets({write, descFragWrites}, {});
-        }
+        vkInitData.device.updateDescriptorSets({write, descFragWrites}, {});
 
         return true;
     };
@@ -232,14 +327,14 @@ class Assign05RenderEngine : public VulkanRenderEngine{
         
         // Vertex shader UBO binding
         binding.setBinding(0)
-               .setDescriptorType(vk::DescriptorType::eUniformBuffer)
+               .setDescriptorType(vk::DescriptorType::eUniformBufferDynamic)
                .setDescriptorCount(1)
                .setStageFlags(vk::ShaderStageFlagBits::eVertex)
                .setPImmutableSamplers(nullptr);
 
         // Fragment shader UBO binding
         allBindings.setBinding(1)
-                   .setDescriptorType(vk::DescriptorType::eUniformBuffer)
+                   .setDescriptorType(vk::DescriptorType::eUniformBufferDynamic)
                    .setDescriptorCount(1)
                    .setStageFlags(vk::ShaderStageFlagBits::eFragment)
                    .setPImmutableSamplers(nullptr);
@@ -297,27 +392,61 @@ class Assign05RenderEngine : public VulkanRenderEngine{
             )
         );
 
+        // Compact format replaces the float attributes above (same locations)
+        if (quantizedVertices) {
+            setVulkanQuantizedVertexAttributes(attribDescData, 0, 1, 2);
+        }
+
+        // Per-instance matrices (locations 3-6 and 7-10)
+        addVulkanInstanceBinding(attribDescData, 1, sizeof(InstanceData));
+        addVulkanMat4Attribute(attribDescData, 1, 3, offsetof(InstanceData, modelMat));
+        addVulkanMat4Attribute(attribDescData, 1, 7, offsetof(InstanceData, normMat));
+
         return attribDescData;
     }
 
     // Update uniform buffers
-    virtual void updateUniformBuffers(SceneData *sceneData, vk::CommandBuffer &commandBuffer) {
+    virtual void updateUniformBuffers(SceneData *sceneData) {
         hostUBOVert.viewMat = sceneData->viewMat;
         hostUBOVert.projMat = sceneData->projMat;
-        hostUBOVert.projMat[1][1] *= -1; // Invert Y-axis for Vulkan
+        if (FLIP_PROJECTION_Y) {
+            hostUBOVert.projMat[1][1] *= -1; // Invert Y-axis for Vulkan
+        }
+
+        // Start this frame's uniform region over
+        beginVulkanFrameUniforms(frameUniforms, currentImage);
 
-        memcpy(deviceUBOVert.mapped[currentImage], &hostUBOVert, sizeof(hostUBOVert));
+        uint32_t vertOffset = pushVulkanFrameUniform(frameUniforms, hostUBOVert);
 
         // Copy values from sceneData into appropriate fields
         hostUBOFrag.light = sceneData->light;
         hostUBOFrag.metallic = sceneData->metallic;
         hostUBOFrag.roughness = sceneData->roughness;
 
-        memcpy(deviceUBOFrag.mapped[this->currentImage], &hostUBOFrag, sizeof(hostUBOFrag));
+        uint32_t fragOffset = pushVulkanFrameUniform(frameUniforms, hostUBOFrag);
 
-        commandBuffer.bindDescriptorSets(
-            vk::PipelineBindPoint::eGraphics, pipelineData.pipelineLayout, 0,
-            descriptorSets[currentImage], {});
+        // Dynamic offsets are in binding order (bound with the draw packets)
+        frameDynamicOffsets[0] = vertOffset;
+        frameDynamicOffsets[1] = fragOffset;
+    }
+
+    bool isSceneReady(SceneData *sceneData) {
+        return sceneData->meshesReady && !sceneData->allMeshes.empty();
+    }
+
+    bool isUsingGPUCulling(SceneData *sceneData) {
+        return isSceneReady(sceneData) && sceneData->gpuCulling && isVulkanGPUCullingSupported(vkInitData);
+    }
+
+    // Override recordComputeCommands (runs before recordCommandBuffer)
+    virtual bool recordComputeCommands(void *userData, vk::CommandBuffer &commandBuffer) override {
+        SceneData *sceneData = static_cast<SceneData *>(userData);
+        if (!isUsingGPUCulling(sceneData)) {
+            return false;
+        }
+
+        cullSceneOnGPU(commandBuffer, sceneData);
+        return true;
     }
 
     // Override recordCommandBuffer
@@ -335,90 +464,283 @@ class Assign05RenderEngine : public VulkanRenderEngine{
             vk::ClearDepthStencilValue(1.0f, 0.0f)
         };
 
+        // GPU culling already ran (see recordComputeCommands())
+        bool sceneReady = isSceneReady(sceneData);
+        bool useGPUCulling = isUsingGPUCulling(sceneData);
+
+        beginGPUScope(commandBuffer, "renderPass");
         commandBuffer.beginRenderPass(
             vk::RenderPassBeginInfo(
                 renderPass, framebuffers[frameIndex],
                 {{0, 0}, extent}, clearValues),
             vk::SubpassContents::eInline);
 
-        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipelineData.graphicsPipeline);
-
         vk::Viewport viewport = {0, 0, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f};
         commandBuffer.setViewport(0, viewport);
 
         vk::Rect2D scissor = {{0, 0}, extent};
         commandBuffer.setScissor(0, scissor);
 
-        updateUniformBuffers(sceneData, commandBuffer);
+        updateUniformBuffers(sceneData);
 
-        renderScene(commandBuffer, sceneData, sceneData->scene->mRootNode, glm::mat4(1.0f), 0);
+        // Only draw once the background upload of the meshes is done
+        if (sceneReady) {
+            if (useGPUCulling) {
+                renderSceneGPU(commandBuffer, sceneData);
+            }
+            else {
+                renderScene(commandBuffer, sceneData);
+            }
+        }
 
         commandBuffer.endRenderPass();
+        endGPUScope(commandBuffer);
         commandBuffer.end();
     }
 
+    // Makes room for maxInstanceCnt instances per frame (every draw of every copy visible)
+    // Call before rendering starts; throws if that much instance space can't be bound
+    void reserveInstances(size_t maxInstanceCnt) {
+        vk::DeviceSize frameSize = max( (vk::DeviceSize)(maxInstanceCnt * sizeof(InstanceData)), 
+                                        MIN_FRAME_INSTANCE_SIZE);
+        if (frameSize <= frameInstances.frameSize) {
+            return;
+        }
+
+        // Bind offsets are 32-bit (leave room for the region alignment)
+        vk::DeviceSize totalSize = (frameSize + 64 * 1024) * MAX_FRAMES_IN_FLIGHT;
+        if (totalSize > numeric_limits<uint32_t>::max()) {
+            throw runtime_error("reserveInstances: " + to_string(maxInstanceCnt) + " instances need "
+                                + to_string(frameSize / (1024 * 1024)) + " MiB per frame (limit is "
+                                + to_string(numeric_limits<uint32_t>::max() / (1024 * 1024) / MAX_FRAMES_IN_FLIGHT)
+                                + " MiB); use fewer --copies");
+        }
+
+        vkInitData.device.waitIdle();
+        cleanupVulkanFrameUniformAllocator(vkInitData.device, frameInstances);
+        frameInstances = createVulkanFrameUniformAllocator(
+            vkInitData.device, vkInitData.physicalDevice, 
+            frameSize, MAX_FRAMES_IN_FLIGHT,
+            vk::BufferUsageFlagBits::eVertexBuffer);
+    }
+
     // Destructor
     virtual~Assign05RenderEngine(){
         vkInitData.device.destroyDescriptorPool(descriptorPool);
-        cleanupVulkanUniformBufferData(vkInitData.device, deviceUBOVert); // Vertex cleaner
-        cleanupVulkanUniformBufferData(vkInitData.device, deviceUBOFrag); // Frag cleaner
+        cleanupVulkanFrameUniformAllocator(vkInitData.device, frameUniforms);
+        cleanupVulkanFrameUniformAllocator(vkInitData.device, frameInstances);
+        if (gpuCullerCreated) {
+            cleanupVulkanGPUCuller(vkInitData.device, gpuCuller);
+        }
     };
 
-    virtual vector<vk::PushConstantRange>getPushConstantRanges()override{
-        // Create a push constant range for the vertex shader
-        vk::PushConstantRange vertexPushConstantRange;
-        vertexPushConstantRange.stageFlags = vk::ShaderStageFlagBits::eVertex;
+    // Function for rendering the whole scene (cull, sort, then record through the encoder)
+    void renderScene(vk::CommandBuffer &commandBuffer, SceneData *sceneData)
+    {
+        SceneGraph &graph = sceneData->graph;
+        sceneData->drawnOnGPU = false;
+
+        // Only nodes that changed get new world/normal matrices
+        updateSceneGraph(graph);
+
+        // Same rotation for every node (about the origin; translation is fixed up per node)
+        glm::mat4 rotZ = makeRotateZ(sceneData->rotAngle, glm::vec3(0.0f));
+        glm::mat3 viewRotZ = glm::mat3(sceneData->viewMat) * glm::mat3(rotZ);
+
+        unsigned int nodeCnt = getSceneNodeCnt(graph);
+
+        // Gather every draw of the scene once
+        clearFrustumSpheres(cullSpheres);
+        cullDrawNodes.clear();
+        cullDrawMeshes.clear();
+        cullModelMats.resize(nodeCnt);
+
+        for (unsigned int node = 0; node < nodeCnt; node++) {
+            if (graph.meshCnt[node] == 0) {
+                continue;
+            }
+
+            // Rotating around the node's own position keeps that position
+            glm::mat4 &modelMat = cullModelMats[node];
+            modelMat = rotZ * graph.world[node];
+            modelMat[3] = graph.world[node][3];
+
+            unsigned int meshEnd = graph.meshStart[node] + graph.meshCnt[node];
+            for (unsigned int i = graph.meshStart[node]; i < meshEnd; i++) {
+                unsigned int meshIndex = graph.meshIndices[i];
+                if (meshIndex >= sceneData->allMeshes.size()) {
+                    continue;
+                }
+
+                addFrustumSphere(cullSpheres, 
+                    transformBoundingSphere(sceneData->meshBounds[meshIndex].sphere, modelMat));
+                cullDrawNodes.push_back(node);
+                cullDrawMeshes.push_back(meshIndex);
+            }
+        }
+
+        // Then a moved sphere for every extra copy of it (draw = copy * baseDrawCnt + base)
+        unsigned int baseDrawCnt = (unsigned int)cullDrawNodes.size();
+        for (unsigned int copy = 1; copy < sceneData->copyOffsets.size(); copy++) {
+            glm::vec3 &offset = sceneData->copyOffsets[copy];
+            for (unsigned int base = 0; base < baseDrawCnt; base++) {
+                BoundingSphere sphere;
+                sphere.center = glm::vec3(cullSpheres.x[base], cullSpheres.y[base], cullSpheres.z[base]) + offset;
+                sphere.radius = cullSpheres.radius[base];
+                addFrustumSphere(cullSpheres, sphere);
+            }
+        }
+
+        // Test all of them at once (GL-style projection, before the Vulkan Y flip)
+        Frustum frustum = extractFrustum(sceneData->projMat * sceneData->viewMat);
+        sceneData->visibleDrawCnt = cullFrustumSpheres(frustum, cullSpheres, cullVisible);
+        sceneData->drawCnt = (unsigned int)cullSpheres.x.size();
+
+        // Variant falls back to the main pipeline until it is ready
+        VulkanDrawPacket packet;
+        packet.pipeline = sceneData->cullBackFaces ? getPipeline(cullPipelineKey) 
+                                                   : pipelineData.graphicsPipeline;
+        packet.pipelineLayout = pipelineData.pipelineLayout;
+        packet.descriptorSet = descriptorSet;
+        packet.dynamicOffsets[0] = frameDynamicOffsets[0];
+        packet.dynamicOffsets[1] = frameDynamicOffsets[1];
+        packet.dynamicOffsetCnt = 2;
+        packet.instanceBinding = 1;
+
+        // One instance per visible draw; copies of the same mesh share ONE draw
+        // (per LOD, since each LOD is its own index range)
+        beginVulkanDrawList(drawList);
+        float lodScale = getSphereScreenScale(sceneData->projMat, sceneData->screenHeight);
+        sceneData->lodDrawCnt = 0;
+        sceneData->drawnTriangleCnt = 0;
+
+        for (unsigned int draw = 0; draw < sceneData->drawCnt; draw++) {
+            if (!cullVisible[draw]) {
+                continue;
+            }
+
+            unsigned int base = draw % baseDrawCnt;
+            unsigned int node = cullDrawNodes[base];
+            InstanceData instance;
+            instance.modelMat = cullModelMats[node];
+            if (sceneData->quantizedVertices) {
+                instance.modelMat = instance.modelMat * sceneData->meshDequantMats[cullDrawMeshes[base]];
+            }
+            instance.modelMat[3] += glm::vec4(sceneData->copyOffsets[draw / baseDrawCnt], 0.0f);
+
+            // View and rotation are rigid, so only the cached world part needs an inverse
+            instance.normMat = glm::mat4(viewRotZ * graph.normalWorld[node]);
+
+            // Depth of the nearest point of the sphere
+            glm::vec3 center(cullSpheres.x[draw], cullSpheres.y[draw], cullSpheres.z[draw]);
+            float viewDepth = -(sceneData->viewMat * glm::vec4(center, 1.0f)).z - cullSpheres.radius[draw];
+
+            VulkanMesh &mesh = sceneData->allMeshes[cullDrawMeshes[base]];
+            unsigned int lod = 0;
+            if (sceneData->useLODs) {
+                float diameter = getProjectedSphereDiameter(lodScale, cullSpheres.radius[draw], 
+                                                            viewDepth + cullSpheres.radius[draw]);
+                lod = selectVulkanMeshLOD(mesh, diameter, sceneData->lodFullDetailPixels);
+            }
+            sceneData->lodDrawCnt += (lod > 0) ? 1 : 0;
 
-        vertexPushConstantRange.offset = 0;
-        vertexPushConstantRange.size = sizeof(UPushVertex);
+            setVulkanDrawPacketMesh(packet, sceneData->sceneBuffers, mesh, lod);
+            sceneData->drawnTriangleCnt += packet.indexCnt / 3;
+            addVulkanDrawInstance(drawList, packet, instance, viewDepth);
+        }
+
+        // Stream this frame's instances, then group by state (front to back within it)
+        beginVulkanFrameUniforms(frameInstances, currentImage);
+        writeVulkanDrawListInstances(drawList, frameInstances);
+        sortVulkanDrawList(drawList);
+
+        beginGPUScope(commandBuffer, "sceneDraws");
+        beginVulkanCommandEncoder(encoder, commandBuffer);
+        recordVulkanDrawList(encoder, drawList);
+        endGPUScope(commandBuffer);
 
-        // Return the appropriate vector push constant ranges
-        return {vertexPushConstantRange};
+        sceneData->instancedDrawCnt = encoder.drawCnt;
+        sceneData->bindCnt = encoder.bindCnt;
+        sceneData->skippedBindCnt = encoder.skippedBindCnt;
     }
 
-    // Function for rendering a scene recursively
-    void renderScene(vk::CommandBuffer &commandBuffer,
-                     SceneData *sceneData, aiNode *node, 
-                     glm::mat4 parentMat, int level)
+    // Culls every object (node mesh, per copy) in a compute shader
+    void cullSceneOnGPU(vk::CommandBuffer &commandBuffer, SceneData *sceneData)
     {
-        // Get the transformation for the current node
-        aiMatrix4x4 aiTrans = node->mTransformation;
-        glm::mat4 nodeT;
-
-        // Convert the transformation to a glm mat 4 nodeT
-        aiMatToGLM4(aiTrans, nodeT);
-
-        // Compute the current model matrix
-        glm::mat4 modelMat = parentMat * nodeT;
-
-        // Get location of current node
-        glm::vec3 pos = glm::vec3(modelMat[3]);
-        glm::mat4 R = makeRotateZ(sceneData->rotAngle, pos);
-        glm::mat4 tmpModel = R * modelMat;
-
-        // Compute normal matrix
-        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(sceneData->viewMat * tmpModel)));
-
-        UPushVertex uPush;
-        uPush.modelMat = tmpModel;
-        uPush.normMat = glm::mat4(normalMatrix);
-
-        commandBuffer.pushConstants<UPushVertex>(
-            this->pipelineData.pipelineLayout,
-            vk::ShaderStageFlagBits::eVertex,
-            0,
-            uPush);
-
-        for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-            unsigned int meshIndex = node->mMeshes[i];
-            if (meshIndex < sceneData->allMeshes.size()) {
-                recordDrawVulkanMesh(commandBuffer, sceneData->allMeshes[meshIndex]);
+        SceneGraph &graph = sceneData->graph;
+
+        // Objects only need uploading when some world matrix changed (the CPU path
+        // clears anyDirty too, so coming back from it always rebuilds)
+        bool rebuildObjects = graph.anyDirty || !gpuCullerCreated || !sceneData->drawnOnGPU;
+        updateSceneGraph(graph);
+        sceneData->drawnOnGPU = true;
+
+        if (rebuildObjects) {
+            gpuObjects.clear();
+            unsigned int nodeCnt = getSceneNodeCnt(graph);
+            for (auto &offset : sceneData->copyOffsets) {
+                for (unsigned int node = 0; node < nodeCnt; node++) {
+                    unsigned int meshEnd = graph.meshStart[node] + graph.meshCnt[node];
+                    for (unsigned int i = graph.meshStart[node]; i < meshEnd; i++) {
+                        if (graph.meshIndices[i] >= sceneData->allMeshes.size()) {
+                            continue;
+                        }
+
+                        VulkanGPUCullObject object;
+                        object.worldMat = graph.world[node];
+                        object.worldMat[3] += glm::vec4(offset, 0.0f);
+                        object.normalWorldMat = glm::mat4(graph.normalWorld[node]);
+                        object.meshIndex = graph.meshIndices[i];
+                        gpuObjects.push_back(object);
+                    }
+                }
             }
-        }
 
-        for (unsigned int i = 0; i < node->mNumChildren; i++) {
-            renderScene(commandBuffer, sceneData, node->mChildren[i], modelMat, level + 1);
+            if (!gpuCullerCreated) {
+                gpuCuller.lodFullDetailPixels = sceneData->lodFullDetailPixels;
+                createVulkanGPUCuller(  vkInitData, gpuCuller,
+                                        (unsigned int)gpuObjects.size(), 
+                                        (unsigned int)sceneData->allMeshes.size(),
+                                        MAX_FRAMES_IN_FLIGHT);
+                // Engine owns the pipeline (destroyed with it)
+                gpuCuller.compute = createComputePipeline(  "build/compiledshaders/Assign05/cull.comp.spv",
+                                                            {gpuCuller.descriptorSetLayout});
+                setVulkanGPUCullMeshes( gpuCuller, sceneData->allMeshes, sceneData->meshBounds, 
+                                        sceneData->meshDequants);
+                gpuCullerCreated = true;
+            }
+            setVulkanGPUCullObjects(gpuCuller, gpuObjects);
         }
+        sceneData->drawCnt = (unsigned int)gpuObjects.size();
+
+        // Same per-frame rotation as the CPU path
+        glm::mat4 rotZ = makeRotateZ(sceneData->rotAngle, glm::vec3(0.0f));
+        glm::mat3 viewRotZ = glm::mat3(sceneData->viewMat) * glm::mat3(rotZ);
+        Frustum frustum = extractFrustum(sceneData->projMat * sceneData->viewMat);
+
+        beginGPUScope(commandBuffer, "gpuCull");
+        float lodScale = sceneData->useLODs ? getSphereScreenScale(sceneData->projMat, sceneData->screenHeight) 
+                                            : 0.0f;
+        recordVulkanGPUCull(gpuCuller, commandBuffer, currentImage, frustum, rotZ, glm::mat4(viewRotZ),
+                            sceneData->viewMat, lodScale);
+        endGPUScope(commandBuffer);
+    }
+
+    // Draws whatever the compute pass kept (no per-object CPU work)
+    void renderSceneGPU(vk::CommandBuffer &commandBuffer, SceneData *sceneData)
+    {
+        // Variant falls back to the main pipeline until it is ready
+        vk::Pipeline pipeline = sceneData->cullBackFaces ? getPipeline(cullPipelineKey) 
+                                                         : pipelineData.graphicsPipeline;
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+        commandBuffer.bindDescriptorSets(
+            vk::PipelineBindPoint::eGraphics, pipelineData.pipelineLayout, 0,
+            descriptorSet, frameDynamicOffsets);
+        recordBindVulkanMesh(commandBuffer, sceneData->sceneBuffers);
+
+        beginGPUScope(commandBuffer, "sceneDraws");
+        recordVulkanGPUDraws(gpuCuller, commandBuffer, currentImage, 1);
+        endGPUScope(commandBuffer);
     }
 };
 
@@ -503,6 +825,26 @@ void keyCallBack(GLFWwindow* window, int key, int scanCode, int action, int mods
             case GLFW_KEY_M:
                 sceneData->roughness = std::min(0.7f, sceneData->roughness + 0.1f);
                 break;
+
+            case GLFW_KEY_C:
+                sceneData->cullBackFaces = !sceneData->cullBackFaces;
+                break;
+
+            case GLFW_KEY_G:
+                sceneData->gpuCulling = !sceneData->gpuCulling;
+                break;
+
+            case GLFW_KEY_L:
+                sceneData->useLODs = !sceneData->useLODs;
+                break;
+
+            case GLFW_KEY_P:
+                sceneData->screenshotRequested = true;
+                break;
+
+            case GLFW_KEY_O:
+                sceneData->sequenceRequested = true;
+                break;
         }
     }
 }
@@ -554,6 +896,9 @@ void extractMeshData(aiMesh *mesh, Mesh<Vertex>&m) {
             m.indices.push_back(face.mIndices[k]);
         }
     }
+
+    // Bounds for frustum culling
+    m.bounds = computeMeshBounds(m.vertices);
 }
 
 int main(int argc, char **argv) {
@@ -562,29 +907,95 @@ int main(int argc, char **argv) {
 
     // The model to load will be provided on the command line
     // Use sampleModels sphere as default model path
+    // Pass --headless [frameCnt] to render offscreen without a window
+    // Pass --copies N [spacing] to draw N copies of the scene (instanced)
+    // Pass --gpu-cull to start with GPU-driven culling (G toggles it)
+    // Pass --no-lod to always draw full detail (L toggles it)
+    // Pass --quantized to use compact 16-byte vertices (QuantizedVertex)
+    // Pass --no-mesh-cache to always import with Assimp (the cache is still rewritten)
     string modelPath = "sampleModels/bunnyteatime.glb";
-    if (argc >= 2){
-        modelPath = string(argv[1]);
+    bool headless = false;
+    int headlessFrameCnt = 300;
+    int copyCnt = 1;
+    float copySpacing = 2.0f;
+    bool useMeshCache = true;
+    for (int i = 1; i < argc; i++) {
+        string arg = string(argv[i]);
+        if (arg == "--headless") {
+            headless = true;
+            if (i + 1 < argc && isdigit(argv[i + 1][0])) {
+                headlessFrameCnt = atoi(argv[++i]);
+            }
+        }
+        else if (arg == "--gpu-cull") {
+            sceneData.gpuCulling = true;
+        }
+        else if (arg == "--no-lod") {
+            sceneData.useLODs = false;
+        }
+        else if (arg == "--quantized") {
+            sceneData.quantizedVertices = true;
+        }
+        else if (arg == "--no-mesh-cache") {
+            useMeshCache = false;
+        }
+        else if (arg == "--copies" && i + 1 < argc) {
+            copyCnt = max(atoi(argv[++i]), 1);
+            if (i + 1 < argc && isdigit(argv[i + 1][0])) {
+                copySpacing = (float)atof(argv[++i]);
+            }
+        }
+        else {
+            modelPath = arg;
+        }
+    }
+
+    unsigned int importFlags =  aiProcess_Triangulate |
+                                aiProcess_FlipUVs |
+                                aiProcess_GenNormals |
+                                aiProcess_JoinIdenticalVertices;
+    size_t vertexSize = sceneData.quantizedVertices ? sizeof(QuantizedVertex) : sizeof(Vertex);
+
+    // Anything that changes the processed scene must be part of the cache key
+    // (bump the "assign05" revision when the import/LOD/optimize steps change)
+    ostringstream cacheSettings;
+    cacheSettings   << "assign05 rev 1"
+                    << " import " << importFlags
+                    << " lods default"
+                    << " optimize " << MESH_OPTIMIZE_CACHE_SIZE
+                    << " vertex " << (sceneData.quantizedVertices ? "quantized" : "float") << " " << vertexSize;
+
+    // Try the processed scene cache first (skips Assimp, LODs, and optimization)
+    auto sceneStartTime = getTime();
+    VulkanMeshCacheKey cacheKey;
+    string cacheFilename;
+    VulkanMeshCacheFile meshCache;
+    bool cacheHit = false;
+    if (getVulkanMeshCacheKey(modelPath, hashVulkanMeshCacheSettings(cacheSettings.str()), cacheKey)) {
+        cacheFilename = getVulkanMeshCacheFilename(cacheKey);
+        if (useMeshCache) {
+            cacheHit = openVulkanMeshCache(cacheFilename, cacheKey, (uint32_t)vertexSize, meshCache);
+        }
     }
 
     Assimp::Importer importer;
+    const aiScene *scene = nullptr;
+    if (!cacheHit) {
+        // Load the model using Assimp to get an aiScene
+        scene = importer.ReadFile(modelPath, importFlags);
+
+        // Check to make sure the model loaded correctly
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode){
+            cerr << "Error loading model: " << importer.GetErrorString() << endl;
+            return -1;
+        }
 
-    // Load the model using Assimp to get an aiScene
-    sceneData.scene = importer.ReadFile(
-                                  modelPath,
-                                  aiProcess_Triangulate |
-                                  aiProcess_FlipUVs |
-                                  aiProcess_GenNormals |
-                                  aiProcess_JoinIdenticalVertices);
-
-    // Check to make sure the model loaded correctly
-    if (!sceneData.scene || sceneData.scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !sceneData.scene->mRootNode){
-        cerr << "Error loading model: " << importer.GetErrorString() << endl;
-        return -1;
+        // Print success msg
+        cout << "Model loaded successfully" << modelPath << endl;
     }
 
-    // Print success msg
-    cout << "Model loaded successfully" << modelPath << endl;
+    // Scene load time (not counting window and Vulkan setup)
+    float sceneSeconds = getElapsedSeconds(sceneStartTime, getTime());
 
     // Set name
     string appName = "Assign05";
@@ -592,68 +1003,194 @@ int main(int argc, char **argv) {
     int windowWidth = 800;
     int windowHeight = 600;
 
-    // Create GLFW window
-    GLFWwindow* window = createGLFWWindow(windowTitle, windowWidth, windowHeight);
+    GLFWwindow* window = nullptr;
+    if (!headless) {
+        // Create GLFW window
+        window = createGLFWWindow(windowTitle, windowWidth, windowHeight);
 
-    // After GLFW window creation
-    double mx, my;
-    glfwGetCursorPos(window, &mx, &my);
-    sceneData.mousePos = glm::vec2(mx, my);
+        // After GLFW window creation
+        double mx, my;
+        glfwGetCursorPos(window, &mx, &my);
+        sceneData.mousePos = glm::vec2(mx, my);
 
-    // Hide cursor
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        // Hide cursor
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-    // Set the mouse motion cursor callback
-    glfwSetCursorPosCallback(window, mouse_position_callback);
-    
-    // Set window user pointer
-    glfwSetWindowUserPointer(window, &sceneData);
+        // Set the mouse motion cursor callback
+        glfwSetCursorPosCallback(window, mouse_position_callback);
+        
+        // Set window user pointer
+        glfwSetWindowUserPointer(window, &sceneData);
 
-    // Set Key callBack function
-    glfwSetKeyCallback(window, keyCallBack);
+        // Set Key callBack function
+        glfwSetKeyCallback(window, keyCallBack);
+    }
 
     // Setup up Vulkan via vk-bootstrap
     VulkanInitData vkInitData;
-    initVulkanBootstrap(appName, window, vkInitData);
+    if (headless) {
+        initVulkanHeadless(appName, windowWidth, windowHeight, vkInitData, true);
+    }
+    else {
+        initVulkanBootstrap(appName, window, vkInitData, true);
+    }
 
     // Setup basic forward rendering process
-    string vertSPVFilename = "build/compiledshaders/" + appName + "/shader.vert.spv";
+    string vertSPVFilename = "build/compiledshaders/" + appName 
+                                + (sceneData.quantizedVertices ? "/shaderQuantized.vert.spv" : "/shader.vert.spv");
     string fragSPVFilename = "build/compiledshaders/" + appName + "/shader.frag.spv";
 
     // Create render engine
     VulkanInitRenderParams params = {vertSPVFilename, fragSPVFilename};
 
     // Before your drawing loop
-    VulkanRenderEngine *renderEngine = new Assign05RenderEngine(vkInitData);
+    Assign05RenderEngine *renderEngine = new Assign05RenderEngine(vkInitData, sceneData.quantizedVertices);
     renderEngine->initialize(&params);
 
-    VulkanMesh vulkanMesh;
+    // Lay out the copies on a square grid in XZ (first copy stays put)
+    int gridSize = (int)ceil(sqrt((double)copyCnt));
+    sceneData.copyOffsets.clear();
+    for (int i = 0; i < copyCnt; i++) {
+        sceneData.copyOffsets.push_back(glm::vec3(  (i % gridSize) * copySpacing, 0.0f, 
+                                                    -(i / gridSize) * copySpacing));
+    }
+
+    // Queue the whole scene as one merged upload
+    sceneStartTime = getTime();
+    VulkanUploadBatch uploadBatch = beginVulkanUploadBatch(vkInitData, renderEngine->getStagingRing());
+
+    if (cacheHit) {
+        // Already processed: copy the blobs straight from the mapping into staging
+        sceneData.graph = getVulkanMeshCacheSceneGraph(meshCache);
+        sceneData.meshBounds = getVulkanMeshCacheBounds(meshCache);
+        sceneData.allMeshes = queueVulkanMeshCacheUpload(uploadBatch, meshCache, sceneData.sceneBuffers);
+        closeVulkanMeshCache(meshCache);
+    }
+    else {
+        // Extract every mesh first
+        vector<Mesh<Vertex>> hostMeshes(scene->mNumMeshes);
+        for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+            aiMesh *aiMesh = scene->mMeshes[i];
+            extractMeshData(aiMesh, hostMeshes[i]);
+            sceneData.meshBounds.push_back(hostMeshes[i].bounds);
+        }
+
+        // Build the LOD chains (they share each mesh's vertices)
+        auto lodStartTime = getTime();
+        size_t lodIndexCnt = 0;
+        for (auto &hostMesh : hostMeshes) {
+            generateMeshLODs(hostMesh);
+            for (auto &lod : hostMesh.lods) {
+                lodIndexCnt += lod.indices.size();
+            }
+        }
+        cout << "Generated LODs in " << getElapsedSeconds(lodStartTime, getTime()) 
+            << " seconds (" << lodIndexCnt << " extra indices)" << endl;
+
+        // Reorder for the post-transform cache, overdraw, and vertex fetch (LODs included)
+        auto optimizeStartTime = getTime();
+        double missesBefore = 0.0;
+        double missesAfter = 0.0;
+        size_t triangleCnt = 0;
+        for (auto &hostMesh : hostMeshes) {
+            size_t meshTriangleCnt = hostMesh.indices.size() / 3;
+            missesBefore += getVertexCacheACMR(hostMesh.indices, hostMesh.vertices.size()) * meshTriangleCnt;
+            optimizeMesh(hostMesh);
+            missesAfter += getVertexCacheACMR(hostMesh.indices, hostMesh.vertices.size()) * meshTriangleCnt;
+            triangleCnt += meshTriangleCnt;
+        }
+        if (triangleCnt > 0) {
+            cout << "Optimized meshes in " << getElapsedSeconds(optimizeStartTime, getTime()) 
+                << " seconds (ACMR " << (missesBefore / triangleCnt) 
+                << " -> " << (missesAfter / triangleCnt) << ")" << endl;
+        }
+
+        // Keep only the node tree (flattened) and let Assimp free everything else
+        sceneData.graph = createSceneGraph(scene);
+        importer.FreeScene();
+        scene = nullptr;
+
+        // Upload, then save exactly what was uploaded for the next run
+        bool cacheSaved = false;
+        if (sceneData.quantizedVertices) {
+            // Each mesh is quantized within its own AABB
+            vector<Mesh<QuantizedVertex>> quantizedMeshes;
+            for (auto &hostMesh : hostMeshes) {
+                quantizedMeshes.push_back(quantizeMesh(hostMesh));
+            }
+            sceneData.allMeshes = queueVulkanMergedMeshUpload(uploadBatch, quantizedMeshes, sceneData.sceneBuffers);
+            if (!cacheFilename.empty()) {
+                cacheSaved = saveVulkanMeshCache(cacheFilename, cacheKey, quantizedMeshes, sceneData.graph);
+            }
+        }
+        else {
+            sceneData.allMeshes = queueVulkanMergedMeshUpload(uploadBatch, hostMeshes, sceneData.sceneBuffers);
+            if (!cacheFilename.empty()) {
+                cacheSaved = saveVulkanMeshCache(cacheFilename, cacheKey, hostMeshes, sceneData.graph);
+            }
+        }
+        if (cacheSaved) {
+            cout << "Saved mesh cache: " << cacheFilename << endl;
+        }
+    }
 
-    // Create a mesh vertex obj. inside the loop
-    for (unsigned int i = 0; i < sceneData.scene->mNumMeshes; i++) {
-        aiMesh *aiMesh = sceneData.scene->mMeshes[i];
-        Mesh<Vertex> mesh;
-        extractMeshData(aiMesh, mesh);
+    // Dequantization comes from the bounds, so it works the same for cached scenes
+    if (sceneData.quantizedVertices) {
+        for (auto &bounds : sceneData.meshBounds) {
+            sceneData.meshDequants.push_back(getVertexDequantize(bounds.box));
+            sceneData.meshDequantMats.push_back(getVertexDequantizeMatrix(sceneData.meshDequants.back()));
+        }
+    }
 
-        vulkanMesh = createVulkanMesh(vkInitData, renderEngine->getCommandPool(), mesh);
-        sceneData.allMeshes.push_back(vulkanMesh);
+    sceneSeconds += getElapsedSeconds(sceneStartTime, getTime());
+    cout << "Scene " << (cacheHit ? "loaded from mesh cache" : "imported") << " in " 
+        << sceneSeconds << " seconds" << endl;
+    cout << "Vertex buffer: " << sceneData.sceneBuffers.vertices.size 
+        << " bytes (" << vertexSize << " per vertex)" << endl;
+    cout << "Index buffer: " 
+        << ((sceneData.sceneBuffers.indexType == vk::IndexType::eUint16) ? "16" : "32") << "-bit" << endl;
+
+    // Worst case is every draw of every copy in view at once
+    size_t baseDrawCnt = 0;
+    for (unsigned int meshIndex : sceneData.graph.meshIndices) {
+        baseDrawCnt += (meshIndex < sceneData.allMeshes.size()) ? 1 : 0;
     }
+    size_t maxInstanceCnt = baseDrawCnt * sceneData.copyOffsets.size();
+    renderEngine->reserveInstances(maxInstanceCnt);
+    cout << "Instance space: " << maxInstanceCnt << " instances (" 
+        << (maxInstanceCnt * sizeof(InstanceData)) << " bytes per frame)" << endl;
+
+    // Submit all uploads at once (rendering starts while they finish)
+    VulkanUploadToken uploadToken = submitVulkanUploadBatch(uploadBatch);
 
     float timeElapsed = 1.0f;
     int framesRendered = 0;
     auto startCountTime = getTime();
     float fpsCalcWindow = 5.0f;
 
+    // Keep mesh memory packed (moves at most 4 MiB per frame)
+    VulkanMeshCompactor compactor = createVulkanMeshCompactor(vkInitData, 4 * 1024 * 1024);
+
+    // Record device memory use over time
+    VulkanMemoryTelemetryLog memoryLog;
+    openVulkanMemoryTelemetryLog(memoryLog, "memory_telemetry.csv", fpsCalcWindow);
+
     // Main render loop
-    while (!glfwWindowShouldClose(window)) {
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+    int totalFrameCnt = 0;
+    auto benchmarkStartTime = getTime();
+    while (headless ? (totalFrameCnt < headlessFrameCnt) : !glfwWindowShouldClose(window)) {
+        int width = vkInitData.swapchain.extent.width;
+        int height = vkInitData.swapchain.extent.height;
+        if (!headless) {
+            glfwGetFramebufferSize(window, &width, &height);
+        }
         
         float aspectRatio = (height > 0) ? static_cast<float>(width) / height : 1.0f;
+        sceneData.screenHeight = (float)height;
         
         // Update proj matrix 
         sceneData.projMat = glm::perspective(glm::radians(90.0f), aspectRatio, 0.01f, 50.0f);
-        //sceneData.projMat[1][1] *= -1; // Flip Y-coordinate for Vulkan's NDC
+        // (Y is flipped for Vulkan's NDC in updateUniformBuffers(); culling uses this GL-style one)
 
         // Update view matrix using glm::lookAt
         sceneData.viewMat = glm::lookAt(sceneData.eye, sceneData.lookAt, glm::vec3(0.0f, 1.0f, 0.0f));
@@ -663,17 +1200,53 @@ int main(int argc, char **argv) {
 
         // Get start time
         auto startTime = getTime();
+        beginFrameStatsFrame(renderEngine->getFrameStats());
 
         //glfwSwapBuffers(window);
 
         // Poll events for window
-        glfwPollEvents();
+        beginFrameStage(renderEngine->getFrameStats());
+        if (!headless) {
+            glfwPollEvents();
+        }
+        endFrameStage(renderEngine->getFrameStats(), FrameStage::Poll);
+
+        // Check on mesh upload
+        if (!sceneData.meshesReady) {
+            sceneData.meshesReady = isVulkanUploadComplete(vkInitData.device, uploadToken);
+
+            // Buffers can only be moved once their contents are uploaded
+            if (sceneData.meshesReady) {
+                registerVulkanMeshBuffersForCompaction(compactor, sceneData.sceneBuffers);
+            }
+        }
+
+        // Queue up any frame captures
+        if (sceneData.screenshotRequested) {
+            renderEngine->requestCapture("screenshots/Assign05_capture.png");
+            sceneData.screenshotRequested = false;
+        }
+        if (sceneData.sequenceRequested) {
+            renderEngine->requestCaptureSequence("screenshots/Assign05_seq", 60);
+            sceneData.sequenceRequested = false;
+        }
+        if (headless && totalFrameCnt == headlessFrameCnt - 1) {
+            renderEngine->requestCapture("screenshots/Assign05_headless.png");
+        }
 
         // Draw frame
         renderEngine->drawFrame(&sceneData);
 
+        // Move a few buffers if memory is fragmented
+        updateVulkanMeshCompactor(vkInitData, compactor);
+
+        // Dump memory telemetry (only every few seconds)
+        updateVulkanMemoryTelemetryLog(vkInitData.device, memoryLog);
+        endFrameStatsFrame(renderEngine->getFrameStats());
+
         // Increment frame count
         framesRendered++;
+        totalFrameCnt++;
 
         // Get end and elapsed
         auto endTime = getTime();
@@ -683,7 +1256,21 @@ int main(int argc, char **argv) {
 
         if(timeSoFar >= fpsCalcWindow) {
             float fps = framesRendered / timeSoFar;
-            cout << "FPS: " << fps << endl;
+            cout << "FPS: " << fps;
+            if (sceneData.drawnOnGPU) {
+                // Visibility, LODs, and draws are decided on the GPU and not read back
+                cout << " (drawn: n/a / " << sceneData.drawCnt << ", binds: n/a, skipped: n/a"
+                    << ", coarser LOD: n/a, triangles: n/a) [GPU culling]";
+            }
+            else {
+                cout << " (drawn: " << sceneData.visibleDrawCnt 
+                    << " / " << sceneData.drawCnt << ", binds: " << sceneData.bindCnt 
+                    << ", skipped: " << sceneData.skippedBindCnt 
+                    << ", instanced draws: " << sceneData.instancedDrawCnt 
+                    << ", coarser LOD: " << sceneData.lodDrawCnt 
+                    << ", triangles: " << sceneData.drawnTriangleCnt << ")";
+            }
+            cout << (sceneData.useLODs ? "" : " [no LOD]") << endl;
 
             startCountTime = getTime();
             framesRendered = 0;
@@ -693,16 +1280,42 @@ int main(int argc, char **argv) {
     // Make sure all queues on GPU are done
     vkInitData.device.waitIdle();
 
+    // Frame time percentiles (catches hitches the FPS average hides)
+    FrameStatsSummary frameSummary = computeFrameStatsSummary(renderEngine->getFrameStats());
+    printFrameStatsSummary(frameSummary);
+    writeFrameStatsCSV(renderEngine->getFrameStats(), "Assign05_frames.csv");
+    writeFrameStatsJSON(frameSummary, "Assign05_frames.json");
+
+    if (headless) {
+        float totalTime = getElapsedSeconds(benchmarkStartTime, getTime());
+        cout << "Headless: " << totalFrameCnt << " frames in " << totalTime << " seconds ("
+            << (totalFrameCnt / totalTime) << " FPS)" << endl;
+    }
+
+    // GPU timings per scope
+    printVulkanGPUProfileReport(renderEngine->getGPUProfiler());
+
+    // Final memory report
+    VulkanMemoryTelemetry memoryTelemetry = getVulkanMemoryTelemetry(vkInitData.device);
+    printVulkanMemoryTelemetry(memoryTelemetry);
+    closeVulkanMemoryTelemetryLog(memoryLog);
+
+    // Apply any last moves before freeing meshes
+    cleanupVulkanMeshCompactor(vkInitData, compactor);
+
     // Cleanup & After drawing loop
     //cleanupVulkanMesh(vkInitData, mesh);
     for (auto &vulkanMesh : sceneData.allMeshes) {
         cleanupVulkanMesh(vkInitData, vulkanMesh);
     }
     sceneData.allMeshes.clear();
+    cleanupVulkanMeshBuffers(vkInitData, sceneData.sceneBuffers);
 
     delete renderEngine;
     cleanupVulkanBootstrap(vkInitData);
-    cleanupGLFWWindow(window);
+    if (window) {
+        cleanupGLFWWindow(window);
+    }
 
     cout << "FORGING DONE!!!" << endl;
     return 0;
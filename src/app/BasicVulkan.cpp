@@ -44,10 +44,9 @@ int main(int argc, char **argv) {
     };
     
     // Create Vulkan mesh
-    VulkanMesh mesh = createVulkanMesh(vkInitData, renderEngine->getCommandPool(), hostMesh); 
-    vector<VulkanMesh> allMeshes {
-        { mesh }
-    };
+    VulkanMesh mesh = createVulkanMesh(vkInitData, renderEngine->getStagingRing(), hostMesh); 
+    vector<VulkanMesh> allMeshes;
+    allMeshes.push_back(std::move(mesh));
 
     float timeElapsed = 1.0f;
     int framesRendered = 0;
@@ -87,7 +86,10 @@ int main(int argc, char **argv) {
     vkInitData.device.waitIdle();
     
     // Cleanup  
-    cleanupVulkanMesh(vkInitData, mesh);
+    for (auto &mesh : allMeshes) {
+        cleanupVulkanMesh(vkInitData, mesh);
+    }
+    allMeshes.clear();
     delete renderEngine;
     cleanupVulkanBootstrap(vkInitData);
     cleanupGLFWWindow(window);
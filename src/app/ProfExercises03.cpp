@@ -165,11 +165,11 @@ int main(int argc, char **argv) {
                 | vk::MemoryPropertyFlagBits::eHostCoherent);
     
     copyDataToVulkanBuffer( device, 
-                            vkVertices.memory, 
+                            vkVertices, 
                             vertBufferSize,
                             vertices.data());
     copyDataToVulkanBuffer( device, 
-                            vkIndices.memory, 
+                            vkIndices, 
                             indBufferSize,
                             indices.data());
 
@@ -435,6 +435,7 @@ int main(int argc, char **argv) {
     }
     swapviews.clear();
     device.destroySwapchainKHR(swapchain);
+    cleanupVulkanMemoryAllocator(device);
     device.destroy();
     instance.destroySurfaceKHR(surface);
     glfwDestroyWindow(window);
@@ -243,11 +243,11 @@ int main(int argc, char **argv) {
                 | vk::MemoryPropertyFlagBits::eHostCoherent);
     
     copyDataToVulkanBuffer( device, 
-                            vkVertices.memory, 
+                            vkVertices, 
                             vertBufferSize,
                             vertices.data());
     copyDataToVulkanBuffer( device, 
-                            vkIndices.memory, 
+                            vkIndices, 
                             indBufferSize,
                             indices.data());
 
@@ -528,6 +528,7 @@ int main(int argc, char **argv) {
     }
     swapviews.clear();
     device.destroySwapchainKHR(swapchain);
+    cleanupVulkanMemoryAllocator(device);
     device.destroy();
     instance.destroySurfaceKHR(surface);
     glfwDestroyWindow(window);
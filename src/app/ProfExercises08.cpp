@@ -314,11 +314,11 @@ int main(int argc, char **argv) {
                 | vk::MemoryPropertyFlagBits::eHostCoherent);
     
     copyDataToVulkanBuffer( device, 
-                            vkVertices.memory, 
+                            vkVertices, 
                             vertBufferSize,
                             vertices.data());
     copyDataToVulkanBuffer( device, 
-                            vkIndices.memory, 
+                            vkIndices, 
                             indBufferSize,
                             indices.data());
 
@@ -689,6 +689,7 @@ int main(int argc, char **argv) {
     }
     swapviews.clear();
     device.destroySwapchainKHR(swapchain);
+    cleanupVulkanMemoryAllocator(device);
     device.destroy();
     instance.destroySurfaceKHR(surface);
     glfwDestroyWindow(window);
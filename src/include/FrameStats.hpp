@@ -0,0 +1,87 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include "VKUtility.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Frame statistics
+// - CPU time of every frame (split into stages) goes into a fixed-size ring
+// - One thread writes (the render loop); any thread can take a snapshot
+//   without locks (the slot being written next is skipped)
+// - Summaries give percentiles and a histogram, so hitches (swapchain
+//   recreation, uploads, etc.) show up instead of vanishing in an average
+///////////////////////////////////////////////////////////////////////////////
+
+enum class FrameStage {
+    Poll = 0,           // Window/input events
+    Wait,               // Waiting on the frame fence (GPU-bound time)
+    Record,             // Recording command buffers
+    Submit,             // Queue submit
+    Present,            // Queue present
+    Count
+};
+
+string getFrameStageName(FrameStage stage);
+
+// Frame flags
+const unsigned int FRAME_FLAG_SWAPCHAIN_RECREATED = 1;
+
+struct FrameTiming {
+    uint64_t frameIndex = 0;
+    float totalMS = 0.0f;
+    float stageMS[(int)FrameStage::Count] = {};
+    unsigned int flags = 0;
+};
+
+struct FrameStats {
+    vector<FrameTiming> ring;
+    atomic<uint64_t> writeCnt { 0 };    // Frames ever written
+
+    // Frame being timed (render thread only)
+    bool inFrame = false;
+    FrameTiming current;
+    chrono::steady_clock::time_point frameStart;
+    chrono::steady_clock::time_point stageStart;
+};
+
+struct FrameStatsPercentiles {
+    float meanMS = 0.0f;
+    float p50MS = 0.0f;
+    float p95MS = 0.0f;
+    float p99MS = 0.0f;
+    float maxMS = 0.0f;
+};
+
+struct FrameStatsSummary {
+    unsigned int frameCnt = 0;
+    unsigned int flaggedFrameCnt = 0;       // e.g., swapchain recreated
+    FrameStatsPercentiles total;
+    FrameStatsPercentiles stages[(int)FrameStage::Count];
+
+    // Histogram of total frame time; the last bin holds everything above
+    float binWidthMS = 1.0f;
+    vector<unsigned int> histogram;
+};
+
+void createFrameStats(FrameStats &stats, unsigned int capacity = 4096);
+
+void beginFrameStatsFrame(FrameStats &stats);
+void beginFrameStage(FrameStats &stats);
+void endFrameStage(FrameStats &stats, FrameStage stage);
+void flagFrameStatsFrame(FrameStats &stats, unsigned int flags);
+void endFrameStatsFrame(FrameStats &stats);
+
+vector<FrameTiming> getFrameStatsSnapshot(FrameStats &stats);
+FrameStatsSummary computeFrameStatsSummary( FrameStats &stats,
+                                            float binWidthMS = 1.0f,
+                                            unsigned int binCnt = 50);
+
+void printFrameStatsSummary(FrameStatsSummary &summary);
+bool writeFrameStatsCSV(FrameStats &stats, string filename);
+bool writeFrameStatsJSON(FrameStatsSummary &summary, string filename);
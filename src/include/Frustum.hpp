@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "glm/glm.hpp"
+#include "MeshData.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Frustum culling
+// - Planes come from a view-projection matrix (OpenGL-style clip space,
+//   which is what glm::perspective gives by default)
+// - World-space bounding spheres are kept as structure of arrays so they
+//   can be tested 4 at a time with SSE (scalar code handles the rest)
+///////////////////////////////////////////////////////////////////////////////
+
+struct Frustum {
+    glm::vec4 planes[6];        // (normal, d); inside when dot(normal, p) + d >= 0
+};
+
+struct FrustumSpheres {
+    vector<float> x;
+    vector<float> y;
+    vector<float> z;
+    vector<float> radius;
+};
+
+Frustum extractFrustum(const glm::mat4 &viewProj);
+
+// Sphere of a mesh after it is transformed by modelMat
+BoundingSphere transformBoundingSphere(const BoundingSphere &sphere, const glm::mat4 &modelMat);
+
+// Pixels per unit of radius at view depth 1: projMat[1][1] * screenHeight
+// (diameter on screen = radius * scale / depth)
+float getSphereScreenScale(const glm::mat4 &projMat, float screenHeight);
+float getProjectedSphereDiameter(float screenScale, float radius, float viewDepth);
+
+void clearFrustumSpheres(FrustumSpheres &spheres);
+void addFrustumSphere(FrustumSpheres &spheres, const BoundingSphere &sphere);
+
+// Sets visible[i] to 0/1 for every sphere; returns how many are visible
+unsigned int cullFrustumSpheres(const Frustum &frustum, 
+                                const FrustumSpheres &spheres,
+                                vector<uint8_t> &visible);
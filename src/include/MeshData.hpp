@@ -1,6 +1,7 @@
 #pragma once
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include "glm/glm.hpp"
 using namespace std;
 
@@ -10,9 +11,60 @@ struct SimpleVertex {
 	glm::vec4 color;
 };
 
+// Struct for holding mesh bounds (object space)
+struct AABB {
+	glm::vec3 min = glm::vec3(0.0f);
+	glm::vec3 max = glm::vec3(0.0f);
+};
+
+struct BoundingSphere {
+	glm::vec3 center = glm::vec3(0.0f);
+	float radius = 0.0f;
+};
+
+struct MeshBounds {
+	AABB box;
+	BoundingSphere sphere;
+};
+
+// Struct for holding a lower level of detail (indexes the mesh's own vertices)
+struct MeshLOD {
+	vector<unsigned int> indices {};
+	float error = 0.0f;		// Largest geometric error vs. full detail (model units)
+};
+
 // Struct for holding mesh data
 template<typename T>
 struct Mesh {
 	vector<T> vertices {};
 	vector<unsigned int> indices {};
+	MeshBounds bounds {};
+	vector<MeshLOD> lods {};	// LOD 1, 2, ... (LOD 0 is indices); see generateMeshLODs()
 };
+
+// Box around all vertex positions; sphere centered on the box
+// (T must have a glm::vec3 pos)
+template<typename T>
+MeshBounds computeMeshBounds(const vector<T> &vertices) {
+	MeshBounds bounds;
+	if(vertices.empty()) {
+		return bounds;
+	}
+
+	bounds.box.min = vertices[0].pos;
+	bounds.box.max = vertices[0].pos;
+	for(auto &v : vertices) {
+		bounds.box.min = glm::min(bounds.box.min, v.pos);
+		bounds.box.max = glm::max(bounds.box.max, v.pos);
+	}
+
+	bounds.sphere.center = (bounds.box.min + bounds.box.max) * 0.5f;
+	float radius2 = 0.0f;
+	for(auto &v : vertices) {
+		glm::vec3 d = v.pos - bounds.sphere.center;
+		radius2 = std::max(radius2, d.x*d.x + d.y*d.y + d.z*d.z);
+	}
+	bounds.sphere.radius = glm::sqrt(radius2);
+
+	return bounds;
+}
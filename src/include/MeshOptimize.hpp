@@ -0,0 +1,75 @@
+#pragma once
+#include <vector>
+#include "glm/glm.hpp"
+#include "MeshData.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Index/vertex order optimization (run once at import)
+// - Vertex cache: greedy triangle order (Forsyth's scoring) so each vertex
+//   is shaded as few times as possible
+// - Overdraw: cuts that order where the cache starts over anyway, then draws
+//   the outer, outward-facing clusters first (cache order kept inside each)
+// - Vertex fetch: renumbers vertices in first-use order so the vertex buffer
+//   is read (mostly) front to back
+///////////////////////////////////////////////////////////////////////////////
+
+// Post-transform cache size the optimizer and ACMR are measured against
+const unsigned int MESH_OPTIMIZE_CACHE_SIZE = 16;
+
+// Average vertices shaded per triangle with a FIFO cache
+// (about 0.5-0.7 is very good, 3 means every vertex is shaded every time)
+float getVertexCacheACMR(   const vector<unsigned int> &indices,
+                            size_t vertexCnt,
+                            unsigned int cacheSize = MESH_OPTIMIZE_CACHE_SIZE);
+
+vector<unsigned int> optimizeVertexCacheIndices(const vector<unsigned int> &indices, size_t vertexCnt);
+
+// Expects cache-optimized indices; threshold is how much worse the ACMR may
+// get to make smaller (better sorted) clusters (1.05 = 5% worse)
+vector<unsigned int> optimizeOverdrawIndices(   const vector<glm::vec3> &positions,
+                                                const vector<unsigned int> &indices,
+                                                float threshold = 1.05f);
+
+// remap[oldVertex] = newVertex, in first-use order (unused vertices go last)
+vector<unsigned int> getVertexFetchRemap(const vector<unsigned int> &indices, size_t vertexCnt);
+
+// All three passes; LOD index lists are cache-optimized and remapped too
+// (T must have a glm::vec3 pos)
+template<typename T>
+void optimizeMesh(Mesh<T> &mesh, float overdrawThreshold = 1.05f) {
+    if(mesh.indices.empty()) {
+        return;
+    }
+
+    size_t vertexCnt = mesh.vertices.size();
+    vector<glm::vec3> positions;
+    positions.reserve(vertexCnt);
+    for(auto &v : mesh.vertices) {
+        positions.push_back(v.pos);
+    }
+
+    mesh.indices = optimizeVertexCacheIndices(mesh.indices, vertexCnt);
+    mesh.indices = optimizeOverdrawIndices(positions, mesh.indices, overdrawThreshold);
+    for(auto &lod : mesh.lods) {
+        lod.indices = optimizeVertexCacheIndices(lod.indices, vertexCnt);
+    }
+
+    // Fetch order follows the full mesh (LODs only use a subset of its vertices)
+    vector<unsigned int> remap = getVertexFetchRemap(mesh.indices, vertexCnt);
+    vector<T> vertices(vertexCnt);
+    for(size_t i = 0; i < vertexCnt; i++) {
+        vertices[remap[i]] = mesh.vertices[i];
+    }
+    mesh.vertices.swap(vertices);
+
+    for(auto &index : mesh.indices) {
+        index = remap[index];
+    }
+    for(auto &lod : mesh.lods) {
+        for(auto &index : lod.indices) {
+            index = remap[index];
+        }
+    }
+}
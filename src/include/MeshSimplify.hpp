@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+#include "glm/glm.hpp"
+#include "MeshData.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Mesh simplification (quadric error metrics)
+// - Half-edge collapses onto existing vertices, so every LOD is just a new
+//   index list over the SAME vertices (one vertex buffer for all LODs)
+// - Border vertices and attribute seams (same position, different vertex)
+//   never move, which keeps silhouettes and UV/normal splits intact
+// - Collapses that would flip a triangle are skipped
+///////////////////////////////////////////////////////////////////////////////
+
+// Returns the simplified indices (at most targetIndexCnt unless the mesh cannot
+// go lower); outError gets the largest collapse error (distance, model units)
+vector<unsigned int> simplifyMeshIndices(   const vector<glm::vec3> &positions,
+                                            const vector<unsigned int> &indices,
+                                            size_t targetIndexCnt,
+                                            float *outError = nullptr);
+
+// Fills mesh.lods with up to maxLODs extra levels, each with about
+// reduction times the indices of the one before (T must have a glm::vec3 pos)
+template<typename T>
+void generateMeshLODs(Mesh<T> &mesh, unsigned int maxLODs = 3, float reduction = 0.5f) {
+    mesh.lods.clear();
+
+    vector<glm::vec3> positions;
+    positions.reserve(mesh.vertices.size());
+    for(auto &v : mesh.vertices) {
+        positions.push_back(v.pos);
+    }
+
+    const vector<unsigned int> *previous = &mesh.indices;
+    for(unsigned int i = 0; i < maxLODs; i++) {
+        size_t target = (size_t)(previous->size() * reduction) / 3 * 3;
+        if(target < 3) {
+            break;
+        }
+
+        MeshLOD lod;
+        lod.indices = simplifyMeshIndices(positions, *previous, target, &lod.error);
+
+        // Stop once simplification stalls (less than 10% fewer indices)
+        if(lod.indices.empty() || lod.indices.size() > previous->size() * 0.9f) {
+            break;
+        }
+
+        // Errors add up level to level (each is measured against the one before)
+        if(!mesh.lods.empty()) {
+            lod.error += mesh.lods.back().error;
+        }
+
+        mesh.lods.push_back(std::move(lod));
+        previous = &mesh.lods.back().indices;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "VKUtility.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Flattened scene graph
+// - Copied out of an aiScene once (the importer can be freed afterwards)
+// - Nodes are stored depth-first, so every parent comes before its children
+//   and each subtree is the contiguous range [node, subtreeEnd[node])
+// - Structure of arrays: updates are linear scans over contiguous memory
+// - Only dirty nodes (and everything under them) get new world/normal
+//   matrices; if nothing changed, updateSceneGraph() does nothing
+///////////////////////////////////////////////////////////////////////////////
+
+struct SceneGraph {
+    vector<int> parent;                 // -1 for the root
+    vector<unsigned int> depth;         // Root is 0
+    vector<unsigned int> subtreeEnd;    // One past the last node of this subtree
+    vector<string> names;
+
+    vector<glm::mat4> local;            // Relative to parent
+    vector<glm::mat4> world;            // parent world * local
+    vector<glm::mat3> normalWorld;      // Inverse transpose of world (upper 3x3)
+
+    // Meshes drawn at node i are meshIndices[meshStart[i] ... meshStart[i] + meshCnt[i])
+    vector<unsigned int> meshStart;
+    vector<unsigned int> meshCnt;
+    vector<unsigned int> meshIndices;
+
+    vector<uint8_t> dirty;
+    bool anyDirty = false;
+};
+
+SceneGraph createSceneGraph(const aiScene *scene);
+
+// For graphs whose structure (parent through meshIndices) was filled in some
+// other way (e.g., a mesh cache): sizes the rest and computes every world matrix
+void completeSceneGraph(SceneGraph &graph);
+
+unsigned int getSceneNodeCnt(SceneGraph &graph);
+void setSceneNodeLocal(SceneGraph &graph, unsigned int node, const glm::mat4 &local);
+
+// Recomputes world/normal matrices of dirty subtrees only
+void updateSceneGraph(SceneGraph &graph);
@@ -3,32 +3,36 @@
 #include <fstream>
 #include <vulkan/vulkan.hpp>
 #include "VKUtility.hpp"
+#include "VKMemory.hpp"
+#include "VKDeletion.hpp"
 
 using namespace std;
 
+// Move-only: destroyed by its deleter when it goes out of scope
+// (or earlier with cleanupVulkanBuffer())
 struct VulkanBuffer {
     vk::Buffer buffer;
-    vk::DeviceMemory memory;
-};
+    VulkanAllocation allocation;    // Range inside a shared device memory block
+    vk::DeviceSize size = 0;        // Requested size and usage (needed to recreate/move it)
+    vk::BufferUsageFlags usage;
+    VulkanDeleter deleter;
 
-unsigned int findMemoryType(unsigned int typeFilter, 
-                            vk::MemoryPropertyFlags properties, 
-                            vk::PhysicalDevice physicalDevice);
+    VulkanBuffer() = default;
+    VulkanBuffer(const VulkanBuffer&) = delete;
+    VulkanBuffer& operator=(const VulkanBuffer&) = delete;
+    VulkanBuffer(VulkanBuffer &&other) noexcept;
+    VulkanBuffer& operator=(VulkanBuffer &&other) noexcept;
+    ~VulkanBuffer();
+};
 
 VulkanBuffer createVulkanBuffer(vk::PhysicalDevice &physicalDevice,
                                 vk::Device &device,
                                 vk::DeviceSize size,
                                 vk::BufferUsageFlags usage,
-                                vk::MemoryPropertyFlags properties);
-void copyDataToVulkanBuffer(vk::Device &device, vk::DeviceMemory memory, 
+                                vk::MemoryPropertyFlags properties,
+                                VulkanMemoryTag tag = VulkanMemoryTag::General);
+void copyDataToVulkanBuffer(vk::Device &device, VulkanBuffer &dst, 
                             size_t bufferSize, void *hostData);
-void copyDataToVulkanBufferViaStaging(  vk::PhysicalDevice &physicalDevice,
-                                        vk::Device &device, 
-                                        vk::CommandPool &commandPool,
-                                        vk::Queue &graphicsQueue,
-                                        VulkanBuffer &dst, 
-                                        vk::DeviceSize size,
-                                        void *data);
 void copyBufferToVulkanBuffer(  vk::Device &device, vk::CommandPool &commandPool,
                                 vk::Queue &graphicsQueue,
                                 VulkanBuffer &src, VulkanBuffer &dst, vk::DeviceSize size);
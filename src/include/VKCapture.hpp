@@ -0,0 +1,84 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <vulkan/vulkan.hpp>
+#include "VKSetup.hpp"
+#include "VKUtility.hpp"
+#include "VKBuffer.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Frame capture
+// - The rendered image is copied into one of a few host-visible readback
+//   buffers by a small command buffer submitted right after the frame
+// - Once the frame's fence signals, worker threads write the PNG
+// - If every readback buffer is busy, the capture is dropped (never stalls)
+///////////////////////////////////////////////////////////////////////////////
+
+enum class VulkanCaptureState {
+    Free = 0,
+    Copying,                // GPU copy submitted with a frame
+    Encoding                // Worker thread is writing the file
+};
+
+struct VulkanCaptureSlot {
+    VulkanBuffer buffer;
+    vk::CommandBuffer commandBuffer;
+    atomic<VulkanCaptureState> state { VulkanCaptureState::Free };
+
+    unsigned int frameSlot = 0;     // Which frame in flight did the copy
+    string filename;
+    unsigned int width = 0;
+    unsigned int height = 0;
+    bool swapRedBlue = false;       // BGRA source
+};
+
+struct VulkanCaptureRing {
+    vk::CommandPool commandPool;    // Do NOT clean up here
+    vector<unique_ptr<VulkanCaptureSlot>> slots;
+
+    // Requests
+    string singleFilename;
+    string sequencePrefix;
+    unsigned int sequenceRemaining = 0;
+    unsigned int sequenceIndex = 0;
+
+    // Workers
+    vector<thread> workers;
+    mutex jobLock;
+    condition_variable jobReady;
+    deque<VulkanCaptureSlot*> jobs;
+    bool stopping = false;
+
+    atomic<unsigned int> savedCnt { 0 };
+    atomic<unsigned int> droppedCnt { 0 };
+};
+
+void createVulkanCaptureRing(   VulkanInitData &vkInitData,
+                                VulkanCaptureRing &ring,
+                                vk::CommandPool &commandPool,
+                                unsigned int slotCnt = 3,
+                                unsigned int workerCnt = 2);
+
+void requestVulkanCapture(VulkanCaptureRing &ring, string filename);
+void requestVulkanCaptureSequence(VulkanCaptureRing &ring, string filenamePrefix, unsigned int frameCnt);
+bool isVulkanCaptureRequested(VulkanCaptureRing &ring);
+
+// Returns a command buffer to submit after the frame (or nullptr if nothing to capture)
+vk::CommandBuffer recordVulkanCapture(  VulkanInitData &vkInitData,
+                                        VulkanCaptureRing &ring,
+                                        unsigned int frameSlot,
+                                        unsigned int imageIndex);
+
+// Call once the fence for frameSlot has signaled
+void completeVulkanCaptures(VulkanCaptureRing &ring, unsigned int frameSlot);
+
+// Device must be idle; waits for all files to be written
+void cleanupVulkanCaptureRing(VulkanInitData &vkInitData, VulkanCaptureRing &ring);
@@ -0,0 +1,66 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <vulkan/vulkan.hpp>
+#include "VKSetup.hpp"
+#include "VKUtility.hpp"
+#include "VKBuffer.hpp"
+#include "VKMesh.hpp"
+#include "VKDeletion.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Mesh compaction
+// - Moves live mesh buffers out of sparsely used memory blocks into fuller
+//   ones with GPU copies, so empty blocks can go back to the driver
+// - Runs a little each frame (at most bytesPerFrame copied per update; big
+//   buffers are copied in pieces over several updates)
+// - Registered VulkanBuffer references are patched once a copy's fence
+//   signals; the old buffer is freed after the frames in flight drain
+// - Registered buffers must stay at the same address until unregistered
+///////////////////////////////////////////////////////////////////////////////
+
+struct VulkanCompactionMove {
+    vk::Buffer oldBuffer;               // Still owned by the registered VulkanBuffer
+    VulkanBuffer newBuffer;
+    vk::DeviceSize copiedBytes = 0;     // Recorded so far
+};
+
+struct VulkanCompactionBatch {
+    vk::CommandBuffer commandBuffer;
+    vk::Fence fence;
+    vector<VulkanCompactionMove> moves; // Fully copied once the fence signals
+};
+
+struct VulkanMeshCompactor {
+    vk::CommandPool commandPool;
+    VulkanQueue queue;
+
+    vk::DeviceSize bytesPerFrame = 4ull * 1024ull * 1024ull;
+    float maxOccupancy = 0.5f;          // Only empty blocks used less than this
+
+    vector<VulkanBuffer*> references;   // Every registered buffer
+    vector<VulkanCompactionMove> copying;   // Started, but not fully copied yet
+    deque<VulkanCompactionBatch> inFlight;
+    VulkanDeletionQueue retired;        // Old buffers wait here for frames in flight
+
+    vk::DeviceSize totalBytesMoved = 0;
+    unsigned int totalMoves = 0;
+};
+
+VulkanMeshCompactor createVulkanMeshCompactor(  VulkanInitData &vkInitData,
+                                                vk::DeviceSize bytesPerFrame,
+                                                unsigned int framesInFlight = 2);
+
+void registerVulkanMeshForCompaction(VulkanMeshCompactor &compactor, VulkanMesh &mesh);
+void registerVulkanMeshBuffersForCompaction(VulkanMeshCompactor &compactor, VulkanMeshBuffers &buffers);
+void unregisterVulkanMeshFromCompaction(VulkanInitData &vkInitData, VulkanMeshCompactor &compactor, VulkanMesh &mesh);
+void unregisterVulkanMeshBuffersFromCompaction( VulkanInitData &vkInitData, 
+                                                VulkanMeshCompactor &compactor, 
+                                                VulkanMeshBuffers &buffers);
+
+// Call once per frame (after the frame fence wait)
+void updateVulkanMeshCompactor(VulkanInitData &vkInitData, VulkanMeshCompactor &compactor);
+
+void cleanupVulkanMeshCompactor(VulkanInitData &vkInitData, VulkanMeshCompactor &compactor);
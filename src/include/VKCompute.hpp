@@ -0,0 +1,68 @@
+#pragma once
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "VKSetup.hpp"
+#include "VKUtility.hpp"
+#include "VKBuffer.hpp"
+#include "VKStaging.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Compute basics
+// - Storage buffers (SSBOs) on top of createVulkanBuffer()
+// - Compute pipelines from .comp SPIR-V
+// - Buffer barriers between compute, transfer, and draw stages
+// - The render engine records compute work in recordComputeCommands(),
+//   which is submitted before the frame's drawing (see VKRender.hpp)
+///////////////////////////////////////////////////////////////////////////////
+
+struct VulkanComputePipelineData {
+    vk::PipelineLayout pipelineLayout;
+    vk::Pipeline pipeline;
+};
+
+// Device-local by default; pass eHostVisible | eHostCoherent to write it directly
+// (the allocation is then mapped; see VulkanBuffer::allocation.mapped)
+VulkanBuffer createVulkanStorageBuffer( vk::PhysicalDevice &physicalDevice,
+                                        vk::Device &device,
+                                        vk::DeviceSize size,
+                                        vk::BufferUsageFlags extraUsage = {},
+                                        vk::MemoryPropertyFlags properties = vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+// Device-local storage buffer filled through the staging ring
+// (NOT usable until the batch is submitted and complete)
+VulkanBuffer queueVulkanStorageBufferUpload(VulkanUploadBatch &batch,
+                                            vk::DeviceSize size,
+                                            const void *data,
+                                            vk::BufferUsageFlags extraUsage = {});
+
+vk::Pipeline createVulkanComputePipeline(   vk::Device &device,
+                                            const vector<char> &compShaderCode,
+                                            vk::PipelineLayout &pipelineLayout,
+                                            vk::PipelineCache cache = nullptr);
+
+// Layout and pipeline together
+VulkanComputePipelineData createVulkanComputePipelineData(  vk::Device &device,
+                                                            string compSPVFilename,
+                                                            const vector<vk::DescriptorSetLayout> &descriptorSetLayouts,
+                                                            const vector<vk::PushConstantRange> &pushConstantRanges = {},
+                                                            vk::PipelineCache cache = nullptr);
+void cleanupVulkanComputePipelineData(vk::Device &device, VulkanComputePipelineData &data);
+
+// Number of groups needed to cover itemCnt items
+uint32_t getVulkanDispatchGroupCnt(uint32_t itemCnt, uint32_t groupSize);
+
+// Binds the pipeline and sets (starting at set 0) and dispatches
+void recordVulkanDispatch(  vk::CommandBuffer &commandBuffer,
+                            VulkanComputePipelineData &data,
+                            const vector<vk::DescriptorSet> &descriptorSets,
+                            uint32_t groupCntX, uint32_t groupCntY = 1, uint32_t groupCntZ = 1);
+
+// Makes ALL compute shader writes visible to later draws
+// (indirect commands, index/vertex input, and any shader reads)
+void recordVulkanComputeToGraphicsBarrier(vk::CommandBuffer &commandBuffer);
+
+void recordVulkanBufferBarrier( vk::CommandBuffer &commandBuffer, vk::Buffer buffer,
+                                vk::PipelineStageFlags srcStage, vk::AccessFlags srcAccess,
+                                vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess);
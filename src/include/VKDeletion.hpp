@@ -0,0 +1,34 @@
+#pragma once
+#include <deque>
+#include <functional>
+#include <vulkan/vulkan.hpp>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Resource deleters
+// - Owning types (VulkanBuffer, VulkanImage) destroy themselves when they go
+//   out of scope, using the deleter they were created with
+// - With a deletion queue, destruction waits until frames that may still
+//   use the resource are done (instead of happening immediately)
+///////////////////////////////////////////////////////////////////////////////
+
+struct VulkanDeletion {
+    uint64_t frame = 0;             // Destroy once the queue reaches this frame
+    function<void()> destroy;
+};
+
+struct VulkanDeletionQueue {
+    deque<VulkanDeletion> pending;
+    uint64_t frameCnt = 0;
+    unsigned int framesToWait = 2;  // Usually the number of frames in flight
+};
+
+struct VulkanDeleter {
+    vk::Device device;
+    VulkanDeletionQueue *deletionQueue = nullptr;   // nullptr means destroy immediately
+};
+
+void deferVulkanDeletion(VulkanDeletionQueue &queue, function<void()> destroy);
+void updateVulkanDeletionQueue(VulkanDeletionQueue &queue);    // Once per frame (after fence wait)
+void flushVulkanDeletionQueue(VulkanDeletionQueue &queue);     // Device must be idle
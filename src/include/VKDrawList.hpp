@@ -0,0 +1,185 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include "VKSetup.hpp"
+#include "VKMesh.hpp"
+#include "VKUniform.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Draw lists
+// - Gather one packet per draw (pipeline, descriptor set, buffers, push data)
+// - Each packet gets a 64-bit sort key; sortVulkanDrawList() radix sorts them
+//   - Opaque:      [layer | pipeline | descriptor set | buffers | depth]
+//                  (state changes grouped, then front to back)
+//   - Translucent: [layer | inverted depth | pipeline | descriptor set | buffers]
+//                  (back to front)
+// - Record with a VulkanCommandEncoder, which skips binds that match the
+//   state already set in the command buffer
+// - Opaque draws added with addVulkanDrawInstance() that share ALL their state
+//   (pipeline, descriptors, buffers, index range) become ONE instanced draw;
+//   writeVulkanDrawListInstances() streams their per-instance data
+///////////////////////////////////////////////////////////////////////////////
+
+enum class VulkanDrawLayer : uint32_t {
+    Opaque = 0,
+    Translucent = 1
+};
+
+const unsigned int VULKAN_DRAW_MAX_DYNAMIC_OFFSETS = 4;
+
+struct VulkanDrawPacket {
+    vk::Pipeline pipeline;
+    vk::PipelineLayout pipelineLayout;
+
+    // Set 0 (left null to keep whatever is bound)
+    vk::DescriptorSet descriptorSet;
+    array<uint32_t, VULKAN_DRAW_MAX_DYNAMIC_OFFSETS> dynamicOffsets {};
+    uint32_t dynamicOffsetCnt = 0;
+
+    vk::Buffer vertexBuffer;
+    vk::Buffer indexBuffer;
+    vk::IndexType indexType = vk::IndexType::eUint32;
+    uint32_t indexCnt = 0;
+    uint32_t firstIndex = 0;
+    int32_t vertexOffset = 0;
+
+    vk::ShaderStageFlags pushStages;
+    uint32_t pushOffset = 0;            // Into VulkanDrawList::pushData
+    uint32_t pushSize = 0;
+
+    // Per-instance vertex data (set by writeVulkanDrawListInstances())
+    uint32_t instanceBinding = 1;
+    vk::Buffer instanceBuffer;
+    vk::DeviceSize instanceBufferOffset = 0;
+    uint32_t instanceCnt = 1;
+    uint32_t firstInstance = 0;
+};
+
+struct VulkanDrawList {
+    vector<VulkanDrawPacket> packets;
+    vector<uint64_t> keys;              // One per packet
+    vector<uint32_t> order;             // Packet indices in draw order
+    vector<uint8_t> pushData;           // Push constant bytes of all packets
+
+    // Radix sort scratch
+    vector<uint64_t> keyScratch;
+    vector<uint32_t> orderScratch;
+
+    // Small ids for the state handles used in the keys (rebuilt every list)
+    unordered_map<uint64_t, uint32_t> pipelineIds;
+    unordered_map<uint64_t, uint32_t> descriptorIds;
+    unordered_map<uint64_t, uint32_t> bufferIds;
+
+    // Instanced draws
+    uint32_t instanceStride = 0;
+    vector<uint8_t> instanceData;       // Bytes of every instance, in the order added
+    vector<uint32_t> instancePackets;   // Packet each instance belongs to
+    vector<float> packetDepths;         // Nearest depth of each packet (for its key)
+    vector<uint32_t> instancedPackets;  // Packets made by addVulkanDrawInstance()
+    unordered_map<uint64_t, uint32_t> instanceBatches;  // Draw state hash -> packet
+    vector<uint32_t> instanceCursors;   // Scratch for writing instances out
+};
+
+// Clears the list (keeps its memory)
+void beginVulkanDrawList(VulkanDrawList &list);
+
+// Fills the buffer/range fields of a packet for a merged or standalone mesh
+// lod indexes VulkanMesh::lods (0 = full mesh)
+void setVulkanDrawPacketMesh(VulkanDrawPacket &packet, VulkanMeshBuffers &buffers, VulkanMesh &mesh, 
+                                unsigned int lod = 0);
+void setVulkanDrawPacketMesh(VulkanDrawPacket &packet, VulkanMesh &mesh, unsigned int lod = 0);
+
+// viewDepth is the distance in front of the camera (negative values clamp to 0)
+void addVulkanDrawPacket(   VulkanDrawList &list, 
+                            VulkanDrawPacket packet,
+                            const void *pushData, uint32_t pushSize,
+                            float viewDepth, 
+                            VulkanDrawLayer layer = VulkanDrawLayer::Opaque);
+
+template<typename T>
+void addVulkanDrawPacket(   VulkanDrawList &list, 
+                            const VulkanDrawPacket &packet,
+                            const T &pushData,
+                            float viewDepth, 
+                            VulkanDrawLayer layer = VulkanDrawLayer::Opaque) {
+    addVulkanDrawPacket(list, packet, &pushData, sizeof(T), viewDepth, layer);
+}
+
+// One instance of packet (which should have no push data); instanceSize must
+// be the same for every instance in the list
+void addVulkanDrawInstance( VulkanDrawList &list, 
+                            const VulkanDrawPacket &packet,
+                            const void *instanceData, uint32_t instanceSize,
+                            float viewDepth, 
+                            VulkanDrawLayer layer = VulkanDrawLayer::Opaque);
+
+template<typename T>
+void addVulkanDrawInstance( VulkanDrawList &list, 
+                            const VulkanDrawPacket &packet,
+                            const T &instanceData,
+                            float viewDepth, 
+                            VulkanDrawLayer layer = VulkanDrawLayer::Opaque) {
+    addVulkanDrawInstance(list, packet, &instanceData, sizeof(T), viewDepth, layer);
+}
+
+// Copies all instances (grouped by packet) into this frame's region of allocator
+// (created with eVertexBuffer usage) and points the instanced packets at them
+void writeVulkanDrawListInstances(VulkanDrawList &list, VulkanFrameUniformAllocator &allocator);
+
+void sortVulkanDrawList(VulkanDrawList &list);
+
+///////////////////////////////////////////////////////////////////////////////
+// Command encoder
+// - Remembers the state it has bound and drops binds that would not change it
+// - Anything recorded directly on the command buffer in between is NOT seen;
+//   call beginVulkanCommandEncoder() again afterwards
+///////////////////////////////////////////////////////////////////////////////
+
+struct VulkanCommandEncoder {
+    vk::CommandBuffer commandBuffer;
+
+    vk::Pipeline pipeline;
+    vk::PipelineLayout pipelineLayout;  // Layout descriptor sets/push data were set with
+    vk::DescriptorSet descriptorSet;
+    array<uint32_t, VULKAN_DRAW_MAX_DYNAMIC_OFFSETS> dynamicOffsets {};
+    uint32_t dynamicOffsetCnt = 0;
+    vk::Buffer vertexBuffer;
+    vk::Buffer indexBuffer;
+    vk::IndexType indexType = vk::IndexType::eUint32;
+    vk::Buffer instanceBuffer;
+    vk::DeviceSize instanceBufferOffset = 0;
+    vk::ShaderStageFlags pushStages;
+    vector<uint8_t> pushData;
+
+    // Stats since begin
+    unsigned int drawCnt = 0;
+    unsigned int instanceCnt = 0;
+    unsigned int bindCnt = 0;           // Pipeline, descriptor, buffer and push commands issued
+    unsigned int skippedBindCnt = 0;    // ...and the ones dropped as redundant
+};
+
+void beginVulkanCommandEncoder(VulkanCommandEncoder &encoder, vk::CommandBuffer commandBuffer);
+void encodeVulkanBindPipeline(VulkanCommandEncoder &encoder, vk::Pipeline pipeline);
+void encodeVulkanBindDescriptorSet( VulkanCommandEncoder &encoder, 
+                                    vk::PipelineLayout pipelineLayout,
+                                    vk::DescriptorSet descriptorSet,
+                                    const uint32_t *dynamicOffsets, uint32_t dynamicOffsetCnt);
+void encodeVulkanBindBuffers(   VulkanCommandEncoder &encoder, 
+                                vk::Buffer vertexBuffer, vk::Buffer indexBuffer, 
+                                vk::IndexType indexType);
+void encodeVulkanBindInstanceBuffer(   VulkanCommandEncoder &encoder, uint32_t binding,
+                                        vk::Buffer instanceBuffer, vk::DeviceSize offset);
+void encodeVulkanPushConstants( VulkanCommandEncoder &encoder,
+                                vk::PipelineLayout pipelineLayout,
+                                vk::ShaderStageFlags stages,
+                                const void *data, uint32_t size);
+void encodeVulkanDrawIndexed(   VulkanCommandEncoder &encoder, 
+                                uint32_t indexCnt, uint32_t firstIndex, int32_t vertexOffset,
+                                uint32_t instanceCnt=1, uint32_t firstInstance=0);
+
+// Records every packet in sorted order
+void recordVulkanDrawList(VulkanCommandEncoder &encoder, VulkanDrawList &list);
@@ -0,0 +1,130 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <vulkan/vulkan.hpp>
+#include "VKSetup.hpp"
+#include "VKBuffer.hpp"
+#include "VKCompute.hpp"
+#include "VKMesh.hpp"
+#include "Frustum.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// GPU-driven culling and drawing
+// - Objects (transform + mesh) live in a storage buffer, rewritten only when
+//   setVulkanGPUCullObjects() is called
+// - A compute shader tests every object against the frustum, writes its
+//   instance data (modelMat, normMat) at the object's index, and writes a
+//   VkDrawIndexedIndirectCommand for every survivor (firstInstance = object)
+// - With VK_KHR_draw_indirect_count the survivors are compacted and drawn
+//   with ONE drawIndexedIndirectCount; otherwise every object keeps its slot
+//   (instanceCount 0 when culled) and is drawn with ONE drawIndexedIndirect
+// - Survivors also pick a LOD from their projected size, the same way
+//   selectVulkanMeshLOD() does (up to VULKAN_GPU_CULL_MAX_LODS levels)
+// - Needs multiDrawIndirect/drawIndirectFirstInstance (isVulkanGPUCullingSupported())
+///////////////////////////////////////////////////////////////////////////////
+
+const unsigned int VULKAN_GPU_CULL_MAX_LODS = 4;
+
+// std430 layouts (must match the compute shader)
+struct VulkanGPUCullMesh {
+    uint32_t lodCnt = 1;
+    int32_t vertexOffset = 0;
+    uint32_t pad[2] = {0, 0};
+    glm::vec4 sphere;               // Object-space center (xyz) and radius (w)
+    uint32_t indexCnt[VULKAN_GPU_CULL_MAX_LODS] = {0, 0, 0, 0};
+    uint32_t firstIndex[VULKAN_GPU_CULL_MAX_LODS] = {0, 0, 0, 0};
+    glm::vec4 dequantOffset = glm::vec4(0.0f);  // Quantized vertices (see VertexDequantize)
+    glm::vec4 dequantScale = glm::vec4(1.0f);
+};
+
+struct VulkanGPUCullObject {
+    glm::mat4 worldMat;
+    glm::mat4 normalWorldMat;       // Upper 3x3 is used
+    uint32_t meshIndex = 0;
+    uint32_t pad[3] = {0, 0, 0};
+};
+
+// std140 uniform block
+struct VulkanGPUCullParams {
+    glm::mat4 localRotMat;          // Applied to every object about its own position
+    glm::mat4 normalRotMat;         // Applied to every normal matrix (e.g., view * rotation)
+    glm::vec4 planes[6];
+    uint32_t objectCnt = 0;
+    uint32_t compact = 0;
+    float lodScale = 0.0f;          // getSphereScreenScale(); 0 always draws LOD 0
+    float lodFullDetailPixels = 256.0f;
+    glm::vec4 viewDepthRow;         // dot(row, (p, 1)) is the view depth of p
+};
+
+struct VulkanGPUCullFrame {
+    VulkanBuffer objects;           // Host visible
+    uint64_t objectsVersion = 0;    // Which setVulkanGPUCullObjects() it holds
+    VulkanBuffer params;            // Host visible
+    VulkanBuffer instances;         // Written by compute, read as instance vertex data
+    VulkanBuffer draws;             // Written by compute, read as indirect commands
+    VulkanBuffer drawCount;
+    vk::DescriptorSet descriptorSet;
+};
+
+struct VulkanGPUCuller {
+    unsigned int maxObjects = 0;
+    unsigned int objectCnt = 0;
+    uint64_t objectsVersion = 0;
+    vector<VulkanGPUCullObject> hostObjects;
+
+    VulkanBuffer meshes;            // Host visible
+    unsigned int maxMeshes = 0;
+
+    vector<VulkanGPUCullFrame> frames;
+    vk::DescriptorSetLayout descriptorSetLayout;
+    vk::DescriptorPool descriptorPool;
+    VulkanComputePipelineData compute;  // NOT owned; see createVulkanGPUCuller()
+
+    bool useDrawCount = false;
+    PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount = nullptr;
+
+    float lodFullDetailPixels = 256.0f;
+};
+
+bool isVulkanGPUCullingSupported(VulkanInitData &vkInitData);
+
+// Does NOT build the cull pipeline: set culler.compute from culler.descriptorSetLayout
+// before the first recordVulkanGPUCull() (e.g., VulkanRenderEngine::createComputePipeline(),
+// which also destroys it)
+void createVulkanGPUCuller( VulkanInitData &vkInitData, 
+                            VulkanGPUCuller &culler,
+                            unsigned int maxObjects, 
+                            unsigned int maxMeshes,
+                            unsigned int frameCnt);
+
+// Meshes are indexed by VulkanGPUCullObject::meshIndex
+// (call before the first recordVulkanGPUCull(), or after the device is idle);
+// with quantized vertices, dequants are folded into each instance's modelMat
+void setVulkanGPUCullMeshes(VulkanGPUCuller &culler, 
+                            vector<VulkanMesh> &meshes, 
+                            const vector<MeshBounds> &bounds,
+                            const vector<VertexDequantize> &dequants = {});
+
+// Each frame slot picks these up the next time it is recorded
+void setVulkanGPUCullObjects(VulkanGPUCuller &culler, const vector<VulkanGPUCullObject> &objects);
+
+// Record OUTSIDE a render pass (e.g., in VulkanRenderEngine::recordComputeCommands())
+void recordVulkanGPUCull(   VulkanGPUCuller &culler, 
+                            vk::CommandBuffer &commandBuffer, 
+                            unsigned int frameIndex,
+                            const Frustum &frustum,
+                            const glm::mat4 &localRotMat,
+                            const glm::mat4 &normalRotMat,
+                            const glm::mat4 &viewMat = glm::mat4(1.0f),
+                            float lodScale = 0.0f);
+
+// Record inside the render pass, with the graphics pipeline, descriptor sets,
+// and mesh buffers already bound
+void recordVulkanGPUDraws(  VulkanGPUCuller &culler, 
+                            vk::CommandBuffer &commandBuffer, 
+                            unsigned int frameIndex,
+                            uint32_t instanceBinding);
+
+void cleanupVulkanGPUCuller(vk::Device &device, VulkanGPUCuller &culler);
@@ -3,22 +3,34 @@
 #include "VKUtility.hpp"
 #include "VKBuffer.hpp"
 
+// Move-only: destroyed by its deleter when it goes out of scope
+// (or earlier with cleanupVulkanImage())
 struct VulkanImage {
     vk::Image image;
-    vk::DeviceMemory memory;
+    VulkanAllocation allocation;    // Range inside a shared device memory block
     vk::ImageView view;
     vk::Format format;
+    VulkanDeleter deleter;
+
+    VulkanImage() = default;
+    VulkanImage(const VulkanImage&) = delete;
+    VulkanImage& operator=(const VulkanImage&) = delete;
+    VulkanImage(VulkanImage &&other) noexcept;
+    VulkanImage& operator=(VulkanImage &&other) noexcept;
+    ~VulkanImage();
 };
 
 VulkanImage createVulkanImage( VulkanInitData &vkInitData, int width, int height, 
                                 vk::Format format, vk::ImageUsageFlags usage,
-                                vk::ImageAspectFlags aspectFlags);
+                                vk::ImageAspectFlags aspectFlags,
+                                VulkanMemoryTag tag = VulkanMemoryTag::General);
 VulkanImage createVulkanImage(  
     vk::Device &device, 
     vk::PhysicalDevice &phyDevice,
     int width, int height, 
     vk::Format format, vk::ImageUsageFlags usage,
-    vk::ImageAspectFlags aspectFlags);
+    vk::ImageAspectFlags aspectFlags,
+    VulkanMemoryTag tag = VulkanMemoryTag::General);
 
 VulkanImage createVulkanDepthImage(
     VulkanInitData &vkInitData, 
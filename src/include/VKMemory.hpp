@@ -0,0 +1,113 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <vulkan/vulkan.hpp>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Device memory sub-allocation
+// - Large vk::DeviceMemory blocks are allocated per memory type
+// - Buffers and images get a (block, offset) range out of a block
+// - Host-visible blocks stay mapped for their whole lifetime
+///////////////////////////////////////////////////////////////////////////////
+
+struct VulkanMemoryBlock;
+
+// What an allocation is used for (telemetry only)
+enum class VulkanMemoryTag {
+    General = 0,
+    Mesh,
+    Uniform,
+    Depth,
+    Staging,
+    Texture,
+    Storage,
+    Count
+};
+
+const char* getVulkanMemoryTagName(VulkanMemoryTag tag);
+
+struct VulkanAllocation {
+    vk::DeviceMemory memory;                // Block memory (do NOT free directly!)
+    vk::DeviceSize offset = 0;              // Offset of this allocation in the block
+    vk::DeviceSize size = 0;                // Size requested by the resource
+    vk::DeviceSize padding = 0;             // Bytes skipped before offset for alignment
+    unsigned int memoryTypeIndex = 0;
+    void *mapped = nullptr;                 // Host pointer (host-visible memory only)
+    VulkanMemoryBlock *block = nullptr;     // Owning block (allocation handle)
+    VulkanMemoryTag tag = VulkanMemoryTag::General;
+};
+
+struct VulkanMemoryRange {
+    vk::DeviceSize offset = 0;
+    vk::DeviceSize size = 0;
+};
+
+struct VulkanMemoryBlock {
+    vk::DeviceMemory memory;
+    vk::DeviceSize size = 0;
+    unsigned int memoryTypeIndex = 0;
+    bool isImage = false;                   // Holds optimal-tiling images (not linear resources)
+    bool dedicated = false;                 // Holds exactly one large resource
+    void *mapped = nullptr;
+
+    vector<VulkanMemoryRange> freeRanges;   // Sorted by offset, never adjacent
+    vk::DeviceSize bytesUsed = 0;           // Includes alignment padding
+    vk::DeviceSize bytesWasted = 0;         // Alignment padding only
+    unsigned int allocationCount = 0;
+};
+
+struct VulkanMemoryStats {
+    unsigned int blockCount = 0;
+    unsigned int dedicatedBlockCount = 0;
+    unsigned int allocationCount = 0;
+    vk::DeviceSize bytesAllocated = 0;      // Total size of all device memory blocks
+    vk::DeviceSize bytesUsed = 0;           // Bytes handed out to resources
+    vk::DeviceSize bytesWasted = 0;         // Bytes lost to alignment padding
+    vk::DeviceSize bytesFree = 0;           // Bytes still available in blocks
+};
+
+struct VulkanMemoryAllocator {
+    vk::Device device;
+    vk::PhysicalDevice physicalDevice;
+    vk::PhysicalDeviceMemoryProperties memProperties;
+    vk::DeviceSize bufferImageGranularity = 1;
+
+    vector<unique_ptr<VulkanMemoryBlock>> blocks;
+    mutex allocLock;
+
+    // Telemetry
+    bool hasMemoryBudget = false;           // VK_EXT_memory_budget enabled on device
+    vk::DeviceSize tagBytes[(int)VulkanMemoryTag::Count] = {};
+    unsigned int tagCounts[(int)VulkanMemoryTag::Count] = {};
+};
+
+unsigned int findMemoryType(unsigned int typeFilter,
+                            vk::MemoryPropertyFlags properties,
+                            vk::PhysicalDevice physicalDevice);
+
+VulkanMemoryAllocator& getVulkanMemoryAllocator(vk::PhysicalDevice &physicalDevice, vk::Device &device);
+VulkanMemoryAllocator* findVulkanMemoryAllocator(vk::Device &device);   // nullptr if none yet
+
+VulkanAllocation allocateVulkanMemory(  vk::PhysicalDevice &physicalDevice,
+                                        vk::Device &device,
+                                        vk::MemoryRequirements memRequirements,
+                                        vk::MemoryPropertyFlags properties,
+                                        bool isImage,
+                                        VulkanMemoryTag tag = VulkanMemoryTag::General);
+void freeVulkanMemory(vk::Device &device, VulkanAllocation &allocation);
+
+// For compaction: only succeeds in an EXISTING block that is fuller than source's block
+bool allocateVulkanMemoryInDenserBlock( vk::Device &device,
+                                        vk::MemoryRequirements memRequirements,
+                                        VulkanAllocation &source,
+                                        VulkanAllocation &allocation);
+float getVulkanMemoryBlockOccupancy(VulkanMemoryBlock *block);
+
+VulkanMemoryStats getVulkanMemoryStats(vk::Device &device);
+void printVulkanMemoryStats(vk::Device &device);
+
+void cleanupVulkanMemoryAllocator(vk::Device &device);
@@ -0,0 +1,69 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "VKUtility.hpp"
+#include "VKMemory.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Memory telemetry
+// - Snapshot of what the allocator holds, by heap, memory type, and tag
+// - Heap budget/usage come from VK_EXT_memory_budget when it is enabled
+//   (otherwise the heap size and our own block totals are reported)
+// - A telemetry log dumps snapshots to the console and/or a CSV file
+///////////////////////////////////////////////////////////////////////////////
+
+struct VulkanHeapTelemetry {
+    unsigned int heapIndex = 0;
+    bool deviceLocal = false;
+    vk::DeviceSize heapSize = 0;
+    vk::DeviceSize bytesAllocated = 0;      // Our device memory blocks in this heap
+    vk::DeviceSize bytesUsed = 0;           // Bytes handed out to resources
+    vk::DeviceSize budget = 0;              // How much this process can use (estimate)
+    vk::DeviceSize usage = 0;               // How much this process is using (ALL allocations)
+};
+
+struct VulkanMemoryTypeTelemetry {
+    unsigned int typeIndex = 0;
+    unsigned int heapIndex = 0;
+    vk::MemoryPropertyFlags propertyFlags;
+    unsigned int blockCount = 0;
+    unsigned int allocationCount = 0;
+    vk::DeviceSize bytesAllocated = 0;
+    vk::DeviceSize bytesUsed = 0;
+};
+
+struct VulkanMemoryTelemetry {
+    bool hasBudget = false;
+    vector<VulkanHeapTelemetry> heaps;
+    vector<VulkanMemoryTypeTelemetry> types;    // Only types we have blocks in
+    vk::DeviceSize tagBytes[(int)VulkanMemoryTag::Count] = {};
+    unsigned int tagCounts[(int)VulkanMemoryTag::Count] = {};
+};
+
+struct VulkanMemoryTelemetryLog {
+    ofstream csv;
+    bool headerWritten = false;
+    float intervalSeconds = 1.0f;
+    float warnFraction = 0.9f;              // Warn when a heap passes this much of its budget
+    bool printToConsole = false;
+    chrono::steady_clock::time_point startTime;
+    chrono::steady_clock::time_point lastDumpTime;
+};
+
+VulkanMemoryTelemetry getVulkanMemoryTelemetry(vk::Device &device);
+bool isVulkanMemoryOverBudget(VulkanMemoryTelemetry &telemetry, float fraction = 0.9f);
+void printVulkanMemoryTelemetry(VulkanMemoryTelemetry &telemetry);
+void writeVulkanMemoryTelemetryCSV( ostream &out, VulkanMemoryTelemetry &telemetry,
+                                    float timeSeconds, bool writeHeader);
+
+bool openVulkanMemoryTelemetryLog(  VulkanMemoryTelemetryLog &log, 
+                                    string csvFilename,
+                                    float intervalSeconds = 1.0f,
+                                    bool printToConsole = false);
+void updateVulkanMemoryTelemetryLog(vk::Device &device, VulkanMemoryTelemetryLog &log);
+void closeVulkanMemoryTelemetryLog(VulkanMemoryTelemetryLog &log);
@@ -2,9 +2,11 @@
 #include <vector>
 #include <cstddef>
 #include "MeshData.hpp"
+#include "VertexQuantize.hpp"
 #include "VKBuffer.hpp"
 #include "VKSetup.hpp"
 #include "VKUtility.hpp"
+#include "VKStaging.hpp"
 
 ///////////////////////////////////////////////////////////////////////////////
 // Attribute layout/descriptions
@@ -13,56 +15,254 @@
 struct AttributeDescData {
     vk::VertexInputBindingDescription bindDesc;
     vector<vk::VertexInputAttributeDescription> attribDesc;
+
+    // Extra bindings (usually eInstance rate, stepping once per instance)
+    vector<vk::VertexInputBindingDescription> instanceBindDesc;
 };
 
+// Adds a per-instance binding (eInstance rate)
+void addVulkanInstanceBinding(AttributeDescData &attribDescData, uint32_t binding, uint32_t stride);
+
+// A mat4 takes 4 consecutive locations (one vec4 column each)
+void addVulkanMat4Attribute(AttributeDescData &attribDescData, 
+                            uint32_t binding, uint32_t location, uint32_t offset);
+
+// Sets the vertex binding to QuantizedVertex: position reads as vec3 in [0,1],
+// color as vec4, normal as the octahedron-encoded vec2 (decode in the shader)
+void setVulkanQuantizedVertexAttributes(AttributeDescData &attribDescData, 
+                                        uint32_t posLocation, uint32_t colorLocation, 
+                                        uint32_t normalLocation);
+
 ///////////////////////////////////////////////////////////////////////////////
 // Vulkan mesh data
 ///////////////////////////////////////////////////////////////////////////////
 
+// Index range of one level of detail (same vertices as the full mesh)
+struct VulkanMeshLOD {
+    unsigned int firstIndex = 0;
+    int indexCnt = 0;
+    float error = 0.0f;             // From MeshLOD::error (model units)
+};
+
+// Move-only (owns its buffers; merged meshes leave them empty)
 struct VulkanMesh {
     VulkanBuffer vertices;
     VulkanBuffer indices;
     int indexCnt = 0;
+    unsigned int firstIndex = 0;    // Start of this mesh in the index buffer
+    int vertexOffset = 0;           // Added to every index of this mesh
+    vector<VulkanMeshLOD> lods;     // lods[0] is the full mesh; coarser levels follow
+    vk::IndexType indexType = vk::IndexType::eUint32;
 };
 
+// 16-bit indices for meshes under 65536 vertices (0xFFFF stays free for primitive
+// restart); vertexOffset is added by the draw, so merged meshes only check each mesh
+vk::IndexType getVulkanIndexType(size_t vertexCnt);
+vk::DeviceSize getVulkanIndexSize(vk::IndexType indexType);
+
+// Narrows to indexType on the way into the staging ring (firstIndex is in indices, not bytes)
+void queueVulkanIndexUpload(VulkanUploadBatch &batch, VulkanBuffer &indices, vk::IndexType indexType,
+                            unsigned int firstIndex, const vector<unsigned int> &hostIndices);
+
+// Index count of the mesh plus all of its LODs
 template<typename T>
-VulkanMesh createVulkanMesh(VulkanInitData &vkInitData, 
-                            vk::CommandPool &commandPool, 
-                            Mesh<T> &hostMesh) {
+size_t getMeshIndexCntWithLODs(Mesh<T> &hostMesh) {
+    size_t cnt = hostMesh.indices.size();
+    for(auto &lod : hostMesh.lods) {
+        cnt += lod.indices.size();
+    }
+    return cnt;
+}
+
+// Places LODs right after the mesh's own indices (starting at firstIndex)
+template<typename T>
+vector<VulkanMeshLOD> getVulkanMeshLODRanges(Mesh<T> &hostMesh, unsigned int firstIndex) {
+    vector<VulkanMeshLOD> lods;
+    lods.push_back({firstIndex, (int)hostMesh.indices.size(), 0.0f});
+
+    unsigned int next = firstIndex + (unsigned int)hostMesh.indices.size();
+    for(auto &lod : hostMesh.lods) {
+        lods.push_back({next, (int)lod.indices.size(), lod.error});
+        next += (unsigned int)lod.indices.size();
+    }
+    return lods;
+}
+
+// Copies the LOD index lists after the mesh's own indices (starting at firstIndex)
+template<typename T>
+void queueVulkanMeshLODUpload(VulkanUploadBatch &batch, Mesh<T> &hostMesh, 
+                                VulkanBuffer &indices, vk::IndexType indexType, unsigned int firstIndex) {
+    vector<VulkanMeshLOD> lods = getVulkanMeshLODRanges(hostMesh, firstIndex);
+    for(unsigned int i = 0; i < hostMesh.lods.size(); i++) {
+        queueVulkanIndexUpload(batch, indices, indexType, lods[i + 1].firstIndex, hostMesh.lods[i].indices);
+    }
+}
+
+// Buffers shared by ALL meshes of a merged scene (move-only)
+struct VulkanMeshBuffers {
+    VulkanBuffer vertices;
+    VulkanBuffer indices;
+    vk::IndexType indexType = vk::IndexType::eUint32;
+};
+
+template<typename T>
+VulkanMesh queueVulkanMeshUpload(VulkanUploadBatch &batch, Mesh<T> &hostMesh) {
     // Set up Vulkan mesh                            
     VulkanMesh mesh;
+    VulkanInitData &vkInitData = *batch.vkInitData;
 
     // Create vertex buffer (note eTransferDst flag and eDeviceLocal)
     vk::DeviceSize vertBufferSize = sizeof(hostMesh.vertices[0]) * hostMesh.vertices.size();    
     mesh.vertices = createVulkanBuffer(
         vkInitData.physicalDevice, vkInitData.device, vertBufferSize,
-        vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst, 
-        vk::MemoryPropertyFlagBits::eDeviceLocal);
+        vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst
+        | vk::BufferUsageFlagBits::eTransferSrc, 
+        vk::MemoryPropertyFlagBits::eDeviceLocal, VulkanMemoryTag::Mesh);
 
-    // Copy to buffer via staging buffer
-    copyDataToVulkanBufferViaStaging(vkInitData.physicalDevice, vkInitData.device,
-                                     commandPool, vkInitData.graphicsQueue.queue, 
-                                     mesh.vertices, vertBufferSize, hostMesh.vertices.data());
+    // Write into staging ring (host data can be freed after this)
+    queueVulkanBufferUpload(batch, mesh.vertices, 0, vertBufferSize, hostMesh.vertices.data());
 
-    // Create index buffer
-    vk::DeviceSize indexBufferSize = sizeof(hostMesh.indices[0]) * hostMesh.indices.size();
+    // Create index buffer (LODs follow the full mesh)
+    mesh.indexType = getVulkanIndexType(hostMesh.vertices.size());
+    vk::DeviceSize indexBufferSize = getVulkanIndexSize(mesh.indexType) * getMeshIndexCntWithLODs(hostMesh);
     mesh.indices = createVulkanBuffer(
         vkInitData.physicalDevice, vkInitData.device, indexBufferSize,
-        vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst, 
-        vk::MemoryPropertyFlagBits::eDeviceLocal);
+        vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst
+        | vk::BufferUsageFlagBits::eTransferSrc, 
+        vk::MemoryPropertyFlagBits::eDeviceLocal, VulkanMemoryTag::Mesh);
 
-    // Copy to buffer via staging buffer    
-    copyDataToVulkanBufferViaStaging(vkInitData.physicalDevice, vkInitData.device,
-                                     commandPool, vkInitData.graphicsQueue.queue, 
-                                     mesh.indices, indexBufferSize, hostMesh.indices.data());
+    // Write into staging ring
+    queueVulkanIndexUpload(batch, mesh.indices, mesh.indexType, 0, hostMesh.indices);
+    queueVulkanMeshLODUpload(batch, hostMesh, mesh.indices, mesh.indexType, 0);
 
     // Set index count
     mesh.indexCnt = hostMesh.indices.size();
+    mesh.lods = getVulkanMeshLODRanges(hostMesh, 0);
+
+    // Return mesh (NOT usable until the batch is submitted and complete)
+    return mesh;
+}
+
+template<typename T>
+VulkanMesh createVulkanMesh(VulkanInitData &vkInitData, 
+                            VulkanStagingRing &stagingRing, 
+                            Mesh<T> &hostMesh) {
+    // Upload as a batch of one and wait for it
+    VulkanUploadBatch batch = beginVulkanUploadBatch(vkInitData, stagingRing);
+    VulkanMesh mesh = queueVulkanMeshUpload(batch, hostMesh);
+    VulkanUploadToken token = submitVulkanUploadBatch(batch);
+    waitForVulkanUpload(vkInitData.device, token);
 
     // Return mesh
     return mesh;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Merged meshes
+// - Packs a whole scene into ONE vertex buffer and ONE index buffer
+// - Each returned VulkanMesh is a (firstIndex, vertexOffset, indexCnt) range
+//   with NO buffers of its own; bind the shared buffers once for all draws
+///////////////////////////////////////////////////////////////////////////////
+
+// Where every mesh goes in the shared buffers (anything that stores merged data,
+// like the mesh cache, must place it with this too)
+struct VulkanMergedMeshLayout {
+    vk::IndexType indexType = vk::IndexType::eUint32;
+    vector<VulkanMesh> meshes;      // Ranges only; each mesh's LODs follow its indices
+    size_t vertexCnt = 0;
+    size_t indexCnt = 0;            // LODs included
+};
+
+template<typename T>
+VulkanMergedMeshLayout getVulkanMergedMeshLayout(vector<Mesh<T>> &hostMeshes) {
+    VulkanMergedMeshLayout layout;
+
+    // 16-bit indices if the largest mesh fits them
+    size_t maxVertices = 0;
+    for(auto &hostMesh : hostMeshes) {
+        maxVertices = std::max(maxVertices, hostMesh.vertices.size());
+    }
+    layout.indexType = getVulkanIndexType(maxVertices);
+
+    for(auto &hostMesh : hostMeshes) {
+        VulkanMesh mesh;
+        mesh.indexCnt = hostMesh.indices.size();
+        mesh.firstIndex = static_cast<unsigned int>(layout.indexCnt);
+        mesh.vertexOffset = static_cast<int>(layout.vertexCnt);
+        mesh.lods = getVulkanMeshLODRanges(hostMesh, mesh.firstIndex);
+        mesh.indexType = layout.indexType;
+        layout.meshes.push_back(std::move(mesh));
+
+        layout.vertexCnt += hostMesh.vertices.size();
+        layout.indexCnt += getMeshIndexCntWithLODs(hostMesh);
+    }
+    return layout;
+}
+
+template<typename T>
+vector<VulkanMesh> queueVulkanMergedMeshUpload( VulkanUploadBatch &batch, 
+                                                vector<Mesh<T>> &hostMeshes,
+                                                VulkanMeshBuffers &sharedBuffers) {
+    VulkanInitData &vkInitData = *batch.vkInitData;
+
+    // Work out where each mesh goes
+    VulkanMergedMeshLayout layout = getVulkanMergedMeshLayout(hostMeshes);
+    vector<VulkanMesh> allMeshes = std::move(layout.meshes);
+    size_t totalVertices = layout.vertexCnt;
+    size_t totalIndices = layout.indexCnt;
+    sharedBuffers.indexType = layout.indexType;
+
+    if(totalVertices == 0 || totalIndices == 0) {
+        return allMeshes;
+    }
+
+    // Create shared buffers
+    sharedBuffers.vertices = createVulkanBuffer(
+        vkInitData.physicalDevice, vkInitData.device, sizeof(T) * totalVertices,
+        vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst
+        | vk::BufferUsageFlagBits::eTransferSrc, 
+        vk::MemoryPropertyFlagBits::eDeviceLocal, VulkanMemoryTag::Mesh);
+
+    sharedBuffers.indices = createVulkanBuffer(
+        vkInitData.physicalDevice, vkInitData.device, getVulkanIndexSize(sharedBuffers.indexType) * totalIndices,
+        vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst
+        | vk::BufferUsageFlagBits::eTransferSrc, 
+        vk::MemoryPropertyFlagBits::eDeviceLocal, VulkanMemoryTag::Mesh);
+
+    // Stage each mesh into its range
+    for(unsigned int i = 0; i < hostMeshes.size(); i++) {
+        Mesh<T> &hostMesh = hostMeshes[i];
+        VulkanMesh &mesh = allMeshes[i];
+
+        if(!hostMesh.vertices.empty()) {
+            queueVulkanBufferUpload(batch, sharedBuffers.vertices, 
+                                    sizeof(T) * mesh.vertexOffset,
+                                    sizeof(T) * hostMesh.vertices.size(), 
+                                    hostMesh.vertices.data());
+        }
+        queueVulkanIndexUpload(batch, sharedBuffers.indices, sharedBuffers.indexType, 
+                                mesh.firstIndex, hostMesh.indices);
+        for(unsigned int k = 0; k < hostMesh.lods.size(); k++) {
+            queueVulkanIndexUpload( batch, sharedBuffers.indices, sharedBuffers.indexType, 
+                                    mesh.lods[k + 1].firstIndex, hostMesh.lods[k].indices);
+        }
+    }
+
+    return allMeshes;
+}
+
 void recordDrawVulkanMesh(vk::CommandBuffer &commandBuffer, VulkanMesh &mesh);
+void recordBindVulkanMesh(vk::CommandBuffer &commandBuffer, VulkanMesh &mesh);
+void recordBindVulkanMesh(vk::CommandBuffer &commandBuffer, VulkanMeshBuffers &buffers);
+void recordDrawVulkanMeshRange(vk::CommandBuffer &commandBuffer, VulkanMesh &mesh);
+// Coarsest LOD still fine for a bounding sphere this many pixels across:
+// LOD 0 at fullDetailPixels or more, one level coarser every time it halves
+unsigned int selectVulkanMeshLOD(const VulkanMesh &mesh, float screenDiameter, float fullDetailPixels = 256.0f);
+void recordDrawVulkanMeshLOD(vk::CommandBuffer &commandBuffer, VulkanMesh &mesh, unsigned int lod);
+void recordDrawVulkanMeshInstanced( vk::CommandBuffer &commandBuffer, VulkanMesh &mesh,
+                                    uint32_t instanceCnt, uint32_t firstInstance=0);
+void recordBindVulkanInstanceBuffer(vk::CommandBuffer &commandBuffer, uint32_t binding,
+                                    VulkanBuffer &buffer, vk::DeviceSize offset=0);
 void cleanupVulkanMesh(VulkanInitData &vkInitData, VulkanMesh &mesh);
+void cleanupVulkanMeshBuffers(VulkanInitData &vkInitData, VulkanMeshBuffers &buffers);
 
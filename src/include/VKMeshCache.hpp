@@ -0,0 +1,120 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <vulkan/vulkan.hpp>
+#include "MeshData.hpp"
+#include "SceneGraph.hpp"
+#include "VKMesh.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Binary mesh cache
+// - One file per (source path, processing settings) holding a fully
+//   processed scene: node hierarchy, bounds, and the merged vertex/index
+//   blobs laid out exactly as queueVulkanMergedMeshUpload() would lay them
+//   out (index blob already in its final 16/32-bit type)
+// - Opened with mmap; the blobs are copied straight from the mapping into
+//   the staging ring, nothing is parsed
+// - Fresh if the source size and mtime match; if only the mtime changed,
+//   a content hash of the source decides
+// - Anything unexpected (version, vertex size, truncated file, bad ranges)
+//   just makes the cache stale, so the caller falls back to a full import
+///////////////////////////////////////////////////////////////////////////////
+
+const uint32_t VULKAN_MESH_CACHE_VERSION = 1;
+const string DEFAULT_MESH_CACHE_DIR = "mesh_cache";
+
+struct VulkanMeshCacheKey {
+    string sourcePath;              // Absolute
+    uint64_t sourceSize = 0;
+    int64_t sourceMTime = 0;
+    uint64_t settingsHash = 0;      // Everything else that changes the processed output
+};
+
+// Read-only file mapping of an opened cache
+struct VulkanMeshCacheFile {
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+    void *mappingHandle = nullptr;  // Windows only
+};
+
+// Processed scene in cache layout (filled by saveVulkanMeshCache())
+struct VulkanMeshCacheData {
+    uint32_t vertexSize = 0;
+    vk::IndexType indexType = vk::IndexType::eUint32;
+    vector<uint8_t> vertices;
+    vector<uint8_t> indices;
+    vector<VulkanMesh> meshes;      // Ranges only (no buffers)
+    vector<uint32_t> vertexCnts;
+    vector<MeshBounds> bounds;
+};
+
+// FNV-1a (chain calls by passing the previous hash as the seed)
+uint64_t hashVulkanMeshCacheSettings(const string &settings, uint64_t seed = 14695981039346656037ull);
+uint64_t hashVulkanMeshCacheSource(string sourcePath);
+
+// Returns false if the source file can't be found
+bool getVulkanMeshCacheKey(string sourcePath, uint64_t settingsHash, VulkanMeshCacheKey &key);
+string getVulkanMeshCacheFilename(const VulkanMeshCacheKey &key, string directory = DEFAULT_MESH_CACHE_DIR);
+
+// Never throws: returns false (and leaves cacheFile closed) if the cache is missing or stale
+bool openVulkanMeshCache(   string filename,
+                            const VulkanMeshCacheKey &key,
+                            uint32_t vertexSize,
+                            VulkanMeshCacheFile &cacheFile);
+void closeVulkanMeshCache(VulkanMeshCacheFile &cacheFile);
+
+SceneGraph getVulkanMeshCacheSceneGraph(const VulkanMeshCacheFile &cacheFile);
+vector<MeshBounds> getVulkanMeshCacheBounds(const VulkanMeshCacheFile &cacheFile);
+
+// Same result as queueVulkanMergedMeshUpload() on the meshes that were saved
+// (the file can be closed as soon as this returns)
+vector<VulkanMesh> queueVulkanMeshCacheUpload(  VulkanUploadBatch &batch,
+                                                const VulkanMeshCacheFile &cacheFile,
+                                                VulkanMeshBuffers &sharedBuffers);
+
+bool saveVulkanMeshCacheData(   string filename,
+                                const VulkanMeshCacheKey &key,
+                                const VulkanMeshCacheData &data,
+                                const SceneGraph &graph);
+
+// Narrows indices to data.indexType and copies them to firstIndex (data.indices is already sized)
+void copyVulkanMeshCacheIndices(VulkanMeshCacheData &data, unsigned int firstIndex, const vector<unsigned int> &indices);
+
+// Places the meshes with getVulkanMergedMeshLayout() (same as queueVulkanMergedMeshUpload()) and writes the cache
+template<typename T>
+bool saveVulkanMeshCache(   string filename,
+                            const VulkanMeshCacheKey &key,
+                            vector<Mesh<T>> &hostMeshes,
+                            const SceneGraph &graph) {
+    VulkanMergedMeshLayout layout = getVulkanMergedMeshLayout(hostMeshes);
+
+    VulkanMeshCacheData data;
+    data.vertexSize = sizeof(T);
+    data.indexType = layout.indexType;
+    data.vertices.resize(sizeof(T) * layout.vertexCnt);
+    data.indices.resize(getVulkanIndexSize(layout.indexType) * layout.indexCnt);
+
+    for(unsigned int i = 0; i < hostMeshes.size(); i++) {
+        Mesh<T> &hostMesh = hostMeshes[i];
+        VulkanMesh &mesh = layout.meshes[i];
+        data.vertexCnts.push_back(static_cast<uint32_t>(hostMesh.vertices.size()));
+        data.bounds.push_back(hostMesh.bounds);
+
+        if(!hostMesh.vertices.empty()) {
+            memcpy( data.vertices.data() + sizeof(T) * mesh.vertexOffset, 
+                    hostMesh.vertices.data(), sizeof(T) * hostMesh.vertices.size());
+        }
+        copyVulkanMeshCacheIndices(data, mesh.firstIndex, hostMesh.indices);
+        for(unsigned int k = 0; k < hostMesh.lods.size(); k++) {
+            copyVulkanMeshCacheIndices(data, mesh.lods[k + 1].firstIndex, hostMesh.lods[k].indices);
+        }
+    }
+    data.meshes = std::move(layout.meshes);
+
+    return saveVulkanMeshCacheData(filename, key, data, graph);
+}
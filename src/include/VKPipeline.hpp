@@ -0,0 +1,112 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <vulkan/vulkan.hpp>
+#include "VKSetup.hpp"
+#include "VKUtility.hpp"
+#include "VKMesh.hpp"
+#include "VKPipelineCache.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Graphics pipeline description
+// - Everything that makes one pipeline variant different from another
+// - Viewport and scissor are always dynamic
+///////////////////////////////////////////////////////////////////////////////
+
+struct VulkanPipelineDesc {
+    string vertSPVFilename;
+    string fragSPVFilename;
+    AttributeDescData attribDescData;
+
+    vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+    vk::PolygonMode polygonMode = vk::PolygonMode::eFill;
+    vk::CullModeFlags cullMode = vk::CullModeFlagBits::eNone;
+    vk::FrontFace frontFace = vk::FrontFace::eCounterClockwise;
+
+    bool depthTest = true;
+    bool depthWrite = true;
+    vk::CompareOp depthCompare = vk::CompareOp::eLess;
+
+    bool alphaBlend = false;            // src alpha / one minus src alpha
+};
+
+// Shader CODE (not file names) is part of the key
+uint64_t hashVulkanPipelineDesc(VulkanPipelineDesc &desc,
+                                const vector<char> &vertShaderCode,
+                                const vector<char> &fragShaderCode);
+
+vk::Pipeline createVulkanGraphicsPipeline(  vk::Device &device,
+                                            VulkanPipelineDesc &desc,
+                                            const vector<char> &vertShaderCode,
+                                            const vector<char> &fragShaderCode,
+                                            vk::RenderPass &renderPass,
+                                            vk::PipelineLayout &pipelineLayout,
+                                            vk::PipelineCache &cache);
+
+///////////////////////////////////////////////////////////////////////////////
+// Pipeline registry
+// - Variants are requested by description and compiled on worker threads
+// - Until a variant is ready, the fallback pipeline is returned instead
+// - All variants share one render pass, pipeline layout, and cache
+// - Request/get from ONE thread (the render loop)
+///////////////////////////////////////////////////////////////////////////////
+
+enum class VulkanPipelineState {
+    Pending = 0,
+    Ready,
+    Failed
+};
+
+struct VulkanPipelineEntry {
+    uint64_t key = 0;
+    VulkanPipelineDesc desc;
+    const vector<char> *vertShaderCode = nullptr;
+    const vector<char> *fragShaderCode = nullptr;
+
+    atomic<VulkanPipelineState> state { VulkanPipelineState::Pending };
+    vk::Pipeline pipeline;
+};
+
+struct VulkanPipelineRegistry {
+    vk::Device device;
+    vk::RenderPass renderPass;          // Do NOT clean up here
+    vk::PipelineLayout pipelineLayout;  // Do NOT clean up here
+    vk::PipelineCache cache;            // Do NOT clean up here
+    vk::Pipeline fallback;              // Do NOT clean up here
+
+    map<uint64_t, unique_ptr<VulkanPipelineEntry>> entries;
+    map<string, unique_ptr<vector<char>>> shaderCode;   // By file name
+
+    // Workers
+    vector<thread> workers;
+    mutex jobLock;
+    condition_variable jobReady;
+    deque<VulkanPipelineEntry*> jobs;
+    bool stopping = false;
+};
+
+void createVulkanPipelineRegistry(  VulkanInitData &vkInitData,
+                                    VulkanPipelineRegistry &registry,
+                                    vk::RenderPass &renderPass,
+                                    vk::PipelineLayout &pipelineLayout,
+                                    vk::PipelineCache &cache,
+                                    vk::Pipeline &fallback,
+                                    unsigned int workerCnt = 2);
+
+// Returns the key for this variant (compilation starts if it is new)
+uint64_t requestVulkanPipeline(VulkanPipelineRegistry &registry, VulkanPipelineDesc &desc);
+bool isVulkanPipelineReady(VulkanPipelineRegistry &registry, uint64_t key);
+vk::Pipeline getVulkanPipeline(VulkanPipelineRegistry &registry, uint64_t key);
+
+// Device must be idle
+void cleanupVulkanPipelineRegistry(VulkanPipelineRegistry &registry);
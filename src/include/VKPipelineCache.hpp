@@ -0,0 +1,32 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "VKSetup.hpp"
+#include "VKUtility.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Persistent pipeline cache
+// - Cache data is saved to a file named after the device's pipeline cache
+//   UUID, the driver version, and a hash of the shader code
+// - On load, the header the driver wrote is checked against this device;
+//   anything that doesn't match is ignored (the cache starts empty)
+///////////////////////////////////////////////////////////////////////////////
+
+const string DEFAULT_PIPELINE_CACHE_DIR = "pipeline_cache";
+
+uint64_t hashVulkanShaderCode(const vector<char> &code, uint64_t seed = 14695981039346656037ull);
+
+string getVulkanPipelineCacheFilename(  VulkanInitData &vkInitData,
+                                        uint64_t shaderHash,
+                                        string directory = DEFAULT_PIPELINE_CACHE_DIR);
+
+bool isVulkanPipelineCacheDataValid(VulkanInitData &vkInitData, const vector<char> &data);
+
+// Never fails: returns an empty cache if the file is missing or invalid
+vk::PipelineCache loadVulkanPipelineCache(VulkanInitData &vkInitData, string filename);
+bool saveVulkanPipelineCache(VulkanInitData &vkInitData, vk::PipelineCache &cache, string filename);
@@ -0,0 +1,95 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "VKSetup.hpp"
+#include "VKUtility.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// GPU profiler
+// - Named scopes are timed with timestamp queries written into the frame's
+//   command buffer (scopes can nest)
+// - Each frame in flight has its own query pool; results are read back the
+//   next time that frame slot comes around (its fence has already signaled,
+//   so reading never blocks)
+// - Uploads on the staging queue get their own small query pool
+///////////////////////////////////////////////////////////////////////////////
+
+struct VulkanGPUScope {
+    string name;
+    unsigned int depth = 0;
+    unsigned int beginQuery = 0;
+    bool recorded = false;              // False if the query pool was full
+};
+
+struct VulkanGPUProfilerFrame {
+    vk::QueryPool queryPool;
+    vector<VulkanGPUScope> scopes;
+    unsigned int queryCnt = 0;
+};
+
+struct VulkanGPUScopeResult {
+    string name;
+    unsigned int depth = 0;
+    double ms = 0.0;
+};
+
+struct VulkanGPUScopeStats {
+    string name;
+    unsigned int sampleCnt = 0;
+    double totalMS = 0.0;
+    double minMS = 0.0;
+    double maxMS = 0.0;
+    double lastMS = 0.0;
+};
+
+struct VulkanGPUProfiler {
+    bool enabled = false;               // Graphics queue supports timestamps
+    double msPerTick = 0.0;             // From timestampPeriod
+    uint64_t timestampMask = 0;         // From timestampValidBits
+    unsigned int maxQueries = 0;        // Per frame
+
+    vector<VulkanGPUProfilerFrame> frames;
+    unsigned int currentFrame = 0;
+    vector<unsigned int> openScopes;    // Indices into current frame's scopes
+
+    // Upload timers (only if the staging queue can reset/write timestamps)
+    bool uploadsEnabled = false;
+    vk::QueryPool uploadQueryPool;
+    vector<bool> uploadTimerBusy;
+
+    // Results
+    vector<VulkanGPUScopeResult> lastFrameResults;
+    vector<VulkanGPUScopeStats> stats;  // In order first seen
+};
+
+VulkanGPUProfiler createVulkanGPUProfiler(  VulkanInitData &vkInitData,
+                                            unsigned int frameCnt,
+                                            unsigned int maxScopes = 64,
+                                            unsigned int uploadTimerCnt = 32);
+
+// Collects the slot's previous results and resets its queries
+// (call AFTER the slot's fence is waited on; records into a command buffer
+// that is submitted BEFORE the frame's own command buffer)
+void beginVulkanGPUProfilerFrame(   vk::Device &device,
+                                    VulkanGPUProfiler &profiler,
+                                    unsigned int frameSlot,
+                                    vk::CommandBuffer &commandBuffer);
+
+void beginVulkanGPUScope(VulkanGPUProfiler &profiler, vk::CommandBuffer &commandBuffer, string name);
+void endVulkanGPUScope(VulkanGPUProfiler &profiler, vk::CommandBuffer &commandBuffer);
+
+// Upload timers return a slot (or -1 if unavailable) that is collected once the upload is done
+int beginVulkanGPUUploadTimer(VulkanGPUProfiler &profiler, vk::CommandBuffer &commandBuffer);
+void endVulkanGPUUploadTimer(VulkanGPUProfiler &profiler, vk::CommandBuffer &commandBuffer, int slot);
+void collectVulkanGPUUploadTimer(vk::Device &device, VulkanGPUProfiler &profiler, int slot);
+
+vector<VulkanGPUScopeResult>& getVulkanGPUFrameResults(VulkanGPUProfiler &profiler);
+vector<VulkanGPUScopeStats>& getVulkanGPUScopeStats(VulkanGPUProfiler &profiler);
+void resetVulkanGPUScopeStats(VulkanGPUProfiler &profiler);
+void printVulkanGPUProfileReport(VulkanGPUProfiler &profiler);
+
+void cleanupVulkanGPUProfiler(vk::Device &device, VulkanGPUProfiler &profiler);
@@ -2,6 +2,12 @@
 #include "VKSetup.hpp"
 #include "VKImage.hpp"
 #include "VKMesh.hpp"
+#include "VKCapture.hpp"
+#include "VKProfiler.hpp"
+#include "FrameStats.hpp"
+#include "VKPipelineCache.hpp"
+#include "VKPipeline.hpp"
+#include "VKCompute.hpp"
 
 ///////////////////////////////////////////////////////////////////////////////
 // Vulkan Render Structs
@@ -14,6 +20,7 @@ struct VulkanInitRenderParams {
 
 struct VulkanPipelineData {
     vk::PipelineCache cache;
+    string cacheFilename;              // Cache is saved here on cleanup
     vk::PipelineLayout pipelineLayout; // Necessary for passing in uniform variables
     vk::Pipeline graphicsPipeline;
     vector<vk::DescriptorSetLayout> descriptorSetLayouts;
@@ -21,6 +28,8 @@ struct VulkanPipelineData {
 
 struct VulkanFrameData {
     vk::CommandBuffer commandBuffer;
+    vk::CommandBuffer profilerCommandBuffer;   // Resets GPU timestamps (submitted first)
+    vk::CommandBuffer computeCommandBuffer;    // recordComputeCommands() (submitted before drawing)
 
     vk::Semaphore imageAvailableSemaphore;
     vk::Semaphore renderFinishedSemaphore;
@@ -34,6 +43,7 @@ struct VulkanFrameData {
 class VulkanRenderEngine {
     protected:    
         const int MAX_FRAMES_IN_FLIGHT = 2;
+        const vk::DeviceSize STAGING_RING_SIZE = 32 * 1024 * 1024;
 
         bool initialized = false;
 
@@ -41,12 +51,21 @@ class VulkanRenderEngine {
 
         vk::RenderPass renderPass;
         VulkanPipelineData pipelineData;
+        VulkanPipelineDesc basePipelineDesc;        // How pipelineData's pipeline was made
+        VulkanPipelineRegistry pipelineRegistry;    // Variants compiled in the background
+        vector<VulkanComputePipelineData> computePipelines;     // Destroyed with the engine
 
         VulkanImage depthImage;
         vector<vk::Framebuffer> framebuffers;
         atomic<bool> frameBufferResized = false;
 
         vk::CommandPool commandPool;
+        vk::CommandPool transferCommandPool;    // Only if transfer queue is a separate family
+        VulkanStagingRing stagingRing;
+        VulkanDeletionQueue deletionQueue;      // Resources released while frames may still use them
+        VulkanCaptureRing captureRing;          // Screenshots/frame sequences written in the background
+        VulkanGPUProfiler gpuProfiler;          // Timestamp queries around named scopes
+        FrameStats frameStats;                  // CPU time per frame stage (frames begun/ended by the app)
         unsigned int currentImage = 0;
         vector<VulkanFrameData> allFrameData;
 
@@ -71,6 +90,28 @@ class VulkanRenderEngine {
         ///////////////////////////////////////////////////////////////////////////////
 
         vk::CommandPool& getCommandPool();
+        VulkanStagingRing& getStagingRing();
+        VulkanDeletionQueue& getDeletionQueue();
+        VulkanGPUProfiler& getGPUProfiler();
+        FrameStats& getFrameStats();
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Pipeline variants
+        // - Start from getBasePipelineDesc() and change what you need
+        // - getPipeline() gives the main pipeline until the variant is compiled
+        ///////////////////////////////////////////////////////////////////////////////
+
+        VulkanPipelineDesc getBasePipelineDesc();
+        uint64_t requestPipeline(VulkanPipelineDesc &desc);
+        bool isPipelineReady(uint64_t key);
+        vk::Pipeline getPipeline(uint64_t key);
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Frame capture (written as PNG without stalling the frame)
+        ///////////////////////////////////////////////////////////////////////////////
+
+        void requestCapture(string filename);
+        void requestCaptureSequence(string filenamePrefix, unsigned int frameCnt);
         
         ///////////////////////////////////////////////////////////////////////////////
         // Swap chain recreation
@@ -104,6 +145,14 @@ class VulkanRenderEngine {
                                                         string fragSPVFilename);
         virtual void cleanupVulkanPipelineData(VulkanPipelineData &pipelineData); 
 
+        ///////////////////////////////////////////////////////////////////////////////
+        // Compute pipelines (share the graphics pipeline cache; engine destroys them)
+        ///////////////////////////////////////////////////////////////////////////////
+
+        VulkanComputePipelineData createComputePipeline(string compSPVFilename,
+                                                        const vector<vk::DescriptorSetLayout> &descriptorSetLayouts,
+                                                        const vector<vk::PushConstantRange> &pushConstantRanges = {});
+
         ///////////////////////////////////////////////////////////////////////////////
         // Vulkan framebuffers
         ///////////////////////////////////////////////////////////////////////////////
@@ -119,5 +168,17 @@ class VulkanRenderEngine {
         virtual void recordCommandBuffer(   void *userData, 
                                             vk::CommandBuffer &commandBuffer, 
                                             unsigned int imageIndex);
+
+        // Record dispatches the frame's drawing depends on (before any render pass)
+        // - commandBuffer is already begun and is ended by the engine
+        // - Return true if anything was recorded; a compute-to-graphics barrier follows it
+        virtual bool recordComputeCommands(void *userData, vk::CommandBuffer &commandBuffer);
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // GPU profiling scopes (GPU time in ms; see getGPUProfiler())
+        ///////////////////////////////////////////////////////////////////////////////
+
+        void beginGPUScope(vk::CommandBuffer &commandBuffer, string name);
+        void endGPUScope(vk::CommandBuffer &commandBuffer);
 };
 
@@ -5,16 +5,24 @@
 #include "VkBootstrap.h"
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
+#include "VKMemory.hpp"
 using namespace std;
 
 struct VulkanSwapChain {
     vk::SwapchainKHR chain;
-    //vector<vk::Image> images;
+    vector<vk::Image> images;       // Swapchain (or offscreen) images, same order as views
     vector<vk::ImageView> views;
     vk::Extent2D extent;
     vk::Format format;
+
+    // Headless only: offscreen color images stand in for swapchain images
+    vector<vk::Image> offscreenImages;
+    vector<VulkanAllocation> offscreenMemory;
+    unsigned int nextOffscreenImage = 0;
 };
 
+const unsigned int HEADLESS_IMAGE_COUNT = 3;
+
 struct VulkanQueue {
     vk::Queue queue;
     unsigned int index;
@@ -31,12 +39,22 @@ struct VulkanInitData {
     vk::Device device;    
     VulkanQueue graphicsQueue;
     VulkanQueue presentQueue;
+    VulkanQueue transferQueue;  // Same as graphicsQueue if no separate family (or not requested)
     VulkanSwapChain swapchain;
+    bool headless = false;      // No window, surface, or presentation
+
+    // Optional device features (enabled when the device has them)
+    bool hasMultiDrawIndirect = false;      // drawCount > 1 and firstInstance in indirect draws
+    bool hasDrawIndirectCount = false;      // VK_KHR_draw_indirect_count
 };
 
 GLFWwindow* createGLFWWindow(string windowName, int windowWidth, int windowHeight, bool isWindowResizable = true);
 void cleanupGLFWWindow(GLFWwindow *window);
-bool initVulkanBootstrap(string appName, GLFWwindow *window, VulkanInitData &vkInitData);
+bool initVulkanBootstrap(string appName, GLFWwindow *window, VulkanInitData &vkInitData,
+                        bool useTransferQueue = false);
+bool initVulkanHeadless(string appName, int width, int height, VulkanInitData &vkInitData,
+                        bool useTransferQueue = false);
+unsigned int acquireVulkanOffscreenImage(VulkanInitData &vkInitData);
 bool createVulkanSwapchain(VulkanInitData &vkInitData);
 void cleanupVulkanSwapchain(VulkanInitData &vkInitData);
 void cleanupVulkanBootstrap(VulkanInitData &vkInitData);
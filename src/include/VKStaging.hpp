@@ -0,0 +1,159 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <unordered_set>
+#include <vulkan/vulkan.hpp>
+#include "VKSetup.hpp"
+#include "VKUtility.hpp"
+#include "VKBuffer.hpp"
+#include "VKImage.hpp"
+#include "VKProfiler.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Staging ring
+// - One persistently mapped, host-visible buffer used for ALL uploads
+// - Writes are queued and submitted together as one batch of copies
+// - Each submitted batch owns a region of the ring until its fence signals
+// - If copies run on a different queue family than the one that uses the
+//   resources, ownership is released after the copy and acquired on the
+//   owner queue once the copy is done (so rendering never waits on it)
+// - Buffers are released ONCE, by the flush that ends the upload batch (a
+//   batch may flush early when the ring fills); uploading into a buffer the
+//   owner queue already has first releases it back from the owner queue
+///////////////////////////////////////////////////////////////////////////////
+
+struct VulkanStagingCopy {
+    vk::Buffer dst;
+    vk::BufferCopy region;
+};
+
+struct VulkanStagingImageCopy {
+    vk::Image dst;
+    vk::BufferImageCopy region;
+};
+
+struct VulkanStagingSubmit {
+    uint64_t serial = 0;
+    vk::DeviceSize start = 0;       // Ring region [start, end) (may wrap around)
+    vk::DeviceSize end = 0;
+    vk::Fence fence;
+    vk::CommandBuffer commandBuffer;
+    int timerSlot = -1;             // GPU upload timer (if profiling)
+
+    // Ownership transfer only
+    vk::Semaphore releaseSemaphore;
+    vk::Semaphore reclaimSemaphore;     // Owner queue gave buffers back before the copies
+    vector<vk::BufferMemoryBarrier> acquireBuffers;
+    vector<vk::ImageMemoryBarrier> acquireImages;
+};
+
+struct VulkanStagingAcquire {
+    vk::Fence fence;
+    vk::CommandBuffer commandBuffer;
+    vk::Semaphore waitSemaphore;
+};
+
+struct VulkanStagingRing {
+    VulkanBuffer buffer;
+    char *mapped = nullptr;
+    vk::DeviceSize capacity = 0;
+    vk::DeviceSize head = 0;            // Next write position
+    vk::DeviceSize pendingStart = 0;    // First byte written since the last flush
+
+    vk::CommandPool commandPool;        // Pool for queue that does the copies (do NOT clean up here)
+    VulkanQueue queue;
+    vk::CommandPool ownerCommandPool;   // Pool for queue that uses the resources (do NOT clean up here)
+    VulkanQueue ownerQueue;
+
+    vector<VulkanStagingCopy> pendingCopies;
+    vector<VulkanStagingImageCopy> pendingImageCopies;
+    deque<VulkanStagingSubmit> inFlight;
+    deque<VulkanStagingAcquire> acquiresInFlight;
+
+    // Ownership transfer only (plain handles; a destroyed buffer's handle may be
+    // reused, which at worst releases a new buffer from the owner queue for nothing)
+    unordered_set<VkBuffer> transferBuffers;    // Copied into, not released yet
+    unordered_set<VkBuffer> ownerBuffers;       // Released to the owner queue
+    unordered_set<VkBuffer> reclaimBuffers;     // Owned, but about to be copied into again
+    uint64_t lastSubmitted = 0;
+    uint64_t lastCompleted = 0;
+
+    VulkanGPUProfiler *profiler = nullptr;  // Optional; times each batch of copies
+};
+
+VulkanStagingRing createVulkanStagingRing(  vk::PhysicalDevice &physicalDevice,
+                                            vk::Device &device,
+                                            vk::CommandPool &commandPool,
+                                            VulkanQueue &queue,
+                                            vk::DeviceSize capacity);
+VulkanStagingRing createVulkanStagingRing(  vk::PhysicalDevice &physicalDevice,
+                                            vk::Device &device,
+                                            vk::CommandPool &transferCommandPool,
+                                            VulkanQueue &transferQueue,
+                                            vk::CommandPool &ownerCommandPool,
+                                            VulkanQueue &ownerQueue,
+                                            vk::DeviceSize capacity);
+bool usesVulkanOwnershipTransfer(VulkanStagingRing &ring);
+
+void stageDataToVulkanBuffer(   vk::Device &device,
+                                VulkanStagingRing &ring,
+                                VulkanBuffer &dst,
+                                vk::DeviceSize dstOffset,
+                                vk::DeviceSize size,
+                                const void *data);
+// releaseOwnership = false keeps written buffers on the copy queue (flushes in
+// the middle of a batch); the final flush releases everything written so far
+uint64_t flushVulkanStagingRing(vk::Device &device, VulkanStagingRing &ring, bool releaseOwnership = true);
+void updateVulkanStagingRing(vk::Device &device, VulkanStagingRing &ring);
+bool isVulkanStagingComplete(vk::Device &device, VulkanStagingRing &ring, uint64_t serial);
+void waitForVulkanStagingRing(vk::Device &device, VulkanStagingRing &ring, uint64_t serial);
+
+void stageDataToVulkanImage(vk::Device &device,
+                            VulkanStagingRing &ring,
+                            VulkanImage &dst,
+                            int width, int height,
+                            vk::DeviceSize size,
+                            const void *data);
+
+void copyDataToVulkanBufferViaStaging(  vk::Device &device,
+                                        VulkanStagingRing &ring,
+                                        VulkanBuffer &dst,
+                                        vk::DeviceSize size,
+                                        void *data);
+
+void cleanupVulkanStagingRing(vk::Device &device, VulkanStagingRing &ring);
+
+///////////////////////////////////////////////////////////////////////////////
+// Upload batches
+// - Open a batch, queue any number of mesh/image uploads, submit ONCE
+// - The returned token can be polled or waited on later
+///////////////////////////////////////////////////////////////////////////////
+
+struct VulkanUploadBatch {
+    VulkanInitData *vkInitData = nullptr;
+    VulkanStagingRing *ring = nullptr;
+    unsigned int uploadCnt = 0;
+};
+
+struct VulkanUploadToken {
+    VulkanStagingRing *ring = nullptr;
+    uint64_t serial = 0;
+};
+
+VulkanUploadBatch beginVulkanUploadBatch(VulkanInitData &vkInitData, VulkanStagingRing &ring);
+void queueVulkanBufferUpload(   VulkanUploadBatch &batch,
+                                VulkanBuffer &dst,
+                                vk::DeviceSize dstOffset,
+                                vk::DeviceSize size,
+                                const void *data);
+VulkanImage queueVulkanImageUpload( VulkanUploadBatch &batch,
+                                    int width, int height,
+                                    vk::Format format,
+                                    vk::DeviceSize size,
+                                    const void *pixels);
+VulkanUploadToken submitVulkanUploadBatch(VulkanUploadBatch &batch);
+
+bool isVulkanUploadComplete(vk::Device &device, VulkanUploadToken &token);
+void waitForVulkanUpload(vk::Device &device, VulkanUploadToken &token);
@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <cstring>
 #include "VKSetup.hpp"
 #include "VKUtility.hpp"
 #include "VKBuffer.hpp"
@@ -13,6 +14,7 @@
 
 using namespace std;
 
+// Move-only (owns its buffers)
 struct UBOData {
     vector<VulkanBuffer> bufferData;    
     vector<void*> mapped;
@@ -22,4 +24,46 @@ UBOData createVulkanUniformBufferData(vk::Device &device,
                                 vk::PhysicalDevice &physicalDevice,
                                 size_t bufferSize, 
                                 int maxFramesInFlights=2);
-void cleanupVulkanUniformBufferData(vk::Device &device, UBOData &uboData);
\ No newline at end of file
+void cleanupVulkanUniformBufferData(vk::Device &device, UBOData &uboData);
+
+///////////////////////////////////////////////////////////////////////////////
+// Per-frame linear uniform allocator
+// - ONE persistently mapped buffer, split into a region per frame in flight
+// - Blocks are bump-allocated from the current frame's region each frame
+// - Bind with eUniformBufferDynamic (or eStorageBufferDynamic) descriptors
+//   whose base offset is 0; the returned offset is the dynamic offset
+// - Pass extraUsage = eVertexBuffer to also stream per-instance vertex data
+//   (the returned offset is then the bind offset)
+///////////////////////////////////////////////////////////////////////////////
+
+struct VulkanFrameUniformAllocator {
+    VulkanBuffer buffer;
+    char *mapped = nullptr;
+    vk::DeviceSize frameSize = 0;       // Bytes per frame region
+    vk::DeviceSize alignment = 1;       // Dynamic offsets must be multiples of this
+    vk::DeviceSize head = 0;            // Next free byte in current region
+    unsigned int frameIndex = 0;
+    unsigned int frameCnt = 0;
+};
+
+struct VulkanFrameUniformBlock {
+    void *mapped = nullptr;
+    uint32_t dynamicOffset = 0;
+};
+
+VulkanFrameUniformAllocator createVulkanFrameUniformAllocator(  vk::Device &device,
+                                                                vk::PhysicalDevice &physicalDevice,
+                                                                vk::DeviceSize frameSize,
+                                                                int maxFramesInFlight=2,
+                                                                vk::BufferUsageFlags extraUsage={});
+void beginVulkanFrameUniforms(VulkanFrameUniformAllocator &allocator, unsigned int frameIndex);
+VulkanFrameUniformBlock allocateVulkanFrameUniform(VulkanFrameUniformAllocator &allocator, vk::DeviceSize size);
+void cleanupVulkanFrameUniformAllocator(vk::Device &device, VulkanFrameUniformAllocator &allocator);
+
+// Copies data into the current frame and returns its dynamic offset
+template<typename T>
+uint32_t pushVulkanFrameUniform(VulkanFrameUniformAllocator &allocator, const T &data) {
+    VulkanFrameUniformBlock block = allocateVulkanFrameUniform(allocator, sizeof(T));
+    memcpy(block.mapped, &data, sizeof(T));
+    return block.dynamicOffset;
+}
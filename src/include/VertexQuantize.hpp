@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "glm/glm.hpp"
+#include "MeshData.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Quantized vertices
+// - Positions: 16-bit UNORM within the mesh's AABB; the vertex fetch turns
+//   them into [0,1] and getVertexDequantizeMatrix() (folded into the model
+//   matrix) maps that back onto the AABB
+// - Normals: octahedron-encoded into 2x16-bit SNORM (decoded in the shader)
+// - Colors: RGBA8 UNORM
+// - 16 bytes per vertex, vs. 40 for float pos/color/normal
+///////////////////////////////////////////////////////////////////////////////
+
+struct QuantizedVertex {
+    uint16_t pos[4];        // w is padding (RGBA16 is the widely supported format)
+    int16_t normal[2];
+    uint8_t color[4];
+};
+
+// pos = offset + unorm * scale
+struct VertexDequantize {
+    glm::vec3 offset = glm::vec3(0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+};
+
+uint16_t quantizeUnorm16(float v);
+int16_t quantizeSnorm16(float v);
+uint8_t quantizeUnorm8(float v);
+
+// Octahedron mapping of a unit vector onto [-1,1]^2 (and back)
+glm::vec2 encodeOctahedronNormal(glm::vec3 n);
+glm::vec3 decodeOctahedronNormal(glm::vec2 e);
+
+VertexDequantize getVertexDequantize(const AABB &box);
+glm::mat4 getVertexDequantizeMatrix(const VertexDequantize &dequant);
+
+QuantizedVertex quantizeVertex( const glm::vec3 &pos, const glm::vec4 &color, const glm::vec3 &normal,
+                                const VertexDequantize &dequant);
+
+// Same indices, LODs, and (object-space) bounds; needs bounds already computed
+// (T must have glm::vec3 pos, glm::vec4 color, and glm::vec3 normal)
+template<typename T>
+Mesh<QuantizedVertex> quantizeMesh(const Mesh<T> &mesh) {
+    Mesh<QuantizedVertex> result;
+    result.indices = mesh.indices;
+    result.bounds = mesh.bounds;
+    result.lods = mesh.lods;
+
+    VertexDequantize dequant = getVertexDequantize(mesh.bounds.box);
+    result.vertices.reserve(mesh.vertices.size());
+    for(auto &v : mesh.vertices) {
+        result.vertices.push_back(quantizeVertex(v.pos, v.color, v.normal, dequant));
+    }
+    return result;
+}
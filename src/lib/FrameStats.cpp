@@ -0,0 +1,245 @@
+#include "FrameStats.hpp"
+#include <algorithm>
+#include <iomanip>
+
+///////////////////////////////////////////////////////////////////////////////
+// SETUP
+///////////////////////////////////////////////////////////////////////////////
+
+string getFrameStageName(FrameStage stage) {
+    switch(stage) {
+        case FrameStage::Poll:      return "poll";
+        case FrameStage::Wait:      return "wait";
+        case FrameStage::Record:    return "record";
+        case FrameStage::Submit:    return "submit";
+        case FrameStage::Present:   return "present";
+        default:                    return "unknown";
+    }
+}
+
+void createFrameStats(FrameStats &stats, unsigned int capacity) {
+    stats.ring.clear();
+    stats.ring.resize(std::max(capacity, 2u));
+    stats.writeCnt.store(0);
+    stats.inFrame = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// RECORDING (render thread only)
+///////////////////////////////////////////////////////////////////////////////
+
+static float getElapsedMS(chrono::steady_clock::time_point start, chrono::steady_clock::time_point end) {
+    return getElapsedSeconds(start, end) * 1000.0f;
+}
+
+void beginFrameStatsFrame(FrameStats &stats) {
+    stats.current = FrameTiming();
+    stats.current.frameIndex = stats.writeCnt.load(memory_order_relaxed);
+    stats.frameStart = getTime();
+    stats.stageStart = stats.frameStart;
+    stats.inFrame = true;
+}
+
+void beginFrameStage(FrameStats &stats) {
+    stats.stageStart = getTime();
+}
+
+void endFrameStage(FrameStats &stats, FrameStage stage) {
+    if(!stats.inFrame) {
+        return;
+    }
+    stats.current.stageMS[(int)stage] += getElapsedMS(stats.stageStart, getTime());
+}
+
+void flagFrameStatsFrame(FrameStats &stats, unsigned int flags) {
+    stats.current.flags |= flags;
+}
+
+void endFrameStatsFrame(FrameStats &stats) {
+    if(!stats.inFrame || stats.ring.empty()) {
+        return;
+    }
+
+    stats.current.totalMS = getElapsedMS(stats.frameStart, getTime());
+
+    // Write the slot, THEN publish it
+    uint64_t index = stats.writeCnt.load(memory_order_relaxed);
+    stats.ring[index % stats.ring.size()] = stats.current;
+    stats.writeCnt.store(index + 1, memory_order_release);
+    stats.inFrame = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SUMMARY
+///////////////////////////////////////////////////////////////////////////////
+
+vector<FrameTiming> getFrameStatsSnapshot(FrameStats &stats) {
+    vector<FrameTiming> snapshot;
+    uint64_t writeCnt = stats.writeCnt.load(memory_order_acquire);
+    uint64_t capacity = stats.ring.size();
+
+    // Leave out the oldest slot when full (the writer may be overwriting it)
+    uint64_t available = std::min(writeCnt, capacity - 1);
+    for(uint64_t i = writeCnt - available; i < writeCnt; i++) {
+        snapshot.push_back(stats.ring[i % capacity]);
+    }
+    return snapshot;
+}
+
+// Nearest-rank percentile of sorted values
+static float getPercentile(vector<float> &sorted, float p) {
+    if(sorted.empty()) {
+        return 0.0f;
+    }
+    size_t rank = static_cast<size_t>(p * (sorted.size() - 1) + 0.5f);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+static FrameStatsPercentiles computePercentiles(vector<float> &values) {
+    FrameStatsPercentiles result;
+    if(values.empty()) {
+        return result;
+    }
+
+    sort(values.begin(), values.end());
+
+    double sum = 0.0;
+    for(float v : values) {
+        sum += v;
+    }
+
+    result.meanMS = static_cast<float>(sum / values.size());
+    result.p50MS = getPercentile(values, 0.50f);
+    result.p95MS = getPercentile(values, 0.95f);
+    result.p99MS = getPercentile(values, 0.99f);
+    result.maxMS = values.back();
+    return result;
+}
+
+FrameStatsSummary computeFrameStatsSummary( FrameStats &stats,
+                                            float binWidthMS,
+                                            unsigned int binCnt) {
+    FrameStatsSummary summary;
+    vector<FrameTiming> frames = getFrameStatsSnapshot(stats);
+
+    summary.frameCnt = static_cast<unsigned int>(frames.size());
+    summary.binWidthMS = binWidthMS;
+    summary.histogram.resize(std::max(binCnt, 1u), 0);
+
+    vector<float> totals;
+    vector<float> stageValues[(int)FrameStage::Count];
+    for(auto &frame : frames) {
+        totals.push_back(frame.totalMS);
+        for(int s = 0; s < (int)FrameStage::Count; s++) {
+            stageValues[s].push_back(frame.stageMS[s]);
+        }
+        if(frame.flags != 0) {
+            summary.flaggedFrameCnt++;
+        }
+
+        unsigned int bin = static_cast<unsigned int>(frame.totalMS / binWidthMS);
+        bin = std::min(bin, static_cast<unsigned int>(summary.histogram.size() - 1));
+        summary.histogram[bin]++;
+    }
+
+    summary.total = computePercentiles(totals);
+    for(int s = 0; s < (int)FrameStage::Count; s++) {
+        summary.stages[s] = computePercentiles(stageValues[s]);
+    }
+
+    return summary;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// OUTPUT
+///////////////////////////////////////////////////////////////////////////////
+
+static void printPercentiles(string name, FrameStatsPercentiles &p) {
+    cout << "  " << setw(8) << left << name << right
+        << " mean " << setw(7) << p.meanMS
+        << "  p50 " << setw(7) << p.p50MS
+        << "  p95 " << setw(7) << p.p95MS
+        << "  p99 " << setw(7) << p.p99MS
+        << "  max " << setw(7) << p.maxMS << endl;
+}
+
+void printFrameStatsSummary(FrameStatsSummary &summary) {
+    cout << "Frame times (ms) over " << summary.frameCnt << " frames";
+    if(summary.flaggedFrameCnt > 0) {
+        cout << " (" << summary.flaggedFrameCnt << " with swapchain recreation)";
+    }
+    cout << ":" << endl;
+
+    cout << fixed << setprecision(3);
+    printPercentiles("total", summary.total);
+    for(int s = 0; s < (int)FrameStage::Count; s++) {
+        printPercentiles(getFrameStageName((FrameStage)s), summary.stages[s]);
+    }
+    cout << defaultfloat;
+}
+
+bool writeFrameStatsCSV(FrameStats &stats, string filename) {
+    ofstream file(filename);
+    if(!file) {
+        cerr << "writeFrameStatsCSV: Could not open " << filename << endl;
+        return false;
+    }
+
+    // One row per frame
+    file << "frame,total_ms";
+    for(int s = 0; s < (int)FrameStage::Count; s++) {
+        file << "," << getFrameStageName((FrameStage)s) << "_ms";
+    }
+    file << ",flags" << endl;
+
+    for(auto &frame : getFrameStatsSnapshot(stats)) {
+        file << frame.frameIndex << "," << frame.totalMS;
+        for(int s = 0; s < (int)FrameStage::Count; s++) {
+            file << "," << frame.stageMS[s];
+        }
+        file << "," << frame.flags << endl;
+    }
+
+    return true;
+}
+
+static void writePercentilesJSON(ofstream &file, FrameStatsPercentiles &p) {
+    file << "{ \"mean\": " << p.meanMS
+        << ", \"p50\": " << p.p50MS
+        << ", \"p95\": " << p.p95MS
+        << ", \"p99\": " << p.p99MS
+        << ", \"max\": " << p.maxMS << " }";
+}
+
+bool writeFrameStatsJSON(FrameStatsSummary &summary, string filename) {
+    ofstream file(filename);
+    if(!file) {
+        cerr << "writeFrameStatsJSON: Could not open " << filename << endl;
+        return false;
+    }
+
+    file << "{" << endl;
+    file << "  \"frames\": " << summary.frameCnt << "," << endl;
+    file << "  \"flaggedFrames\": " << summary.flaggedFrameCnt << "," << endl;
+
+    file << "  \"total\": ";
+    writePercentilesJSON(file, summary.total);
+    file << "," << endl;
+
+    file << "  \"stages\": {" << endl;
+    for(int s = 0; s < (int)FrameStage::Count; s++) {
+        file << "    \"" << getFrameStageName((FrameStage)s) << "\": ";
+        writePercentilesJSON(file, summary.stages[s]);
+        file << ((s + 1 < (int)FrameStage::Count) ? "," : "") << endl;
+    }
+    file << "  }," << endl;
+
+    file << "  \"histogram\": { \"binWidthMs\": " << summary.binWidthMS << ", \"counts\": [";
+    for(unsigned int i = 0; i < summary.histogram.size(); i++) {
+        file << (i > 0 ? ", " : "") << summary.histogram[i];
+    }
+    file << "] }" << endl;
+    file << "}" << endl;
+
+    return true;
+}
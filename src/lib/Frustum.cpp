@@ -0,0 +1,141 @@
+#include "Frustum.hpp"
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// SETUP
+///////////////////////////////////////////////////////////////////////////////
+
+Frustum extractFrustum(const glm::mat4 &viewProj) {
+    // Rows of the matrix (glm is column-major)
+    glm::vec4 rows[4];
+    for(int i = 0; i < 4; i++) {
+        rows[i] = glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+    }
+
+    Frustum frustum;
+    frustum.planes[0] = rows[3] + rows[0];     // Left
+    frustum.planes[1] = rows[3] - rows[0];     // Right
+    frustum.planes[2] = rows[3] + rows[1];     // Bottom
+    frustum.planes[3] = rows[3] - rows[1];     // Top
+    frustum.planes[4] = rows[3] + rows[2];     // Near
+    frustum.planes[5] = rows[3] - rows[2];     // Far
+
+    // Normalize so plane distances are in world units (and comparable to radii)
+    for(auto &plane : frustum.planes) {
+        float length = glm::length(glm::vec3(plane));
+        if(length > 0.0f) {
+            plane /= length;
+        }
+    }
+
+    return frustum;
+}
+
+BoundingSphere transformBoundingSphere(const BoundingSphere &sphere, const glm::mat4 &modelMat) {
+    BoundingSphere result;
+    result.center = glm::vec3(modelMat * glm::vec4(sphere.center, 1.0f));
+
+    // Largest axis scale keeps the sphere conservative under non-uniform scaling
+    float scale = std::max(glm::length(glm::vec3(modelMat[0])),
+                    std::max(glm::length(glm::vec3(modelMat[1])), glm::length(glm::vec3(modelMat[2]))));
+    result.radius = sphere.radius * scale;
+    return result;
+}
+
+float getSphereScreenScale(const glm::mat4 &projMat, float screenHeight) {
+    return projMat[1][1] * screenHeight;
+}
+
+float getProjectedSphereDiameter(float screenScale, float radius, float viewDepth) {
+    // Camera inside the sphere: as big as it gets
+    if(viewDepth <= radius) {
+        return std::numeric_limits<float>::max();
+    }
+    return radius * screenScale / viewDepth;
+}
+
+void clearFrustumSpheres(FrustumSpheres &spheres) {
+    spheres.x.clear();
+    spheres.y.clear();
+    spheres.z.clear();
+    spheres.radius.clear();
+}
+
+void addFrustumSphere(FrustumSpheres &spheres, const BoundingSphere &sphere) {
+    spheres.x.push_back(sphere.center.x);
+    spheres.y.push_back(sphere.center.y);
+    spheres.z.push_back(sphere.center.z);
+    spheres.radius.push_back(sphere.radius);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CULLING
+///////////////////////////////////////////////////////////////////////////////
+
+static bool isSphereVisible(const Frustum &frustum, float x, float y, float z, float radius) {
+    for(auto &plane : frustum.planes) {
+        if(plane.x * x + plane.y * y + plane.z * z + plane.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+unsigned int cullFrustumSpheres(const Frustum &frustum, 
+                                const FrustumSpheres &spheres,
+                                vector<uint8_t> &visible) {
+    size_t cnt = spheres.x.size();
+    visible.resize(cnt);
+
+    unsigned int visibleCnt = 0;
+    size_t i = 0;
+
+#ifdef FRUSTUM_USE_SSE
+    // Broadcast each plane once
+    __m128 px[6], py[6], pz[6], pw[6];
+    for(int p = 0; p < 6; p++) {
+        px[p] = _mm_set1_ps(frustum.planes[p].x);
+        py[p] = _mm_set1_ps(frustum.planes[p].y);
+        pz[p] = _mm_set1_ps(frustum.planes[p].z);
+        pw[p] = _mm_set1_ps(frustum.planes[p].w);
+    }
+
+    // Four spheres at a time
+    for(; i + 4 <= cnt; i += 4) {
+        __m128 x = _mm_loadu_ps(&spheres.x[i]);
+        __m128 y = _mm_loadu_ps(&spheres.y[i]);
+        __m128 z = _mm_loadu_ps(&spheres.z[i]);
+        __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+
+        // Lanes stay set only while the sphere is inside every plane so far
+        __m128 inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+        for(int p = 0; p < 6; p++) {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], x), _mm_mul_ps(py[p], y)),
+                                     _mm_add_ps(_mm_mul_ps(pz[p], z), pw[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, negRadius));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for(int lane = 0; lane < 4; lane++) {
+            uint8_t v = (mask >> lane) & 1;
+            visible[i + lane] = v;
+            visibleCnt += v;
+        }
+    }
+#endif
+
+    // Whatever is left (or everything, without SSE)
+    for(; i < cnt; i++) {
+        bool v = isSphereVisible(frustum, spheres.x[i], spheres.y[i], spheres.z[i], spheres.radius[i]);
+        visible[i] = v ? 1 : 0;
+        visibleCnt += visible[i];
+    }
+
+    return visibleCnt;
+}
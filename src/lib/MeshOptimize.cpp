@@ -0,0 +1,328 @@
+#include "MeshOptimize.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+
+///////////////////////////////////////////////////////////////////////////////
+// CACHE SIMULATION
+///////////////////////////////////////////////////////////////////////////////
+
+// FIFO cache via timestamps: a vertex is cached if it missed within the last cacheSize misses
+struct FIFOCache {
+    vector<unsigned int> missTime;
+    unsigned int time = 0;
+    unsigned int size = 0;
+};
+
+static void resetFIFOCache(FIFOCache &cache) {
+    cache.time += cache.size + 1;
+}
+
+static FIFOCache makeFIFOCache(size_t vertexCnt, unsigned int cacheSize) {
+    FIFOCache cache;
+    cache.missTime.assign(vertexCnt, 0);
+    cache.size = cacheSize;
+    resetFIFOCache(cache);
+    return cache;
+}
+
+// Returns how many of the triangle's vertices missed
+static unsigned int touchFIFOCache(FIFOCache &cache, const unsigned int *tri) {
+    unsigned int misses = 0;
+    for(int k = 0; k < 3; k++) {
+        unsigned int v = tri[k];
+        if(cache.time - cache.missTime[v] >= cache.size) {
+            cache.missTime[v] = ++cache.time;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+float getVertexCacheACMR(   const vector<unsigned int> &indices,
+                            size_t vertexCnt,
+                            unsigned int cacheSize) {
+    size_t triCnt = indices.size() / 3;
+    if(triCnt == 0) {
+        return 0.0f;
+    }
+
+    FIFOCache cache = makeFIFOCache(vertexCnt, cacheSize);
+    size_t misses = 0;
+    for(size_t t = 0; t < triCnt; t++) {
+        misses += touchFIFOCache(cache, &indices[t * 3]);
+    }
+    return (float)misses / triCnt;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// VERTEX CACHE
+///////////////////////////////////////////////////////////////////////////////
+
+// Scoring from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+const int FORSYTH_CACHE_SIZE = 32;
+const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+const float FORSYTH_LAST_TRI_SCORE = 0.75f;
+const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+static float getForsythVertexScore(int cachePos, unsigned int remainingValence) {
+    if(remainingValence == 0) {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if(cachePos >= 0) {
+        if(cachePos < 3) {
+            // Used by the last triangle; fixed score so strips don't zig-zag
+            score = FORSYTH_LAST_TRI_SCORE;
+        }
+        else {
+            float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cachePos - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+        }
+    }
+
+    // Finish off vertices with few triangles left before they leave the cache
+    score += FORSYTH_VALENCE_BOOST_SCALE * std::pow((float)remainingValence, -FORSYTH_VALENCE_BOOST_POWER);
+    return score;
+}
+
+vector<unsigned int> optimizeVertexCacheIndices(const vector<unsigned int> &indices, size_t vertexCnt) {
+    size_t triCnt = indices.size() / 3;
+    vector<unsigned int> result;
+    result.reserve(triCnt * 3);
+    if(triCnt == 0) {
+        return result;
+    }
+
+    // Vertex -> triangles (CSR); remaining counts shrink as triangles are emitted
+    vector<unsigned int> triStart(vertexCnt + 1, 0);
+    for(size_t i = 0; i < triCnt * 3; i++) {
+        triStart[indices[i] + 1]++;
+    }
+    for(size_t v = 0; v < vertexCnt; v++) {
+        triStart[v + 1] += triStart[v];
+    }
+    vector<unsigned int> vertexTris(triCnt * 3);
+    vector<unsigned int> remaining(vertexCnt, 0);
+    for(size_t t = 0; t < triCnt; t++) {
+        for(int k = 0; k < 3; k++) {
+            unsigned int v = indices[t * 3 + k];
+            vertexTris[triStart[v] + remaining[v]++] = (unsigned int)t;
+        }
+    }
+
+    vector<int> cachePos(vertexCnt, -1);
+    vector<float> vertexScore(vertexCnt);
+    for(size_t v = 0; v < vertexCnt; v++) {
+        vertexScore[v] = getForsythVertexScore(-1, remaining[v]);
+    }
+
+    vector<float> triScore(triCnt);
+    vector<uint8_t> emitted(triCnt, 0);
+    for(size_t t = 0; t < triCnt; t++) {
+        triScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]]
+                        + vertexScore[indices[t * 3 + 2]];
+    }
+
+    // LRU cache (+3 while a triangle is being added)
+    vector<unsigned int> cache;
+    vector<unsigned int> newCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    size_t cursor = 0;              // Every triangle before this is emitted
+    int bestTri = -1;
+    for(size_t emittedCnt = 0; emittedCnt < triCnt; emittedCnt++) {
+        // Nothing in the cache to continue from: take the next triangle in input order
+        if(bestTri < 0) {
+            while(emitted[cursor]) {
+                cursor++;
+            }
+            bestTri = (int)cursor;
+        }
+
+        const unsigned int *tri = &indices[bestTri * 3];
+        result.insert(result.end(), tri, tri + 3);
+        emitted[bestTri] = 1;
+
+        // Drop the triangle from its vertices' remaining lists
+        for(int k = 0; k < 3; k++) {
+            unsigned int v = tri[k];
+            unsigned int *begin = &vertexTris[triStart[v]];
+            unsigned int *end = begin + remaining[v];
+            *std::find(begin, end, (unsigned int)bestTri) = *(end - 1);
+            remaining[v]--;
+        }
+
+        // Triangle's vertices go to the front, everything else shifts back
+        newCache.assign(tri, tri + 3);
+        for(unsigned int v : cache) {
+            if(v != tri[0] && v != tri[1] && v != tri[2]) {
+                newCache.push_back(v);
+            }
+        }
+
+        // Rescore whatever is (or just fell out of) the cache, and their triangles
+        for(size_t i = 0; i < newCache.size(); i++) {
+            unsigned int v = newCache[i];
+            int pos = (i < (size_t)FORSYTH_CACHE_SIZE) ? (int)i : -1;
+            cachePos[v] = pos;
+
+            float score = getForsythVertexScore(pos, remaining[v]);
+            float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+            for(unsigned int j = 0; j < remaining[v]; j++) {
+                triScore[vertexTris[triStart[v] + j]] += delta;
+            }
+        }
+        if(newCache.size() > (size_t)FORSYTH_CACHE_SIZE) {
+            newCache.resize(FORSYTH_CACHE_SIZE);
+        }
+        cache.swap(newCache);
+
+        // Best next triangle is one that touches the cache
+        bestTri = -1;
+        float bestScore = 0.0f;
+        for(unsigned int v : cache) {
+            for(unsigned int j = 0; j < remaining[v]; j++) {
+                unsigned int t = vertexTris[triStart[v] + j];
+                if(triScore[t] > bestScore) {
+                    bestScore = triScore[t];
+                    bestTri = (int)t;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// OVERDRAW
+///////////////////////////////////////////////////////////////////////////////
+
+struct TriangleCluster {
+    size_t start;
+    size_t end;
+    float sortKey;
+};
+
+vector<unsigned int> optimizeOverdrawIndices(   const vector<glm::vec3> &positions,
+                                                const vector<unsigned int> &indices,
+                                                float threshold) {
+    size_t triCnt = indices.size() / 3;
+    if(triCnt < 2) {
+        return indices;
+    }
+
+    // Hard boundaries: triangles that miss on all three vertices (cache starts over anyway)
+    vector<size_t> hardStarts;
+    FIFOCache cache = makeFIFOCache(positions.size(), MESH_OPTIMIZE_CACHE_SIZE);
+    for(size_t t = 0; t < triCnt; t++) {
+        if(touchFIFOCache(cache, &indices[t * 3]) == 3) {
+            hardStarts.push_back(t);
+        }
+    }
+    if(hardStarts.empty() || hardStarts[0] != 0) {
+        hardStarts.insert(hardStarts.begin(), 0);
+    }
+    hardStarts.push_back(triCnt);
+
+    // Soft boundaries: split further wherever restarting costs little
+    // (running ACMR already within threshold of the cluster's own)
+    vector<TriangleCluster> clusters;
+    for(size_t c = 0; c + 1 < hardStarts.size(); c++) {
+        size_t start = hardStarts[c];
+        size_t end = hardStarts[c + 1];
+
+        resetFIFOCache(cache);
+        size_t clusterMisses = 0;
+        for(size_t t = start; t < end; t++) {
+            clusterMisses += touchFIFOCache(cache, &indices[t * 3]);
+        }
+        float clusterThreshold = threshold * (float)clusterMisses / (end - start);
+
+        resetFIFOCache(cache);
+        size_t runningMisses = 0;
+        size_t runningStart = start;
+        for(size_t t = start; t < end; t++) {
+            runningMisses += touchFIFOCache(cache, &indices[t * 3]);
+            if((float)runningMisses / (t + 1 - runningStart) <= clusterThreshold) {
+                clusters.push_back({runningStart, t + 1, 0.0f});
+                runningStart = t + 1;
+                runningMisses = 0;
+                resetFIFOCache(cache);
+            }
+        }
+        if(runningStart < end) {
+            clusters.push_back({runningStart, end, 0.0f});
+        }
+    }
+
+    // Area-weighted mesh centroid
+    glm::dvec3 meshCenter(0.0);
+    double meshArea = 0.0;
+    for(size_t t = 0; t < triCnt; t++) {
+        glm::vec3 p0 = positions[indices[t * 3]], p1 = positions[indices[t * 3 + 1]], p2 = positions[indices[t * 3 + 2]];
+        double area = glm::length(glm::cross(p1 - p0, p2 - p0));
+        meshCenter += glm::dvec3((p0 + p1 + p2) / 3.0f) * area;
+        meshArea += area;
+    }
+    meshCenter = (meshArea > 0.0) ? meshCenter / meshArea : glm::dvec3(0.0);
+
+    // Clusters far out along their own facing direction occlude the rest, so they go first
+    for(auto &cluster : clusters) {
+        glm::dvec3 center(0.0);
+        glm::dvec3 normal(0.0);
+        double area = 0.0;
+        for(size_t t = cluster.start; t < cluster.end; t++) {
+            glm::vec3 p0 = positions[indices[t * 3]], p1 = positions[indices[t * 3 + 1]], p2 = positions[indices[t * 3 + 2]];
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            double triArea = glm::length(n);
+            center += glm::dvec3((p0 + p1 + p2) / 3.0f) * triArea;
+            normal += glm::dvec3(n);
+            area += triArea;
+        }
+
+        double normalLength = glm::length(normal);
+        if(area > 0.0 && normalLength > 0.0) {
+            cluster.sortKey = (float)glm::dot(center / area - meshCenter, normal / normalLength);
+        }
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(),
+        [](const TriangleCluster &a, const TriangleCluster &b) {
+            return a.sortKey > b.sortKey;
+        });
+
+    vector<unsigned int> result;
+    result.reserve(triCnt * 3);
+    for(auto &cluster : clusters) {
+        result.insert(result.end(), indices.begin() + cluster.start * 3, indices.begin() + cluster.end * 3);
+    }
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// VERTEX FETCH
+///////////////////////////////////////////////////////////////////////////////
+
+vector<unsigned int> getVertexFetchRemap(const vector<unsigned int> &indices, size_t vertexCnt) {
+    const unsigned int unused = ~0u;
+    vector<unsigned int> remap(vertexCnt, unused);
+
+    unsigned int next = 0;
+    for(unsigned int index : indices) {
+        if(remap[index] == unused) {
+            remap[index] = next++;
+        }
+    }
+    for(auto &r : remap) {
+        if(r == unused) {
+            r = next++;
+        }
+    }
+    return remap;
+}
@@ -0,0 +1,308 @@
+#include "MeshSimplify.hpp"
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+
+///////////////////////////////////////////////////////////////////////////////
+// QUADRICS
+///////////////////////////////////////////////////////////////////////////////
+
+// Symmetric 4x4 matrix (upper triangle) of summed squared plane distances
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+    double a11 = 0, a12 = 0, a13 = 0;
+    double a22 = 0, a23 = 0;
+    double a33 = 0;
+};
+
+static void addQuadric(Quadric &q, const Quadric &other) {
+    q.a00 += other.a00; q.a01 += other.a01; q.a02 += other.a02; q.a03 += other.a03;
+    q.a11 += other.a11; q.a12 += other.a12; q.a13 += other.a13;
+    q.a22 += other.a22; q.a23 += other.a23;
+    q.a33 += other.a33;
+}
+
+static Quadric makePlaneQuadric(glm::dvec3 n, double d, double weight) {
+    Quadric q;
+    q.a00 = weight * n.x * n.x; q.a01 = weight * n.x * n.y; q.a02 = weight * n.x * n.z; q.a03 = weight * n.x * d;
+    q.a11 = weight * n.y * n.y; q.a12 = weight * n.y * n.z; q.a13 = weight * n.y * d;
+    q.a22 = weight * n.z * n.z; q.a23 = weight * n.z * d;
+    q.a33 = weight * d * d;
+    return q;
+}
+
+static double evalQuadric(const Quadric &q, const glm::vec3 &p) {
+    double x = p.x, y = p.y, z = p.z;
+    double result = q.a00 * x * x + 2 * q.a01 * x * y + 2 * q.a02 * x * z + 2 * q.a03 * x
+                    + q.a11 * y * y + 2 * q.a12 * y * z + 2 * q.a13 * y
+                    + q.a22 * z * z + 2 * q.a23 * z
+                    + q.a33;
+    return std::max(result, 0.0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// HELPERS
+///////////////////////////////////////////////////////////////////////////////
+
+struct PositionKey {
+    uint32_t x, y, z;
+    bool operator==(const PositionKey &other) const {
+        return x == other.x && y == other.y && z == other.z;
+    }
+};
+
+struct PositionKeyHash {
+    size_t operator()(const PositionKey &k) const {
+        return (size_t)k.x * 73856093u ^ (size_t)k.y * 19349663u ^ (size_t)k.z * 83492791u;
+    }
+};
+
+static PositionKey makePositionKey(const glm::vec3 &p) {
+    PositionKey key;
+    memcpy(&key.x, &p.x, sizeof(float));
+    memcpy(&key.y, &p.y, sizeof(float));
+    memcpy(&key.z, &p.z, sizeof(float));
+    return key;
+}
+
+static uint64_t makeEdgeKey(unsigned int a, unsigned int b) {
+    if(a > b) {
+        std::swap(a, b);
+    }
+    return ((uint64_t)a << 32) | b;
+}
+
+// Would moving vertex from to position to flip (or collapse) any of its triangles?
+static bool doesCollapseFlip(   const vector<glm::vec3> &positions,
+                                const vector<unsigned int> &indices,
+                                const vector<unsigned int> &triangles,
+                                unsigned int from, unsigned int to) {
+    const glm::vec3 &target = positions[to];
+    for(unsigned int tri : triangles) {
+        unsigned int i0 = indices[tri * 3 + 0];
+        unsigned int i1 = indices[tri * 3 + 1];
+        unsigned int i2 = indices[tri * 3 + 2];
+
+        // Triangles with both ends of the edge disappear
+        if(i0 == to || i1 == to || i2 == to) {
+            continue;
+        }
+
+        glm::vec3 p0 = positions[i0], p1 = positions[i1], p2 = positions[i2];
+        glm::vec3 before = glm::cross(p1 - p0, p2 - p0);
+        if(i0 == from) p0 = target;
+        if(i1 == from) p1 = target;
+        if(i2 == from) p2 = target;
+        glm::vec3 after = glm::cross(p1 - p0, p2 - p0);
+
+        if(glm::dot(before, after) <= 0.0f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SIMPLIFICATION
+///////////////////////////////////////////////////////////////////////////////
+
+struct Collapse {
+    unsigned int from;
+    unsigned int to;
+    double cost;
+};
+
+vector<unsigned int> simplifyMeshIndices(   const vector<glm::vec3> &positions,
+                                            const vector<unsigned int> &indices,
+                                            size_t targetIndexCnt,
+                                            float *outError) {
+    vector<unsigned int> result = indices;
+    size_t vertexCnt = positions.size();
+    double maxCost = 0.0;
+
+    // Vertices sharing a position (attribute seams) all map to the first one
+    vector<unsigned int> positionIds(vertexCnt);
+    vector<unsigned int> positionUseCnt(vertexCnt, 0);
+    unordered_map<PositionKey, unsigned int, PositionKeyHash> positionLookup;
+    for(unsigned int v = 0; v < vertexCnt; v++) {
+        auto it = positionLookup.emplace(makePositionKey(positions[v]), v).first;
+        positionIds[v] = it->second;
+        positionUseCnt[it->second]++;
+    }
+
+    // Seams and borders stay put
+    vector<uint8_t> locked(vertexCnt, 0);
+    for(unsigned int v = 0; v < vertexCnt; v++) {
+        if(positionUseCnt[positionIds[v]] > 1) {
+            locked[v] = 1;
+        }
+    }
+
+    unordered_map<uint64_t, unsigned int> edgeUseCnt;
+    for(size_t t = 0; t + 2 < result.size(); t += 3) {
+        for(int e = 0; e < 3; e++) {
+            unsigned int a = positionIds[result[t + e]];
+            unsigned int b = positionIds[result[t + (e + 1) % 3]];
+            edgeUseCnt[makeEdgeKey(a, b)]++;
+        }
+    }
+    for(size_t t = 0; t + 2 < result.size(); t += 3) {
+        for(int e = 0; e < 3; e++) {
+            unsigned int a = result[t + e];
+            unsigned int b = result[t + (e + 1) % 3];
+            if(edgeUseCnt[makeEdgeKey(positionIds[a], positionIds[b])] == 1) {
+                locked[a] = 1;
+                locked[b] = 1;
+            }
+        }
+    }
+
+    // Quadric per vertex (sum of its triangles' planes, weighted by area)
+    vector<Quadric> quadrics(vertexCnt);
+    for(size_t t = 0; t + 2 < result.size(); t += 3) {
+        glm::dvec3 p0 = positions[result[t]], p1 = positions[result[t + 1]], p2 = positions[result[t + 2]];
+        glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+        double area2 = glm::length(n);
+        if(area2 <= 0.0) {
+            continue;
+        }
+        n /= area2;
+
+        Quadric q = makePlaneQuadric(n, -glm::dot(n, p0), area2 * 0.5);
+        for(int k = 0; k < 3; k++) {
+            addQuadric(quadrics[result[t + k]], q);
+        }
+    }
+
+    vector<unsigned int> remap(vertexCnt);
+    vector<uint8_t> touched(vertexCnt);
+    vector<Collapse> collapses;
+    vector<vector<unsigned int>> vertexTriangles(vertexCnt);
+
+    // Each pass collapses the cheapest edges that don't touch each other
+    while(result.size() > targetIndexCnt) {
+        size_t triangleCnt = result.size() / 3;
+
+        for(auto &list : vertexTriangles) {
+            list.clear();
+        }
+        for(unsigned int t = 0; t < triangleCnt; t++) {
+            for(int k = 0; k < 3; k++) {
+                vertexTriangles[result[t * 3 + k]].push_back(t);
+            }
+        }
+
+        // Candidate collapses (either direction of every edge, cost at the kept end)
+        collapses.clear();
+        for(unsigned int t = 0; t < triangleCnt; t++) {
+            for(int e = 0; e < 3; e++) {
+                unsigned int a = result[t * 3 + e];
+                unsigned int b = result[t * 3 + (e + 1) % 3];
+
+                Quadric q = quadrics[a];
+                addQuadric(q, quadrics[b]);
+
+                if(!locked[a]) {
+                    collapses.push_back({a, b, evalQuadric(q, positions[b])});
+                }
+                if(!locked[b]) {
+                    collapses.push_back({b, a, evalQuadric(q, positions[a])});
+                }
+            }
+        }
+
+        if(collapses.empty()) {
+            break;
+        }
+
+        std::sort(collapses.begin(), collapses.end(), 
+                    [](const Collapse &x, const Collapse &y) { return x.cost < y.cost; });
+
+        for(unsigned int v = 0; v < vertexCnt; v++) {
+            remap[v] = v;
+        }
+        std::fill(touched.begin(), touched.end(), 0);
+
+        // Each collapse removes about two triangles; stop once the target is reached
+        size_t trianglesLeft = triangleCnt;
+        size_t targetTriangles = targetIndexCnt / 3;
+        unsigned int collapseCnt = 0;
+
+        // Don't let one pass eat all of the cheap edges
+        size_t passLimit = std::max<size_t>(collapses.size() / 6, 1);
+
+        for(size_t c = 0; c < collapses.size() && c < passLimit; c++) {
+            if(trianglesLeft <= targetTriangles) {
+                break;
+            }
+
+            Collapse &collapse = collapses[c];
+            if(touched[collapse.from] || touched[collapse.to]) {
+                continue;
+            }
+
+            if(doesCollapseFlip(positions, result, vertexTriangles[collapse.from], 
+                                collapse.from, collapse.to)) {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+            maxCost = std::max(maxCost, collapse.cost);
+
+            // Neighbors' triangles just changed, so leave them for the next pass
+            for(unsigned int tri : vertexTriangles[collapse.from]) {
+                for(int k = 0; k < 3; k++) {
+                    touched[result[tri * 3 + k]] = 1;
+                }
+            }
+
+            // Triangles sharing the edge go away
+            for(unsigned int tri : vertexTriangles[collapse.from]) {
+                for(int k = 0; k < 3; k++) {
+                    if(result[tri * 3 + k] == collapse.to) {
+                        trianglesLeft--;
+                        break;
+                    }
+                }
+            }
+
+            collapseCnt++;
+        }
+
+        if(collapseCnt == 0) {
+            break;
+        }
+
+        // Apply and drop degenerate triangles
+        size_t write = 0;
+        for(size_t t = 0; t < triangleCnt; t++) {
+            unsigned int i0 = remap[result[t * 3 + 0]];
+            unsigned int i1 = remap[result[t * 3 + 1]];
+            unsigned int i2 = remap[result[t * 3 + 2]];
+            if(i0 == i1 || i1 == i2 || i0 == i2) {
+                continue;
+            }
+            result[write++] = i0;
+            result[write++] = i1;
+            result[write++] = i2;
+        }
+        result.resize(write);
+    }
+
+    if(outError) {
+        // Quadric costs are area-weighted squared distances; normalize by the
+        // mesh's average triangle area to get back to a distance
+        double totalArea = 0.0;
+        for(size_t t = 0; t + 2 < indices.size(); t += 3) {
+            glm::vec3 p0 = positions[indices[t]], p1 = positions[indices[t + 1]], p2 = positions[indices[t + 2]];
+            totalArea += 0.5 * glm::length(glm::cross(p1 - p0, p2 - p0));
+        }
+        double avgArea = (indices.size() >= 3) ? totalArea / (indices.size() / 3) : 1.0;
+        *outError = (float)sqrt(maxCost / std::max(avgArea, 1e-12));
+    }
+
+    return result;
+}
@@ -0,0 +1,92 @@
+#include "SceneGraph.hpp"
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// IMPORT
+///////////////////////////////////////////////////////////////////////////////
+
+static void addSceneNode(SceneGraph &graph, aiNode *node, int parentIndex, unsigned int depth) {
+    unsigned int index = static_cast<unsigned int>(graph.parent.size());
+
+    glm::mat4 local;
+    aiMatToGLM4(node->mTransformation, local);
+
+    graph.parent.push_back(parentIndex);
+    graph.depth.push_back(depth);
+    graph.subtreeEnd.push_back(index + 1);
+    graph.names.push_back(string(node->mName.C_Str()));
+    graph.local.push_back(local);
+
+    graph.meshStart.push_back(static_cast<unsigned int>(graph.meshIndices.size()));
+    graph.meshCnt.push_back(node->mNumMeshes);
+    for(unsigned int i = 0; i < node->mNumMeshes; i++) {
+        graph.meshIndices.push_back(node->mMeshes[i]);
+    }
+
+    // Depth-first, so children follow their parent
+    for(unsigned int i = 0; i < node->mNumChildren; i++) {
+        addSceneNode(graph, node->mChildren[i], static_cast<int>(index), depth + 1);
+    }
+
+    graph.subtreeEnd[index] = static_cast<unsigned int>(graph.parent.size());
+}
+
+SceneGraph createSceneGraph(const aiScene *scene) {
+    SceneGraph graph;
+    if(scene && scene->mRootNode) {
+        addSceneNode(graph, scene->mRootNode, -1, 0);
+    }
+
+    completeSceneGraph(graph);
+    return graph;
+}
+
+void completeSceneGraph(SceneGraph &graph) {
+    size_t nodeCnt = graph.parent.size();
+    graph.world.assign(nodeCnt, glm::mat4(1.0f));
+    graph.normalWorld.assign(nodeCnt, glm::mat3(1.0f));
+    graph.dirty.assign(nodeCnt, 1);
+
+    // Compute every world matrix once
+    graph.anyDirty = true;
+    updateSceneGraph(graph);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// UPDATES
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int getSceneNodeCnt(SceneGraph &graph) {
+    return static_cast<unsigned int>(graph.parent.size());
+}
+
+void setSceneNodeLocal(SceneGraph &graph, unsigned int node, const glm::mat4 &local) {
+    graph.local.at(node) = local;
+    graph.dirty.at(node) = 1;
+    graph.anyDirty = true;
+}
+
+void updateSceneGraph(SceneGraph &graph) {
+    if(!graph.anyDirty) {
+        return;
+    }
+
+    // Parents come first, so a dirty parent has already been updated
+    // (and has passed its dirty flag down) by the time we reach a child
+    unsigned int nodeCnt = getSceneNodeCnt(graph);
+    for(unsigned int i = 0; i < nodeCnt; i++) {
+        int p = graph.parent[i];
+        if(p >= 0 && graph.dirty[p]) {
+            graph.dirty[i] = 1;
+        }
+        if(!graph.dirty[i]) {
+            continue;
+        }
+
+        graph.world[i] = (p >= 0) ? graph.world[p] * graph.local[i] : graph.local[i];
+        graph.normalWorld[i] = glm::transpose(glm::inverse(glm::mat3(graph.world[i])));
+    }
+
+    std::fill(graph.dirty.begin(), graph.dirty.end(), 0);
+    graph.anyDirty = false;
+}
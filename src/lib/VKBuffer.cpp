@@ -1,29 +1,38 @@
 #include "VKBuffer.hpp"
 
 ///////////////////////////////////////////////////////////////////////////////
-// MEMORY QUERIES
+// OWNERSHIP
 ///////////////////////////////////////////////////////////////////////////////
 
-unsigned int findMemoryType(unsigned int typeFilter, 
-                            vk::MemoryPropertyFlags properties, 
-                            vk::PhysicalDevice physicalDevice) {
+VulkanBuffer::VulkanBuffer(VulkanBuffer &&other) noexcept {
+    *this = std::move(other);
+}
 
-    // Get the memory properites from the physical device                        
-    vk::PhysicalDeviceMemoryProperties memProperties = physicalDevice.getMemoryProperties();
+VulkanBuffer& VulkanBuffer::operator=(VulkanBuffer &&other) noexcept {
+    if(this != &other) {
+        // Release whatever we held before taking over
+        if(buffer) {
+            cleanupVulkanBuffer(deleter.device, *this);
+        }
 
-    // Loop through the properties to find a match in terms of the type and the properties
-    for (unsigned int i = 0; i < memProperties.memoryTypeCount; i++) {
-        unsigned int currentTypeBit = (1 << i);
-        bool matchType = typeFilter & currentTypeBit;
-        bool propEqual = ((memProperties.memoryTypes[i].propertyFlags & properties) == properties);
+        buffer = other.buffer;
+        allocation = other.allocation;
+        size = other.size;
+        usage = other.usage;
+        deleter = other.deleter;
 
-        if (matchType && propEqual) {
-            return i;
-        }
+        // Moved-from buffer owns nothing
+        other.buffer = nullptr;
+        other.allocation = VulkanAllocation();
+        other.size = 0;
     }
+    return *this;
+}
 
-    // If we are here, throw an exception
-    throw runtime_error("findMemoryType: Failed to find suitable memory type!");
+VulkanBuffer::~VulkanBuffer() {
+    if(buffer) {
+        cleanupVulkanBuffer(deleter.device, *this);
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -34,10 +43,14 @@ VulkanBuffer createVulkanBuffer(vk::PhysicalDevice &physicalDevice,
                                 vk::Device &device,
                                 vk::DeviceSize size,
                                 vk::BufferUsageFlags usage,
-                                vk::MemoryPropertyFlags properties) {
+                                vk::MemoryPropertyFlags properties,
+                                VulkanMemoryTag tag) {
 
     // Set up struct
     VulkanBuffer data;
+    data.size = size;
+    data.usage = usage;
+    data.deleter.device = device;
 
     // Create buffer (memory not allocated YET)
     data.buffer = device.createBuffer(  vk::BufferCreateInfo(vk::BufferCreateFlags(), size, usage, 
@@ -46,27 +59,24 @@ VulkanBuffer createVulkanBuffer(vk::PhysicalDevice &physicalDevice,
     // Get memory requirements
     vk::MemoryRequirements memRequirements = device.getBufferMemoryRequirements(data.buffer);
 
-    // Set up allocation info
-    vk::MemoryAllocateInfo allocInfo(
-        memRequirements.size, 
-        findMemoryType(memRequirements.memoryTypeBits, properties, physicalDevice));
-        
-    // Actually allocate memory
-    data.memory = device.allocateMemory(allocInfo);
+    // Grab a range from a shared memory block
+    data.allocation = allocateVulkanMemory(physicalDevice, device, memRequirements, properties, false, tag);
 
     // Bind the memory
-    device.bindBufferMemory(data.buffer, data.memory, 0);
+    device.bindBufferMemory(data.buffer, data.allocation.memory, data.allocation.offset);
 
     // Return data
     return data;
 }
 
-void copyDataToVulkanBuffer(vk::Device &device, vk::DeviceMemory memory, 
+void copyDataToVulkanBuffer(vk::Device &device, VulkanBuffer &dst, 
                             size_t bufferSize, void *hostData) {
-                                
-    void* data = device.mapMemory(memory, 0, bufferSize);
-    memcpy(data, hostData, (size_t) bufferSize);
-    device.unmapMemory(memory);
+
+    // Host-visible blocks are already mapped by the allocator
+    if(!dst.allocation.mapped) {
+        throw runtime_error("copyDataToVulkanBuffer: Buffer memory is not host-visible!");
+    }
+    memcpy(dst.allocation.mapped, hostData, bufferSize);
 }
 
 void copyBufferToVulkanBuffer(  vk::Device &device, vk::CommandPool &commandPool,
@@ -84,28 +94,24 @@ void copyBufferToVulkanBuffer(  vk::Device &device, vk::CommandPool &commandPool
     stopAndCleanupOneTimeVulkanCommandBuffer(device, commandPool, oneTimeBuffer, graphicsQueue);      
 }
 
-void copyDataToVulkanBufferViaStaging(  vk::PhysicalDevice &physicalDevice,
-                                        vk::Device &device, 
-                                        vk::CommandPool &commandPool,
-                                        vk::Queue &graphicsQueue,
-                                        VulkanBuffer &dst, 
-                                        vk::DeviceSize size,
-                                        void *data) {
-
-    // Create staging buffer on CPU side and copy data to it
-    VulkanBuffer stageBuffer = createVulkanBuffer(physicalDevice, device, size,
-                                    vk::BufferUsageFlagBits::eTransferSrc,
-                                    vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-    copyDataToVulkanBuffer(device, stageBuffer.memory, size, data);      
-
-    // Copy data to ACTUAL buffer using queue
-    copyBufferToVulkanBuffer(device, commandPool, graphicsQueue, stageBuffer, dst, size);
-
-    // Cleanup staging buffer    
-    cleanupVulkanBuffer(device, stageBuffer);
-}
-
 void cleanupVulkanBuffer(vk::Device &device, VulkanBuffer &data) {
-    device.destroyBuffer(data.buffer);
-    device.freeMemory(data.memory);
+    if(data.deleter.deletionQueue && data.buffer) {
+        // Frames in flight may still use it, so destroy it later
+        vk::Device queueDevice = device;
+        vk::Buffer buffer = data.buffer;
+        VulkanAllocation allocation = data.allocation;
+        deferVulkanDeletion(*data.deleter.deletionQueue, [queueDevice, buffer, allocation]() mutable {
+            queueDevice.destroyBuffer(buffer);
+            freeVulkanMemory(queueDevice, allocation);
+        });
+    }
+    else {
+        device.destroyBuffer(data.buffer);
+        freeVulkanMemory(device, data.allocation);
+    }
+
+    // Nothing left to own
+    data.buffer = nullptr;
+    data.allocation = VulkanAllocation();
+    data.size = 0;
 }
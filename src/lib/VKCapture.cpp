@@ -0,0 +1,263 @@
+#include "VKCapture.hpp"
+#include <cstdio>
+#include <algorithm>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// WORKERS
+///////////////////////////////////////////////////////////////////////////////
+
+static void writeVulkanCaptureSlot(VulkanCaptureRing &ring, VulkanCaptureSlot &slot) {
+    unsigned int pixelCnt = slot.width * slot.height;
+    const unsigned char *src = static_cast<const unsigned char*>(slot.buffer.allocation.mapped);
+
+    // stb wants RGBA
+    vector<unsigned char> pixels(src, src + pixelCnt * 4);
+    if(slot.swapRedBlue) {
+        for(unsigned int i = 0; i < pixelCnt; i++) {
+            swap(pixels[i*4 + 0], pixels[i*4 + 2]);
+        }
+    }
+
+    // Presented images are opaque
+    for(unsigned int i = 0; i < pixelCnt; i++) {
+        pixels[i*4 + 3] = 255;
+    }
+
+    if(stbi_write_png(slot.filename.c_str(), slot.width, slot.height, 4, pixels.data(), slot.width * 4)) {
+        ring.savedCnt++;
+    }
+    else {
+        cerr << "VulkanCapture: Failed to write " << slot.filename << endl;
+    }
+}
+
+static void runVulkanCaptureWorker(VulkanCaptureRing *ring) {
+    while(true) {
+        VulkanCaptureSlot *slot = nullptr;
+        {
+            unique_lock<mutex> guard(ring->jobLock);
+            ring->jobReady.wait(guard, [ring]() { return ring->stopping || !ring->jobs.empty(); });
+            if(ring->jobs.empty()) {
+                return;     // Stopping and nothing left to do
+            }
+            slot = ring->jobs.front();
+            ring->jobs.pop_front();
+        }
+
+        writeVulkanCaptureSlot(*ring, *slot);
+        slot->state.store(VulkanCaptureState::Free);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SETUP
+///////////////////////////////////////////////////////////////////////////////
+
+void createVulkanCaptureRing(   VulkanInitData &vkInitData,
+                                VulkanCaptureRing &ring,
+                                vk::CommandPool &commandPool,
+                                unsigned int slotCnt,
+                                unsigned int workerCnt) {
+    ring.commandPool = commandPool;
+
+    // Readback buffers are created on first use (so they match the image size)
+    for(unsigned int i = 0; i < slotCnt; i++) {
+        auto slot = make_unique<VulkanCaptureSlot>();
+        slot->commandBuffer = createVulkanCommandBuffer(vkInitData.device, commandPool);
+        ring.slots.push_back(std::move(slot));
+    }
+
+    ring.stopping = false;
+    for(unsigned int i = 0; i < workerCnt; i++) {
+        ring.workers.push_back(thread(runVulkanCaptureWorker, &ring));
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// REQUESTS
+///////////////////////////////////////////////////////////////////////////////
+
+void requestVulkanCapture(VulkanCaptureRing &ring, string filename) {
+    ring.singleFilename = filename;
+}
+
+void requestVulkanCaptureSequence(VulkanCaptureRing &ring, string filenamePrefix, unsigned int frameCnt) {
+    ring.sequencePrefix = filenamePrefix;
+    ring.sequenceRemaining = frameCnt;
+    ring.sequenceIndex = 0;
+}
+
+bool isVulkanCaptureRequested(VulkanCaptureRing &ring) {
+    return !ring.singleFilename.empty() || ring.sequenceRemaining > 0;
+}
+
+// Pick the file name for this frame (and consume the request)
+static string nextVulkanCaptureFilename(VulkanCaptureRing &ring) {
+    if(!ring.singleFilename.empty()) {
+        string filename = ring.singleFilename;
+        ring.singleFilename.clear();
+        return filename;
+    }
+
+    char number[16];
+    snprintf(number, sizeof(number), "%05u", ring.sequenceIndex);
+    ring.sequenceIndex++;
+    ring.sequenceRemaining--;
+    return ring.sequencePrefix + "_" + string(number) + ".png";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// RECORDING
+///////////////////////////////////////////////////////////////////////////////
+
+vk::CommandBuffer recordVulkanCapture(  VulkanInitData &vkInitData,
+                                        VulkanCaptureRing &ring,
+                                        unsigned int frameSlot,
+                                        unsigned int imageIndex) {
+    if(!isVulkanCaptureRequested(ring)) {
+        return nullptr;
+    }
+
+    // Only 8-bit RGBA/BGRA can be written directly
+    vk::Format format = vkInitData.swapchain.format;
+    bool isBGRA = (format == vk::Format::eB8G8R8A8Unorm || format == vk::Format::eB8G8R8A8Srgb);
+    bool isRGBA = (format == vk::Format::eR8G8B8A8Unorm || format == vk::Format::eR8G8B8A8Srgb);
+    if(!isBGRA && !isRGBA) {
+        cerr << "VulkanCapture: Unsupported image format " << vk::to_string(format) << endl;
+        ring.singleFilename.clear();
+        ring.sequenceRemaining = 0;
+        return nullptr;
+    }
+
+    // Find a free readback buffer (drop the frame rather than wait)
+    VulkanCaptureSlot *slot = nullptr;
+    for(auto &candidate : ring.slots) {
+        if(candidate->state.load() == VulkanCaptureState::Free) {
+            slot = candidate.get();
+            break;
+        }
+    }
+
+    string filename = nextVulkanCaptureFilename(ring);
+    if(!slot) {
+        ring.droppedCnt++;
+        return nullptr;
+    }
+
+    vk::Extent2D extent = vkInitData.swapchain.extent;
+    vk::DeviceSize imageSize = vk::DeviceSize(extent.width) * extent.height * 4;
+
+    // (Re)create readback buffer if the image got bigger
+    if(!slot->buffer.buffer || slot->buffer.size < imageSize) {
+        slot->buffer = createVulkanBuffer(  vkInitData.physicalDevice, vkInitData.device, imageSize,
+                                            vk::BufferUsageFlagBits::eTransferDst,
+                                            vk::MemoryPropertyFlagBits::eHostVisible 
+                                            | vk::MemoryPropertyFlagBits::eHostCoherent,
+                                            VulkanMemoryTag::Staging);
+    }
+
+    slot->filename = filename;
+    slot->width = extent.width;
+    slot->height = extent.height;
+    slot->swapRedBlue = isBGRA;
+    slot->frameSlot = frameSlot;
+    slot->state.store(VulkanCaptureState::Copying);
+
+    // Image is presentable (window) or ready for transfer (headless)
+    vk::Image image = vkInitData.swapchain.images.at(imageIndex);
+    vk::ImageLayout finalLayout = vkInitData.headless ? vk::ImageLayout::eTransferSrcOptimal 
+                                                        : vk::ImageLayout::ePresentSrcKHR;
+    vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+
+    vk::CommandBuffer &commandBuffer = slot->commandBuffer;
+    commandBuffer.reset();
+    commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+    // Wait for rendering to finish writing the image
+    vk::ImageMemoryBarrier toTransfer(  vk::AccessFlagBits::eColorAttachmentWrite,
+                                        vk::AccessFlagBits::eTransferRead,
+                                        finalLayout, vk::ImageLayout::eTransferSrcOptimal,
+                                        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                                        image, range);
+    commandBuffer.pipelineBarrier(  vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                                    vk::PipelineStageFlagBits::eTransfer,
+                                    {}, {}, {}, toTransfer);
+
+    vk::BufferImageCopy region(0, 0, 0, 
+                                vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1),
+                                vk::Offset3D(0, 0, 0), vk::Extent3D(extent, 1));
+    commandBuffer.copyImageToBuffer(image, vk::ImageLayout::eTransferSrcOptimal, slot->buffer.buffer, region);
+
+    // Back to presentable, and make the copy visible to the host
+    vk::ImageMemoryBarrier toFinal( vk::AccessFlagBits::eTransferRead, {},
+                                    vk::ImageLayout::eTransferSrcOptimal, finalLayout,
+                                    VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                                    image, range);
+    vk::BufferMemoryBarrier toHost( vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead,
+                                    VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                                    slot->buffer.buffer, 0, imageSize);
+    commandBuffer.pipelineBarrier(  vk::PipelineStageFlagBits::eTransfer,
+                                    vk::PipelineStageFlagBits::eHost | vk::PipelineStageFlagBits::eBottomOfPipe,
+                                    {}, {}, toHost, toFinal);
+
+    commandBuffer.end();
+    return commandBuffer;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// COMPLETION
+///////////////////////////////////////////////////////////////////////////////
+
+void completeVulkanCaptures(VulkanCaptureRing &ring, unsigned int frameSlot) {
+    lock_guard<mutex> guard(ring.jobLock);
+
+    bool queued = false;
+    for(auto &slot : ring.slots) {
+        if(slot->state.load() == VulkanCaptureState::Copying && slot->frameSlot == frameSlot) {
+            slot->state.store(VulkanCaptureState::Encoding);
+            ring.jobs.push_back(slot.get());
+            queued = true;
+        }
+    }
+
+    if(queued) {
+        ring.jobReady.notify_all();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CLEANUP
+///////////////////////////////////////////////////////////////////////////////
+
+void cleanupVulkanCaptureRing(VulkanInitData &vkInitData, VulkanCaptureRing &ring) {
+    // Every copy is done (device is idle), so hand them all to the workers
+    {
+        lock_guard<mutex> guard(ring.jobLock);
+        for(auto &slot : ring.slots) {
+            if(slot->state.load() == VulkanCaptureState::Copying) {
+                slot->state.store(VulkanCaptureState::Encoding);
+                ring.jobs.push_back(slot.get());
+            }
+        }
+        ring.stopping = true;
+    }
+    ring.jobReady.notify_all();
+
+    // Workers drain the queue before they exit
+    for(auto &worker : ring.workers) {
+        worker.join();
+    }
+    ring.workers.clear();
+
+    if(ring.droppedCnt.load() > 0) {
+        cout << "VulkanCapture: " << ring.droppedCnt.load() << " frame(s) dropped (all readback buffers busy)." << endl;
+    }
+
+    for(auto &slot : ring.slots) {
+        vkInitData.device.freeCommandBuffers(ring.commandPool, slot->commandBuffer);
+        cleanupVulkanBuffer(vkInitData.device, slot->buffer);
+    }
+    ring.slots.clear();
+}
@@ -0,0 +1,293 @@
+#include "VKCompactor.hpp"
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// SETUP
+///////////////////////////////////////////////////////////////////////////////
+
+VulkanMeshCompactor createVulkanMeshCompactor(  VulkanInitData &vkInitData,
+                                                vk::DeviceSize bytesPerFrame,
+                                                unsigned int framesInFlight) {
+    VulkanMeshCompactor compactor;
+
+    // Copies go on the graphics queue (the queue that owns the mesh buffers)
+    compactor.queue = vkInitData.graphicsQueue;
+    compactor.commandPool = createVulkanCommandPool(vkInitData.device, compactor.queue.index);
+    compactor.bytesPerFrame = bytesPerFrame;
+    compactor.retired.framesToWait = framesInFlight;
+
+    return compactor;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// REGISTRATION
+///////////////////////////////////////////////////////////////////////////////
+
+static void retireVulkanCompactionBatches(VulkanInitData &vkInitData, VulkanMeshCompactor &compactor);
+
+static void registerReference(VulkanMeshCompactor &compactor, VulkanBuffer *ref) {
+    if(find(compactor.references.begin(), compactor.references.end(), ref) == compactor.references.end()) {
+        compactor.references.push_back(ref);
+    }
+}
+
+static bool isBufferMoving(VulkanMeshCompactor &compactor, vk::Buffer buffer) {
+    for(auto &move : compactor.copying) {
+        if(move.oldBuffer == buffer) {
+            return true;
+        }
+    }
+    for(auto &batch : compactor.inFlight) {
+        for(auto &move : batch.moves) {
+            if(move.oldBuffer == buffer) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void unregisterReference(VulkanInitData &vkInitData, VulkanMeshCompactor &compactor, VulkanBuffer *ref) {
+    // The buffer is about to be destroyed, so it can't still be a copy source
+    if(ref->buffer && isBufferMoving(compactor, ref->buffer)) {
+        for(auto &batch : compactor.inFlight) {
+            auto waitRes = vkInitData.device.waitForFences(1, &batch.fence, true, UINT64_MAX);
+            if(waitRes != vk::Result::eSuccess) {
+                throw runtime_error("unregisterReference: Timeout while waiting for compaction fence!");
+            }
+        }
+        retireVulkanCompactionBatches(vkInitData, compactor);
+
+        // Partly copied moves of it are dropped (no copy is running anymore)
+        vk::Buffer buffer = ref->buffer;
+        compactor.copying.erase(remove_if(compactor.copying.begin(), compactor.copying.end(),
+                                    [buffer](VulkanCompactionMove &move) { return move.oldBuffer == buffer; }),
+                                compactor.copying.end());
+    }
+
+    compactor.references.erase(remove(compactor.references.begin(), compactor.references.end(), ref),
+                                compactor.references.end());
+}
+
+void registerVulkanMeshForCompaction(VulkanMeshCompactor &compactor, VulkanMesh &mesh) {
+    registerReference(compactor, &mesh.vertices);
+    registerReference(compactor, &mesh.indices);
+}
+
+void registerVulkanMeshBuffersForCompaction(VulkanMeshCompactor &compactor, VulkanMeshBuffers &buffers) {
+    registerReference(compactor, &buffers.vertices);
+    registerReference(compactor, &buffers.indices);
+}
+
+void unregisterVulkanMeshFromCompaction(VulkanInitData &vkInitData, VulkanMeshCompactor &compactor, VulkanMesh &mesh) {
+    unregisterReference(vkInitData, compactor, &mesh.vertices);
+    unregisterReference(vkInitData, compactor, &mesh.indices);
+}
+
+void unregisterVulkanMeshBuffersFromCompaction( VulkanInitData &vkInitData, 
+                                                VulkanMeshCompactor &compactor, 
+                                                VulkanMeshBuffers &buffers) {
+    unregisterReference(vkInitData, compactor, &buffers.vertices);
+    unregisterReference(vkInitData, compactor, &buffers.indices);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// COMPACTION
+///////////////////////////////////////////////////////////////////////////////
+
+// Finished copies: point every reference at the new buffer
+static void retireVulkanCompactionBatches(VulkanInitData &vkInitData, VulkanMeshCompactor &compactor) {
+    while(!compactor.inFlight.empty()) {
+        VulkanCompactionBatch &batch = compactor.inFlight.front();
+        if(vkInitData.device.getFenceStatus(batch.fence) != vk::Result::eSuccess) {
+            break;
+        }
+
+        for(auto &move : batch.moves) {
+            VulkanBuffer *owner = nullptr;
+            for(VulkanBuffer *ref : compactor.references) {
+                if(ref->buffer == move.oldBuffer) {
+                    owner = ref;
+                    break;
+                }
+            }
+
+            // Nobody owns it anymore (mesh was unregistered mid-copy), 
+            // so the new buffer is just dropped
+            if(!owner) {
+                continue;
+            }
+
+            compactor.totalBytesMoved += move.newBuffer.size;
+            compactor.totalMoves++;
+
+            // Frames already recorded may still read the old buffer
+            VulkanBuffer oldBuffer = std::move(*owner);
+            oldBuffer.deleter.deletionQueue = &compactor.retired;
+            *owner = std::move(move.newBuffer);
+        }
+
+        vkInitData.device.freeCommandBuffers(compactor.commandPool, batch.commandBuffer);
+        cleanupVulkanFence(vkInitData.device, batch.fence);
+        compactor.inFlight.pop_front();
+    }
+}
+
+// Try to give a buffer a home in a fuller block
+static bool prepareVulkanCompactionMove(VulkanInitData &vkInitData, VulkanBuffer &oldBuffer, VulkanCompactionMove &move) {
+    // Same size and usage give the same requirements, so only create the new
+    // buffer once there is somewhere to put it (usually there isn't)
+    vk::MemoryRequirements memRequirements = vkInitData.device.getBufferMemoryRequirements(oldBuffer.buffer);
+
+    VulkanBuffer newBuffer;
+    if(!allocateVulkanMemoryInDenserBlock(vkInitData.device, memRequirements, oldBuffer.allocation, newBuffer.allocation)) {
+        return false;
+    }
+
+    newBuffer.size = oldBuffer.size;
+    newBuffer.usage = oldBuffer.usage;
+    newBuffer.deleter.device = vkInitData.device;
+    newBuffer.buffer = vkInitData.device.createBuffer(vk::BufferCreateInfo(vk::BufferCreateFlags(), 
+                                                        oldBuffer.size, oldBuffer.usage,
+                                                        vk::SharingMode::eExclusive));
+    vkInitData.device.bindBufferMemory(newBuffer.buffer, newBuffer.allocation.memory, newBuffer.allocation.offset);
+
+    move.oldBuffer = oldBuffer.buffer;
+    move.newBuffer = std::move(newBuffer);
+    return true;
+}
+
+// Picks buffers to move and gives them new homes (about bytesPerFrame worth)
+static void startVulkanCompactionMoves(VulkanInitData &vkInitData, VulkanMeshCompactor &compactor) {
+    // Candidates: unique buffers in sparse (shared) blocks that can be copied
+    vector<VulkanBuffer*> candidates;
+    for(VulkanBuffer *ref : compactor.references) {
+        VulkanMemoryBlock *block = ref->allocation.block;
+        if(!ref->buffer || !block || block->dedicated) {
+            continue;
+        }
+        if(!(ref->usage & vk::BufferUsageFlagBits::eTransferSrc)
+            || !(ref->usage & vk::BufferUsageFlagBits::eTransferDst)) {
+            continue;
+        }
+        if(getVulkanMemoryBlockOccupancy(block) >= compactor.maxOccupancy) {
+            continue;
+        }
+
+        bool seen = false;
+        for(VulkanBuffer *other : candidates) {
+            if(other->buffer == ref->buffer) {
+                seen = true;
+                break;
+            }
+        }
+        if(!seen) {
+            candidates.push_back(ref);
+        }
+    }
+
+    if(candidates.empty()) {
+        return;
+    }
+
+    // Empty the emptiest blocks first
+    sort(candidates.begin(), candidates.end(), [](VulkanBuffer *a, VulkanBuffer *b) {
+        return getVulkanMemoryBlockOccupancy(a->allocation.block) < getVulkanMemoryBlockOccupancy(b->allocation.block);
+    });
+
+    vk::DeviceSize bytesStarted = 0;
+    for(VulkanBuffer *ref : candidates) {
+        if(bytesStarted >= compactor.bytesPerFrame) {
+            break;
+        }
+
+        VulkanCompactionMove move;
+        if(prepareVulkanCompactionMove(vkInitData, *ref, move)) {
+            compactor.copying.push_back(std::move(move));
+            bytesStarted += ref->size;
+        }
+    }
+}
+
+void updateVulkanMeshCompactor(VulkanInitData &vkInitData, VulkanMeshCompactor &compactor) {
+    retireVulkanCompactionBatches(vkInitData, compactor);
+    updateVulkanDeletionQueue(compactor.retired);
+
+    // One batch at a time keeps the per-frame budget honest
+    if(!compactor.inFlight.empty()) {
+        return;
+    }
+
+    // Finish the moves already started before looking for new ones
+    if(compactor.copying.empty()) {
+        startVulkanCompactionMoves(vkInitData, compactor);
+    }
+    if(compactor.copying.empty()) {
+        return;
+    }
+
+    // Record at most bytesPerFrame of copies (big buffers take several updates)
+    VulkanCompactionBatch batch;
+    batch.commandBuffer = createVulkanCommandBuffer(vkInitData.device, compactor.commandPool);
+    batch.commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+    vk::DeviceSize bytesLeft = max(compactor.bytesPerFrame, (vk::DeviceSize)1);
+    for(auto &move : compactor.copying) {
+        if(bytesLeft == 0) {
+            break;
+        }
+
+        vk::DeviceSize chunk = min(bytesLeft, move.newBuffer.size - move.copiedBytes);
+        vk::BufferCopy region(move.copiedBytes, move.copiedBytes, chunk);
+        batch.commandBuffer.copyBuffer(move.oldBuffer, move.newBuffer.buffer, region);
+        move.copiedBytes += chunk;
+        bytesLeft -= chunk;
+    }
+
+    // Fully copied moves are applied when this batch's fence signals
+    for(auto it = compactor.copying.begin(); it != compactor.copying.end();) {
+        if(it->copiedBytes == it->newBuffer.size) {
+            batch.moves.push_back(std::move(*it));
+            it = compactor.copying.erase(it);
+        }
+        else {
+            it++;
+        }
+    }
+
+    // Later submissions on this queue read the new buffers as vertices/indices
+    vk::MemoryBarrier barrier(vk::AccessFlagBits::eTransferWrite,
+                                vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead);
+    batch.commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                        vk::PipelineStageFlagBits::eVertexInput,
+                                        {}, barrier, {}, {});
+    batch.commandBuffer.end();
+
+    batch.fence = vkInitData.device.createFence(vk::FenceCreateInfo());
+    vk::SubmitInfo submitInfo = vk::SubmitInfo().setCommandBuffers(batch.commandBuffer);
+    compactor.queue.queue.submit(submitInfo, batch.fence);
+
+    compactor.inFlight.push_back(std::move(batch));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CLEANUP
+///////////////////////////////////////////////////////////////////////////////
+
+void cleanupVulkanMeshCompactor(VulkanInitData &vkInitData, VulkanMeshCompactor &compactor) {
+    // Finish (and apply) whatever is still copying
+    for(auto &batch : compactor.inFlight) {
+        auto waitRes = vkInitData.device.waitForFences(1, &batch.fence, true, UINT64_MAX);
+        if(waitRes != vk::Result::eSuccess) {
+            throw runtime_error("cleanupVulkanMeshCompactor: Timeout while waiting for compaction fence!");
+        }
+    }
+    retireVulkanCompactionBatches(vkInitData, compactor);
+    compactor.copying.clear();
+
+    // Assumes the device is idle
+    flushVulkanDeletionQueue(compactor.retired);
+
+    cleanupVulkanCommandPool(vkInitData.device, compactor.commandPool);
+    compactor.references.clear();
+}
@@ -0,0 +1,124 @@
+#include "VKCompute.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// STORAGE BUFFERS
+///////////////////////////////////////////////////////////////////////////////
+
+VulkanBuffer createVulkanStorageBuffer( vk::PhysicalDevice &physicalDevice,
+                                        vk::Device &device,
+                                        vk::DeviceSize size,
+                                        vk::BufferUsageFlags extraUsage,
+                                        vk::MemoryPropertyFlags properties) {
+    return createVulkanBuffer(  physicalDevice, device, size,
+                                vk::BufferUsageFlagBits::eStorageBuffer | extraUsage,
+                                properties, VulkanMemoryTag::Storage);
+}
+
+VulkanBuffer queueVulkanStorageBufferUpload(VulkanUploadBatch &batch,
+                                            vk::DeviceSize size,
+                                            const void *data,
+                                            vk::BufferUsageFlags extraUsage) {
+    VulkanInitData &vkInitData = *batch.vkInitData;
+    VulkanBuffer buffer = createVulkanStorageBuffer(vkInitData.physicalDevice, vkInitData.device, size,
+                                                    extraUsage | vk::BufferUsageFlagBits::eTransferDst);
+    queueVulkanBufferUpload(batch, buffer, 0, size, data);
+    return buffer;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// COMPUTE PIPELINES
+///////////////////////////////////////////////////////////////////////////////
+
+vk::Pipeline createVulkanComputePipeline(   vk::Device &device,
+                                            const vector<char> &compShaderCode,
+                                            vk::PipelineLayout &pipelineLayout,
+                                            vk::PipelineCache cache) {
+    // Module is only needed until the pipeline is created
+    vk::ShaderModule compShaderModule = createVulkanShaderModule(device, compShaderCode);
+
+    vk::ComputePipelineCreateInfo pipelineInfo(
+        {},
+        vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eCompute, compShaderModule, "main"),
+        pipelineLayout);
+
+    auto result = device.createComputePipeline(cache, pipelineInfo);
+    device.destroyShaderModule(compShaderModule);
+
+    if(result.result != vk::Result::eSuccess) {
+        throw runtime_error("Failed to create compute pipeline!");
+    }
+
+    return result.value;
+}
+
+VulkanComputePipelineData createVulkanComputePipelineData(  vk::Device &device,
+                                                            string compSPVFilename,
+                                                            const vector<vk::DescriptorSetLayout> &descriptorSetLayouts,
+                                                            const vector<vk::PushConstantRange> &pushConstantRanges,
+                                                            vk::PipelineCache cache) {
+    VulkanComputePipelineData data;
+    data.pipelineLayout = device.createPipelineLayout(
+        vk::PipelineLayoutCreateInfo({}, descriptorSetLayouts, pushConstantRanges));
+
+    auto compShaderCode = readBinaryFile(compSPVFilename);
+    data.pipeline = createVulkanComputePipeline(device, compShaderCode, data.pipelineLayout, cache);
+    return data;
+}
+
+void cleanupVulkanComputePipelineData(vk::Device &device, VulkanComputePipelineData &data) {
+    device.destroyPipeline(data.pipeline);
+    device.destroyPipelineLayout(data.pipelineLayout);
+    data.pipeline = nullptr;
+    data.pipelineLayout = nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// DISPATCH
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t getVulkanDispatchGroupCnt(uint32_t itemCnt, uint32_t groupSize) {
+    return (itemCnt + groupSize - 1) / groupSize;
+}
+
+void recordVulkanDispatch(  vk::CommandBuffer &commandBuffer,
+                            VulkanComputePipelineData &data,
+                            const vector<vk::DescriptorSet> &descriptorSets,
+                            uint32_t groupCntX, uint32_t groupCntY, uint32_t groupCntZ) {
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, data.pipeline);
+    if(!descriptorSets.empty()) {
+        commandBuffer.bindDescriptorSets(   vk::PipelineBindPoint::eCompute, data.pipelineLayout,
+                                            0, descriptorSets, nullptr);
+    }
+    commandBuffer.dispatch(groupCntX, groupCntY, groupCntZ);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// BARRIERS
+///////////////////////////////////////////////////////////////////////////////
+
+void recordVulkanComputeToGraphicsBarrier(vk::CommandBuffer &commandBuffer) {
+    vk::MemoryBarrier barrier(
+        vk::AccessFlagBits::eShaderWrite,
+        vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eIndexRead 
+        | vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eUniformRead 
+        | vk::AccessFlagBits::eShaderRead);
+
+    commandBuffer.pipelineBarrier(
+        vk::PipelineStageFlagBits::eComputeShader,
+        vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput 
+        | vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader
+        | vk::PipelineStageFlagBits::eComputeShader,
+        {}, barrier, nullptr, nullptr);
+}
+
+
+void recordVulkanBufferBarrier( vk::CommandBuffer &commandBuffer, vk::Buffer buffer,
+                                vk::PipelineStageFlags srcStage, vk::AccessFlags srcAccess,
+                                vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess) {
+    vk::BufferMemoryBarrier barrier(
+        srcAccess, dstAccess,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+        buffer, 0, VK_WHOLE_SIZE);
+
+    commandBuffer.pipelineBarrier(srcStage, dstStage, {}, nullptr, barrier, nullptr);
+}
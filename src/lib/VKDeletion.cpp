@@ -0,0 +1,25 @@
+#include "VKDeletion.hpp"
+
+void deferVulkanDeletion(VulkanDeletionQueue &queue, function<void()> destroy) {
+    VulkanDeletion deletion;
+    deletion.frame = queue.frameCnt + queue.framesToWait;
+    deletion.destroy = std::move(destroy);
+    queue.pending.push_back(std::move(deletion));
+}
+
+void updateVulkanDeletionQueue(VulkanDeletionQueue &queue) {
+    queue.frameCnt++;
+
+    // Entries are in frame order
+    while(!queue.pending.empty() && queue.pending.front().frame <= queue.frameCnt) {
+        queue.pending.front().destroy();
+        queue.pending.pop_front();
+    }
+}
+
+void flushVulkanDeletionQueue(VulkanDeletionQueue &queue) {
+    while(!queue.pending.empty()) {
+        queue.pending.front().destroy();
+        queue.pending.pop_front();
+    }
+}
@@ -0,0 +1,472 @@
+#include "VKDrawList.hpp"
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+///////////////////////////////////////////////////////////////////////////////
+// SORT KEYS
+///////////////////////////////////////////////////////////////////////////////
+
+// Bits per state id in the key (ids past this wrap; only sort quality suffers)
+const unsigned int DRAW_KEY_ID_BITS = 10;
+const uint64_t DRAW_KEY_ID_MASK = (1ull << DRAW_KEY_ID_BITS) - 1;
+
+template<typename T>
+static uint64_t getHandleValue(T handle) {
+    typename T::CType cHandle = handle;
+    uint64_t value = 0;
+    memcpy(&value, &cHandle, sizeof(cHandle));
+    return value;
+}
+
+static uint64_t getStateId(unordered_map<uint64_t, uint32_t> &ids, uint64_t handle) {
+    auto it = ids.find(handle);
+    if(it != ids.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(ids.size());
+    ids[handle] = id & DRAW_KEY_ID_MASK;
+    return id & DRAW_KEY_ID_MASK;
+}
+
+// Non-negative floats keep their order when compared as integers
+static uint32_t getDepthBits(float viewDepth) {
+    if(!(viewDepth > 0.0f)) {
+        viewDepth = 0.0f;
+    }
+    uint32_t bits = 0;
+    memcpy(&bits, &viewDepth, sizeof(bits));
+    return bits;
+}
+
+static uint64_t makeDrawKey(VulkanDrawList &list, const VulkanDrawPacket &packet, 
+                            float viewDepth, VulkanDrawLayer layer) {
+    uint64_t pipelineId = getStateId(list.pipelineIds, getHandleValue(packet.pipeline));
+    uint64_t descriptorId = getStateId(list.descriptorIds, getHandleValue(packet.descriptorSet));
+    uint64_t bufferId = getStateId(list.bufferIds, 
+                            getHandleValue(packet.vertexBuffer) ^ (getHandleValue(packet.indexBuffer) << 1));
+    uint64_t depth = getDepthBits(viewDepth);
+    uint64_t key = static_cast<uint64_t>(layer) << 62;
+
+    if(layer == VulkanDrawLayer::Opaque) {
+        // State first, then front to back inside the same state
+        key |= pipelineId << 52;
+        key |= descriptorId << 42;
+        key |= bufferId << 32;
+        key |= depth;
+    }
+    else {
+        // Back to front comes first; depth is never negative, so the sign bit is 0
+        // and the other 31 bits fit in 30 by dropping the lowest mantissa bit
+        key |= (((~depth) & 0x7FFFFFFFull) >> 1) << 30;
+        key |= pipelineId << 20;
+        key |= descriptorId << 10;
+        key |= bufferId;
+    }
+
+    return key;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// DRAW LIST
+///////////////////////////////////////////////////////////////////////////////
+
+void beginVulkanDrawList(VulkanDrawList &list) {
+    list.packets.clear();
+    list.keys.clear();
+    list.order.clear();
+    list.pushData.clear();
+    list.pipelineIds.clear();
+    list.descriptorIds.clear();
+    list.bufferIds.clear();
+    list.instanceStride = 0;
+    list.instanceData.clear();
+    list.instancePackets.clear();
+    list.packetDepths.clear();
+    list.instanceBatches.clear();
+    list.instancedPackets.clear();
+}
+
+static void setVulkanDrawPacketRange(VulkanDrawPacket &packet, VulkanMesh &mesh, unsigned int lod) {
+    if(lod < mesh.lods.size()) {
+        packet.indexCnt = static_cast<uint32_t>(mesh.lods[lod].indexCnt);
+        packet.firstIndex = mesh.lods[lod].firstIndex;
+    }
+    else {
+        packet.indexCnt = static_cast<uint32_t>(mesh.indexCnt);
+        packet.firstIndex = mesh.firstIndex;
+    }
+    packet.vertexOffset = mesh.vertexOffset;
+}
+
+void setVulkanDrawPacketMesh(VulkanDrawPacket &packet, VulkanMeshBuffers &buffers, VulkanMesh &mesh, 
+                                unsigned int lod) {
+    packet.vertexBuffer = buffers.vertices.buffer;
+    packet.indexBuffer = buffers.indices.buffer;
+    packet.indexType = buffers.indexType;
+    setVulkanDrawPacketRange(packet, mesh, lod);
+}
+
+void setVulkanDrawPacketMesh(VulkanDrawPacket &packet, VulkanMesh &mesh, unsigned int lod) {
+    packet.vertexBuffer = mesh.vertices.buffer;
+    packet.indexBuffer = mesh.indices.buffer;
+    packet.indexType = mesh.indexType;
+    setVulkanDrawPacketRange(packet, mesh, lod);
+}
+
+void addVulkanDrawPacket(   VulkanDrawList &list, 
+                            VulkanDrawPacket packet,
+                            const void *pushData, uint32_t pushSize,
+                            float viewDepth, 
+                            VulkanDrawLayer layer) {
+    // Copy push data into the list
+    packet.pushOffset = static_cast<uint32_t>(list.pushData.size());
+    packet.pushSize = pushSize;
+    if(pushSize > 0) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(pushData);
+        list.pushData.insert(list.pushData.end(), bytes, bytes + pushSize);
+    }
+
+    list.keys.push_back(makeDrawKey(list, packet, viewDepth, layer));
+    list.order.push_back(static_cast<uint32_t>(list.packets.size()));
+    list.packetDepths.push_back(viewDepth);
+    list.packets.push_back(packet);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INSTANCING
+///////////////////////////////////////////////////////////////////////////////
+
+static uint64_t hashDrawValue(uint64_t value, uint64_t hash) {
+    // FNV-1a over the bytes of value
+    for(int i = 0; i < 8; i++) {
+        hash ^= (value >> (i * 8)) & 0xFF;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static uint64_t hashDrawState(const VulkanDrawPacket &packet) {
+    uint64_t hash = 14695981039346656037ull;
+    hash = hashDrawValue(getHandleValue(packet.pipeline), hash);
+    hash = hashDrawValue(getHandleValue(packet.pipelineLayout), hash);
+    hash = hashDrawValue(getHandleValue(packet.descriptorSet), hash);
+    for(uint32_t i = 0; i < packet.dynamicOffsetCnt; i++) {
+        hash = hashDrawValue(packet.dynamicOffsets[i], hash);
+    }
+    hash = hashDrawValue(getHandleValue(packet.vertexBuffer), hash);
+    hash = hashDrawValue(getHandleValue(packet.indexBuffer), hash);
+    hash = hashDrawValue(static_cast<uint64_t>(packet.indexType), hash);
+    hash = hashDrawValue(packet.indexCnt, hash);
+    hash = hashDrawValue(packet.firstIndex, hash);
+    hash = hashDrawValue(static_cast<uint32_t>(packet.vertexOffset), hash);
+    hash = hashDrawValue(packet.instanceBinding, hash);
+    return hash;
+}
+
+static bool isSameDrawState(const VulkanDrawPacket &a, const VulkanDrawPacket &b) {
+    return a.pipeline == b.pipeline
+        && a.pipelineLayout == b.pipelineLayout
+        && a.descriptorSet == b.descriptorSet
+        && a.dynamicOffsetCnt == b.dynamicOffsetCnt
+        && std::equal(a.dynamicOffsets.begin(), a.dynamicOffsets.begin() + a.dynamicOffsetCnt, 
+                        b.dynamicOffsets.begin())
+        && a.vertexBuffer == b.vertexBuffer
+        && a.indexBuffer == b.indexBuffer
+        && a.indexType == b.indexType
+        && a.indexCnt == b.indexCnt
+        && a.firstIndex == b.firstIndex
+        && a.vertexOffset == b.vertexOffset
+        && a.instanceBinding == b.instanceBinding;
+}
+
+void addVulkanDrawInstance( VulkanDrawList &list, 
+                            const VulkanDrawPacket &packet,
+                            const void *instanceData, uint32_t instanceSize,
+                            float viewDepth, 
+                            VulkanDrawLayer layer) {
+    if(list.instanceStride == 0) {
+        list.instanceStride = instanceSize;
+    }
+    else if(list.instanceStride != instanceSize) {
+        throw runtime_error("addVulkanDrawInstance: All instances in a draw list must be the same size!");
+    }
+
+    // Translucent instances stay separate so they can be sorted back to front
+    uint32_t packetIndex = UINT32_MAX;
+    uint64_t stateHash = 0;
+    if(layer == VulkanDrawLayer::Opaque) {
+        stateHash = hashDrawState(packet);
+        auto it = list.instanceBatches.find(stateHash);
+        if(it != list.instanceBatches.end() && isSameDrawState(list.packets[it->second], packet)) {
+            packetIndex = it->second;
+        }
+    }
+
+    if(packetIndex == UINT32_MAX) {
+        packetIndex = static_cast<uint32_t>(list.packets.size());
+        addVulkanDrawPacket(list, packet, nullptr, 0, viewDepth, layer);
+        list.packets[packetIndex].instanceCnt = 0;
+        list.instancedPackets.push_back(packetIndex);
+
+        if(layer == VulkanDrawLayer::Opaque) {
+            list.instanceBatches[stateHash] = packetIndex;
+        }
+    }
+    else if(viewDepth < list.packetDepths[packetIndex]) {
+        // Batch sorts by its nearest instance
+        list.packetDepths[packetIndex] = viewDepth;
+        list.keys[packetIndex] = makeDrawKey(list, list.packets[packetIndex], viewDepth, layer);
+    }
+
+    list.packets[packetIndex].instanceCnt++;
+    list.instancePackets.push_back(packetIndex);
+
+    const uint8_t *bytes = static_cast<const uint8_t *>(instanceData);
+    list.instanceData.insert(list.instanceData.end(), bytes, bytes + instanceSize);
+}
+
+void writeVulkanDrawListInstances(VulkanDrawList &list, VulkanFrameUniformAllocator &allocator) {
+    size_t instanceCnt = list.instancePackets.size();
+    if(instanceCnt == 0) {
+        return;
+    }
+
+    // One contiguous block for the whole list
+    uint32_t stride = list.instanceStride;
+    VulkanFrameUniformBlock block = allocateVulkanFrameUniform(allocator, stride * instanceCnt);
+
+    // Each instanced packet gets a run of instances
+    list.instanceCursors.assign(list.packets.size(), 0);
+    uint32_t nextInstance = 0;
+    for(uint32_t packetIndex : list.instancedPackets) {
+        VulkanDrawPacket &packet = list.packets[packetIndex];
+        packet.instanceBuffer = allocator.buffer.buffer;
+        packet.instanceBufferOffset = block.dynamicOffset;
+        packet.firstInstance = nextInstance;
+        list.instanceCursors[packetIndex] = nextInstance;
+        nextInstance += packet.instanceCnt;
+    }
+
+    // Scatter instances into their runs
+    char *dst = static_cast<char *>(block.mapped);
+    for(size_t i = 0; i < instanceCnt; i++) {
+        uint32_t slot = list.instanceCursors[list.instancePackets[i]]++;
+        memcpy(dst + (size_t)slot * stride, &list.instanceData[i * stride], stride);
+    }
+}
+
+void sortVulkanDrawList(VulkanDrawList &list) {
+    size_t cnt = list.keys.size();
+    if(cnt < 2) {
+        return;
+    }
+
+    list.keyScratch.resize(cnt);
+    list.orderScratch.resize(cnt);
+
+    uint64_t *keys = list.keys.data();
+    uint32_t *order = list.order.data();
+    uint64_t *keysOut = list.keyScratch.data();
+    uint32_t *orderOut = list.orderScratch.data();
+
+    // LSD radix sort, 8 bits per pass (stable, so equal keys keep submission order)
+    for(unsigned int shift = 0; shift < 64; shift += 8) {
+        size_t counts[256] = {};
+        for(size_t i = 0; i < cnt; i++) {
+            counts[(keys[i] >> shift) & 0xFF]++;
+        }
+
+        // Every key has the same byte here; nothing to move
+        if(counts[(keys[0] >> shift) & 0xFF] == cnt) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for(auto &count : counts) {
+            size_t c = count;
+            count = offset;
+            offset += c;
+        }
+
+        for(size_t i = 0; i < cnt; i++) {
+            size_t dst = counts[(keys[i] >> shift) & 0xFF]++;
+            keysOut[dst] = keys[i];
+            orderOut[dst] = order[i];
+        }
+
+        std::swap(keys, keysOut);
+        std::swap(order, orderOut);
+    }
+
+    // Results ended up in the scratch arrays
+    if(keys != list.keys.data()) {
+        list.keys.swap(list.keyScratch);
+        list.order.swap(list.orderScratch);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// COMMAND ENCODER
+///////////////////////////////////////////////////////////////////////////////
+
+void beginVulkanCommandEncoder(VulkanCommandEncoder &encoder, vk::CommandBuffer commandBuffer) {
+    encoder.commandBuffer = commandBuffer;
+    encoder.pipeline = nullptr;
+    encoder.pipelineLayout = nullptr;
+    encoder.descriptorSet = nullptr;
+    encoder.dynamicOffsetCnt = 0;
+    encoder.vertexBuffer = nullptr;
+    encoder.indexBuffer = nullptr;
+    encoder.indexType = vk::IndexType::eUint32;
+    encoder.instanceBuffer = nullptr;
+    encoder.instanceBufferOffset = 0;
+    encoder.pushStages = vk::ShaderStageFlags();
+    encoder.pushData.clear();
+    encoder.drawCnt = 0;
+    encoder.instanceCnt = 0;
+    encoder.bindCnt = 0;
+    encoder.skippedBindCnt = 0;
+}
+
+// Descriptor sets and push data only carry over while the layout is the same
+static void setEncoderLayout(VulkanCommandEncoder &encoder, vk::PipelineLayout pipelineLayout) {
+    if(encoder.pipelineLayout != pipelineLayout) {
+        encoder.pipelineLayout = pipelineLayout;
+        encoder.descriptorSet = nullptr;
+        encoder.dynamicOffsetCnt = 0;
+        encoder.pushData.clear();
+    }
+}
+
+void encodeVulkanBindPipeline(VulkanCommandEncoder &encoder, vk::Pipeline pipeline) {
+    if(encoder.pipeline == pipeline) {
+        encoder.skippedBindCnt++;
+        return;
+    }
+    encoder.commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+    encoder.pipeline = pipeline;
+    encoder.bindCnt++;
+}
+
+void encodeVulkanBindDescriptorSet( VulkanCommandEncoder &encoder, 
+                                    vk::PipelineLayout pipelineLayout,
+                                    vk::DescriptorSet descriptorSet,
+                                    const uint32_t *dynamicOffsets, uint32_t dynamicOffsetCnt) {
+    if(dynamicOffsetCnt > VULKAN_DRAW_MAX_DYNAMIC_OFFSETS) {
+        throw runtime_error("Too many dynamic offsets for command encoder!");
+    }
+
+    setEncoderLayout(encoder, pipelineLayout);
+
+    if(encoder.descriptorSet == descriptorSet 
+        && encoder.dynamicOffsetCnt == dynamicOffsetCnt
+        && std::equal(dynamicOffsets, dynamicOffsets + dynamicOffsetCnt, encoder.dynamicOffsets.begin())) {
+        encoder.skippedBindCnt++;
+        return;
+    }
+
+    encoder.commandBuffer.bindDescriptorSets(
+        vk::PipelineBindPoint::eGraphics, pipelineLayout, 0,
+        1, &descriptorSet, dynamicOffsetCnt, dynamicOffsets);
+
+    encoder.descriptorSet = descriptorSet;
+    encoder.dynamicOffsetCnt = dynamicOffsetCnt;
+    std::copy(dynamicOffsets, dynamicOffsets + dynamicOffsetCnt, encoder.dynamicOffsets.begin());
+    encoder.bindCnt++;
+}
+
+void encodeVulkanBindBuffers(   VulkanCommandEncoder &encoder, 
+                                vk::Buffer vertexBuffer, vk::Buffer indexBuffer, 
+                                vk::IndexType indexType) {
+    if(encoder.vertexBuffer == vertexBuffer) {
+        encoder.skippedBindCnt++;
+    }
+    else {
+        vk::DeviceSize offset = 0;
+        encoder.commandBuffer.bindVertexBuffers(0, 1, &vertexBuffer, &offset);
+        encoder.vertexBuffer = vertexBuffer;
+        encoder.bindCnt++;
+    }
+
+    if(encoder.indexBuffer == indexBuffer && encoder.indexType == indexType) {
+        encoder.skippedBindCnt++;
+    }
+    else {
+        encoder.commandBuffer.bindIndexBuffer(indexBuffer, 0, indexType);
+        encoder.indexBuffer = indexBuffer;
+        encoder.indexType = indexType;
+        encoder.bindCnt++;
+    }
+}
+
+void encodeVulkanBindInstanceBuffer(   VulkanCommandEncoder &encoder, uint32_t binding,
+                                        vk::Buffer instanceBuffer, vk::DeviceSize offset) {
+    // Tracks one instance binding (all this repo uses)
+    if(encoder.instanceBuffer == instanceBuffer && encoder.instanceBufferOffset == offset) {
+        encoder.skippedBindCnt++;
+        return;
+    }
+    encoder.commandBuffer.bindVertexBuffers(binding, 1, &instanceBuffer, &offset);
+    encoder.instanceBuffer = instanceBuffer;
+    encoder.instanceBufferOffset = offset;
+    encoder.bindCnt++;
+}
+
+void encodeVulkanPushConstants( VulkanCommandEncoder &encoder,
+                                vk::PipelineLayout pipelineLayout,
+                                vk::ShaderStageFlags stages,
+                                const void *data, uint32_t size) {
+    setEncoderLayout(encoder, pipelineLayout);
+
+    // Tracks one range starting at offset 0 (all this repo uses)
+    if(encoder.pushStages == stages 
+        && encoder.pushData.size() == size
+        && memcmp(encoder.pushData.data(), data, size) == 0) {
+        encoder.skippedBindCnt++;
+        return;
+    }
+
+    encoder.commandBuffer.pushConstants(pipelineLayout, stages, 0, size, data);
+
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    encoder.pushData.assign(bytes, bytes + size);
+    encoder.pushStages = stages;
+    encoder.bindCnt++;
+}
+
+void encodeVulkanDrawIndexed(   VulkanCommandEncoder &encoder, 
+                                uint32_t indexCnt, uint32_t firstIndex, int32_t vertexOffset,
+                                uint32_t instanceCnt, uint32_t firstInstance) {
+    encoder.commandBuffer.drawIndexed(indexCnt, instanceCnt, firstIndex, vertexOffset, firstInstance);
+    encoder.drawCnt++;
+    encoder.instanceCnt += instanceCnt;
+}
+
+void recordVulkanDrawList(VulkanCommandEncoder &encoder, VulkanDrawList &list) {
+    for(uint32_t packetIndex : list.order) {
+        VulkanDrawPacket &packet = list.packets[packetIndex];
+
+        encodeVulkanBindPipeline(encoder, packet.pipeline);
+
+        if(packet.descriptorSet) {
+            encodeVulkanBindDescriptorSet(  encoder, packet.pipelineLayout, packet.descriptorSet,
+                                            packet.dynamicOffsets.data(), packet.dynamicOffsetCnt);
+        }
+
+        encodeVulkanBindBuffers(encoder, packet.vertexBuffer, packet.indexBuffer, packet.indexType);
+
+        if(packet.pushSize > 0) {
+            encodeVulkanPushConstants(  encoder, packet.pipelineLayout, packet.pushStages,
+                                        &list.pushData[packet.pushOffset], packet.pushSize);
+        }
+
+        if(packet.instanceBuffer) {
+            encodeVulkanBindInstanceBuffer( encoder, packet.instanceBinding, 
+                                            packet.instanceBuffer, packet.instanceBufferOffset);
+        }
+
+        encodeVulkanDrawIndexed(encoder, packet.indexCnt, packet.firstIndex, packet.vertexOffset,
+                                packet.instanceCnt, packet.firstInstance);
+    }
+}
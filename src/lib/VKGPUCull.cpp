@@ -0,0 +1,265 @@
+#include "VKGPUCull.hpp"
+#include <cstring>
+#include <algorithm>
+
+const uint32_t GPU_CULL_GROUP_SIZE = 64;    // local_size_x in the compute shader
+
+///////////////////////////////////////////////////////////////////////////////
+// SETUP
+///////////////////////////////////////////////////////////////////////////////
+
+bool isVulkanGPUCullingSupported(VulkanInitData &vkInitData) {
+    return vkInitData.hasMultiDrawIndirect;
+}
+
+void createVulkanGPUCuller( VulkanInitData &vkInitData, 
+                            VulkanGPUCuller &culler,
+                            unsigned int maxObjects, 
+                            unsigned int maxMeshes,
+                            unsigned int frameCnt) {
+    if(!isVulkanGPUCullingSupported(vkInitData)) {
+        throw runtime_error("createVulkanGPUCuller: Device lacks multiDrawIndirect/drawIndirectFirstInstance!");
+    }
+
+    vk::Device &device = vkInitData.device;
+    vk::PhysicalDevice &physicalDevice = vkInitData.physicalDevice;
+    vk::MemoryPropertyFlags hostFlags = vk::MemoryPropertyFlagBits::eHostVisible 
+                                        | vk::MemoryPropertyFlagBits::eHostCoherent;
+
+    culler.maxObjects = max(maxObjects, 1u);
+    culler.maxMeshes = max(maxMeshes, 1u);
+    culler.objectCnt = 0;
+    culler.objectsVersion = 0;
+
+    // Compact survivors and draw them with a GPU-written count when possible
+    if(vkInitData.hasDrawIndirectCount) {
+        culler.drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+            device.getProcAddr("vkCmdDrawIndexedIndirectCountKHR"));
+    }
+    culler.useDrawCount = (culler.drawIndexedIndirectCount != nullptr);
+
+    // Layout (must match the compute shader)
+    vector<vk::DescriptorSetLayoutBinding> bindings = {
+        {0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eCompute},  // Params
+        {1, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute},  // Objects
+        {2, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute},  // Meshes
+        {3, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute},  // Instances
+        {4, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute},  // Draws
+        {5, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute}   // Draw count
+    };
+    culler.descriptorSetLayout = device.createDescriptorSetLayout(
+        vk::DescriptorSetLayoutCreateInfo({}, bindings));
+
+    // One set per frame
+    vector<vk::DescriptorPoolSize> poolSizes = {
+        {vk::DescriptorType::eUniformBuffer, frameCnt},
+        {vk::DescriptorType::eStorageBuffer, 5 * frameCnt}
+    };
+    culler.descriptorPool = device.createDescriptorPool(
+        vk::DescriptorPoolCreateInfo({}, frameCnt, poolSizes));
+
+    vector<vk::DescriptorSetLayout> setLayouts(frameCnt, culler.descriptorSetLayout);
+    vector<vk::DescriptorSet> sets = device.allocateDescriptorSets(
+        vk::DescriptorSetAllocateInfo(culler.descriptorPool, setLayouts));
+
+    // Meshes are shared by all frames
+    culler.meshes = createVulkanStorageBuffer(  physicalDevice, device, 
+                                                sizeof(VulkanGPUCullMesh) * culler.maxMeshes,
+                                                {}, hostFlags);
+
+    vk::DeviceSize objectsSize = sizeof(VulkanGPUCullObject) * culler.maxObjects;
+    vk::DeviceSize instancesSize = sizeof(glm::mat4) * 2 * culler.maxObjects;
+    vk::DeviceSize drawsSize = sizeof(VkDrawIndexedIndirectCommand) * culler.maxObjects;
+
+    culler.frames.resize(frameCnt);
+    for(unsigned int i = 0; i < frameCnt; i++) {
+        VulkanGPUCullFrame &frame = culler.frames[i];
+
+        frame.objects = createVulkanStorageBuffer(physicalDevice, device, objectsSize, {}, hostFlags);
+        frame.objectsVersion = 0;
+        frame.params = createVulkanBuffer(  physicalDevice, device, sizeof(VulkanGPUCullParams),
+                                            vk::BufferUsageFlagBits::eUniformBuffer, 
+                                            hostFlags, VulkanMemoryTag::Uniform);
+        frame.instances = createVulkanStorageBuffer(physicalDevice, device, instancesSize,
+                                                    vk::BufferUsageFlagBits::eVertexBuffer);
+        frame.draws = createVulkanStorageBuffer(physicalDevice, device, drawsSize,
+                                                vk::BufferUsageFlagBits::eIndirectBuffer);
+        frame.drawCount = createVulkanStorageBuffer(physicalDevice, device, sizeof(uint32_t),
+                                                    vk::BufferUsageFlagBits::eIndirectBuffer
+                                                    | vk::BufferUsageFlagBits::eTransferDst);
+        frame.descriptorSet = sets[i];
+
+        vk::DescriptorBufferInfo bufferInfos[] = {
+            {frame.params.buffer, 0, VK_WHOLE_SIZE},
+            {frame.objects.buffer, 0, VK_WHOLE_SIZE},
+            {culler.meshes.buffer, 0, VK_WHOLE_SIZE},
+            {frame.instances.buffer, 0, VK_WHOLE_SIZE},
+            {frame.draws.buffer, 0, VK_WHOLE_SIZE},
+            {frame.drawCount.buffer, 0, VK_WHOLE_SIZE}
+        };
+
+        vector<vk::WriteDescriptorSet> writes;
+        for(uint32_t b = 0; b < 6; b++) {
+            writes.push_back(vk::WriteDescriptorSet(
+                frame.descriptorSet, b, 0, 1, 
+                (b == 0) ? vk::DescriptorType::eUniformBuffer : vk::DescriptorType::eStorageBuffer,
+                nullptr, &bufferInfos[b]));
+        }
+        device.updateDescriptorSets(writes, nullptr);
+    }
+
+    cout << "GPU culling: " << culler.maxObjects << " objects max, "
+        << (culler.useDrawCount ? "drawIndexedIndirectCount" : "drawIndexedIndirect (no count extension)") 
+        << endl;
+}
+
+void setVulkanGPUCullMeshes(VulkanGPUCuller &culler, 
+                            vector<VulkanMesh> &meshes, 
+                            const vector<MeshBounds> &bounds,
+                            const vector<VertexDequantize> &dequants) {
+    if(meshes.size() > culler.maxMeshes) {
+        throw runtime_error("setVulkanGPUCullMeshes: Too many meshes!");
+    }
+
+    VulkanGPUCullMesh *dst = static_cast<VulkanGPUCullMesh *>(culler.meshes.allocation.mapped);
+    for(unsigned int i = 0; i < meshes.size(); i++) {
+        VulkanGPUCullMesh mesh;
+        mesh.indexCnt[0] = static_cast<uint32_t>(meshes[i].indexCnt);
+        mesh.firstIndex[0] = meshes[i].firstIndex;
+        mesh.vertexOffset = meshes[i].vertexOffset;
+
+        // Extra levels past the limit are dropped (the coarsest kept level is used instead)
+        unsigned int lodCnt = std::min((unsigned int)meshes[i].lods.size(), VULKAN_GPU_CULL_MAX_LODS);
+        for(unsigned int k = 0; k < lodCnt; k++) {
+            mesh.indexCnt[k] = static_cast<uint32_t>(meshes[i].lods[k].indexCnt);
+            mesh.firstIndex[k] = meshes[i].lods[k].firstIndex;
+        }
+        mesh.lodCnt = std::max(lodCnt, 1u);
+
+        if(i < bounds.size()) {
+            mesh.sphere = glm::vec4(bounds[i].sphere.center, bounds[i].sphere.radius);
+        }
+        if(i < dequants.size()) {
+            mesh.dequantOffset = glm::vec4(dequants[i].offset, 0.0f);
+            mesh.dequantScale = glm::vec4(dequants[i].scale, 1.0f);
+        }
+        dst[i] = mesh;
+    }
+}
+
+void setVulkanGPUCullObjects(VulkanGPUCuller &culler, const vector<VulkanGPUCullObject> &objects) {
+    if(objects.size() > culler.maxObjects) {
+        throw runtime_error("setVulkanGPUCullObjects: Too many objects!");
+    }
+
+    culler.hostObjects = objects;
+    culler.objectCnt = static_cast<unsigned int>(objects.size());
+    culler.objectsVersion++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// RECORDING
+///////////////////////////////////////////////////////////////////////////////
+
+void recordVulkanGPUCull(   VulkanGPUCuller &culler, 
+                            vk::CommandBuffer &commandBuffer, 
+                            unsigned int frameIndex,
+                            const Frustum &frustum,
+                            const glm::mat4 &localRotMat,
+                            const glm::mat4 &normalRotMat,
+                            const glm::mat4 &viewMat,
+                            float lodScale) {
+    VulkanGPUCullFrame &frame = culler.frames.at(frameIndex);
+
+    // This slot's last use is done (the frame fence was waited on), so it can be rewritten
+    if(frame.objectsVersion != culler.objectsVersion) {
+        memcpy( frame.objects.allocation.mapped, culler.hostObjects.data(), 
+                sizeof(VulkanGPUCullObject) * culler.objectCnt);
+        frame.objectsVersion = culler.objectsVersion;
+    }
+
+    VulkanGPUCullParams params;
+    params.localRotMat = localRotMat;
+    params.normalRotMat = normalRotMat;
+    for(int p = 0; p < 6; p++) {
+        params.planes[p] = frustum.planes[p];
+    }
+    params.objectCnt = culler.objectCnt;
+    params.compact = culler.useDrawCount ? 1 : 0;
+    params.lodScale = lodScale;
+    params.lodFullDetailPixels = culler.lodFullDetailPixels;
+    params.viewDepthRow = -glm::vec4(viewMat[0][2], viewMat[1][2], viewMat[2][2], viewMat[3][2]);
+    memcpy(frame.params.allocation.mapped, &params, sizeof(params));
+
+    // Last frame's draws from these buffers must finish before they are overwritten
+    recordVulkanBufferBarrier(  commandBuffer, frame.drawCount.buffer,
+                                vk::PipelineStageFlagBits::eDrawIndirect, {},
+                                vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+    commandBuffer.fillBuffer(frame.drawCount.buffer, 0, sizeof(uint32_t), 0);
+    recordVulkanBufferBarrier(  commandBuffer, frame.drawCount.buffer,
+                                vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite,
+                                vk::PipelineStageFlagBits::eComputeShader, 
+                                vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+
+    if(culler.objectCnt > 0) {
+        recordVulkanDispatch(   commandBuffer, culler.compute, {frame.descriptorSet},
+                                getVulkanDispatchGroupCnt(culler.objectCnt, GPU_CULL_GROUP_SIZE));
+    }
+
+    // Results feed the indirect draws and the instance vertex attributes
+    recordVulkanBufferBarrier(  commandBuffer, frame.draws.buffer,
+                                vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderWrite,
+                                vk::PipelineStageFlagBits::eDrawIndirect, vk::AccessFlagBits::eIndirectCommandRead);
+    recordVulkanBufferBarrier(  commandBuffer, frame.drawCount.buffer,
+                                vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderWrite,
+                                vk::PipelineStageFlagBits::eDrawIndirect, vk::AccessFlagBits::eIndirectCommandRead);
+    recordVulkanBufferBarrier(  commandBuffer, frame.instances.buffer,
+                                vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderWrite,
+                                vk::PipelineStageFlagBits::eVertexInput, vk::AccessFlagBits::eVertexAttributeRead);
+}
+
+void recordVulkanGPUDraws(  VulkanGPUCuller &culler, 
+                            vk::CommandBuffer &commandBuffer, 
+                            unsigned int frameIndex,
+                            uint32_t instanceBinding) {
+    VulkanGPUCullFrame &frame = culler.frames.at(frameIndex);
+    if(culler.objectCnt == 0) {
+        return;
+    }
+
+    vk::DeviceSize offset = 0;
+    commandBuffer.bindVertexBuffers(instanceBinding, 1, &frame.instances.buffer, &offset);
+
+    uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    if(culler.useDrawCount) {
+        culler.drawIndexedIndirectCount(commandBuffer, 
+                                        frame.draws.buffer, 0, 
+                                        frame.drawCount.buffer, 0,
+                                        culler.objectCnt, stride);
+    }
+    else {
+        // Culled objects are still in the list with zero instances
+        commandBuffer.drawIndexedIndirect(frame.draws.buffer, 0, culler.objectCnt, stride);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CLEANUP
+///////////////////////////////////////////////////////////////////////////////
+
+void cleanupVulkanGPUCuller(vk::Device &device, VulkanGPUCuller &culler) {
+    for(auto &frame : culler.frames) {
+        cleanupVulkanBuffer(device, frame.objects);
+        cleanupVulkanBuffer(device, frame.params);
+        cleanupVulkanBuffer(device, frame.instances);
+        cleanupVulkanBuffer(device, frame.draws);
+        cleanupVulkanBuffer(device, frame.drawCount);
+    }
+    culler.frames.clear();
+    cleanupVulkanBuffer(device, culler.meshes);
+
+    // culler.compute belongs to whoever created it
+    culler.compute = {};
+    device.destroyDescriptorPool(culler.descriptorPool);
+    device.destroyDescriptorSetLayout(culler.descriptorSetLayout);
+}
@@ -2,15 +2,55 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+///////////////////////////////////////////////////////////////////////////////
+// OWNERSHIP
+///////////////////////////////////////////////////////////////////////////////
+
+VulkanImage::VulkanImage(VulkanImage &&other) noexcept {
+    *this = std::move(other);
+}
+
+VulkanImage& VulkanImage::operator=(VulkanImage &&other) noexcept {
+    if(this != &other) {
+        // Release whatever we held before taking over
+        if(image) {
+            cleanupVulkanImage(deleter.device, *this);
+        }
+
+        image = other.image;
+        allocation = other.allocation;
+        view = other.view;
+        format = other.format;
+        deleter = other.deleter;
+
+        // Moved-from image owns nothing
+        other.image = nullptr;
+        other.view = nullptr;
+        other.allocation = VulkanAllocation();
+    }
+    return *this;
+}
+
+VulkanImage::~VulkanImage() {
+    if(image) {
+        cleanupVulkanImage(deleter.device, *this);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// IMAGE MANAGEMENT
+///////////////////////////////////////////////////////////////////////////////
+
 VulkanImage createVulkanImage(  
     VulkanInitData &vkInitData, int width, int height, 
     vk::Format format, vk::ImageUsageFlags usage,
-    vk::ImageAspectFlags aspectFlags) {
+    vk::ImageAspectFlags aspectFlags,
+    VulkanMemoryTag tag) {
     
     return createVulkanImage(vkInitData.device,
         vkInitData.physicalDevice,
         width, height, format, usage,
-        aspectFlags);
+        aspectFlags, tag);
 }
 
 VulkanImage createVulkanImage(  
@@ -18,13 +58,15 @@ VulkanImage createVulkanImage(
     vk::PhysicalDevice &phyDevice,
     int width, int height, 
     vk::Format format, vk::ImageUsageFlags usage,
-    vk::ImageAspectFlags aspectFlags) {
+    vk::ImageAspectFlags aspectFlags,
+    VulkanMemoryTag tag) {
 
     // Create struct
     VulkanImage vkImage;
 
     // Store format for later
     vkImage.format = format;
+    vkImage.deleter.device = device;
 
     ///////////////////////////////////////////////////////////////////////////
     // IMAGE
@@ -47,19 +89,16 @@ VulkanImage createVulkanImage(
     // Allocate memory for image
     vk::MemoryRequirements memRequirements = device.getImageMemoryRequirements(image);
 
-    vk::MemoryAllocateInfo allocInfo(memRequirements.size,
-                                     findMemoryType(memRequirements.memoryTypeBits, 
-                                                    vk::MemoryPropertyFlagBits::eDeviceLocal, 
-                                                    phyDevice));
-
-    auto memory = device.allocateMemory(allocInfo);
+    VulkanAllocation allocation = allocateVulkanMemory( phyDevice, device, memRequirements,
+                                                        vk::MemoryPropertyFlagBits::eDeviceLocal,
+                                                        true, tag);
 
     // Bind memory to image
-    device.bindImageMemory(image, memory, 0);
+    device.bindImageMemory(image, allocation.memory, allocation.offset);
 
     // Move into struct (rather than copy)
     vkImage.image = std::move(image);
-    vkImage.memory = std::move(memory);
+    vkImage.allocation = allocation;
 
     ///////////////////////////////////////////////////////////////////////////
     // IMAGEVIEW
@@ -107,7 +146,8 @@ VulkanImage createVulkanDepthImage(
                                     width, height, 
                                     depthFormat, 
                                     vk::ImageUsageFlagBits::eDepthStencilAttachment,
-                                    vk::ImageAspectFlagBits::eDepth);  
+                                    vk::ImageAspectFlagBits::eDepth,
+                                    VulkanMemoryTag::Depth);  
 
     // Return image struct
     return depthImage; 
@@ -171,7 +211,26 @@ void cleanupVulkanImage(VulkanInitData &vkInitData, VulkanImage &vkImage) {
 }
 
 void cleanupVulkanImage(vk::Device &device, VulkanImage &vkImage) {
-    device.destroyImageView(vkImage.view);
-    device.freeMemory(vkImage.memory);
-    device.destroyImage(vkImage.image);
+    if(vkImage.deleter.deletionQueue && vkImage.image) {
+        // Frames in flight may still use it, so destroy it later
+        vk::Device queueDevice = device;
+        vk::ImageView view = vkImage.view;
+        vk::Image image = vkImage.image;
+        VulkanAllocation allocation = vkImage.allocation;
+        deferVulkanDeletion(*vkImage.deleter.deletionQueue, [queueDevice, view, image, allocation]() mutable {
+            queueDevice.destroyImageView(view);
+            queueDevice.destroyImage(image);
+            freeVulkanMemory(queueDevice, allocation);
+        });
+    }
+    else {
+        device.destroyImageView(vkImage.view);
+        device.destroyImage(vkImage.image);
+        freeVulkanMemory(device, vkImage.allocation);
+    }
+
+    // Nothing left to own
+    vkImage.view = nullptr;
+    vkImage.image = nullptr;
+    vkImage.allocation = VulkanAllocation();
 }
@@ -0,0 +1,408 @@
+#include "VKMemory.hpp"
+#include <map>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// MEMORY QUERIES
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int findMemoryType(unsigned int typeFilter,
+                            vk::MemoryPropertyFlags properties,
+                            vk::PhysicalDevice physicalDevice) {
+
+    // Get the memory properites from the physical device
+    vk::PhysicalDeviceMemoryProperties memProperties = physicalDevice.getMemoryProperties();
+
+    // Loop through the properties to find a match in terms of the type and the properties
+    for (unsigned int i = 0; i < memProperties.memoryTypeCount; i++) {
+        unsigned int currentTypeBit = (1 << i);
+        bool matchType = typeFilter & currentTypeBit;
+        bool propEqual = ((memProperties.memoryTypes[i].propertyFlags & properties) == properties);
+
+        if (matchType && propEqual) {
+            return i;
+        }
+    }
+
+    // If we are here, throw an exception
+    throw runtime_error("findMemoryType: Failed to find suitable memory type!");
+}
+
+const char* getVulkanMemoryTagName(VulkanMemoryTag tag) {
+    switch(tag) {
+        case VulkanMemoryTag::General:  return "general";
+        case VulkanMemoryTag::Mesh:     return "mesh";
+        case VulkanMemoryTag::Uniform:  return "uniform";
+        case VulkanMemoryTag::Depth:    return "depth";
+        case VulkanMemoryTag::Staging:  return "staging";
+        case VulkanMemoryTag::Texture:  return "texture";
+        case VulkanMemoryTag::Storage:  return "storage";
+        default:                        return "unknown";
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ALLOCATOR REGISTRY
+// - One allocator per logical device, so existing create/cleanup functions
+//   can keep taking only (physicalDevice, device)
+///////////////////////////////////////////////////////////////////////////////
+
+// Preferred size of a shared block (smaller heaps use 1/8 of the heap instead)
+static const vk::DeviceSize PREFERRED_BLOCK_SIZE = 64ull * 1024ull * 1024ull;
+
+static mutex registryLock;
+static map<VkDevice, unique_ptr<VulkanMemoryAllocator>> allAllocators;
+
+VulkanMemoryAllocator& getVulkanMemoryAllocator(vk::PhysicalDevice &physicalDevice, vk::Device &device) {
+    lock_guard<mutex> guard(registryLock);
+
+    auto &allocator = allAllocators[static_cast<VkDevice>(device)];
+    if(!allocator) {
+        allocator = make_unique<VulkanMemoryAllocator>();
+        allocator->device = device;
+        allocator->physicalDevice = physicalDevice;
+        allocator->memProperties = physicalDevice.getMemoryProperties();
+        allocator->bufferImageGranularity = physicalDevice.getProperties().limits.bufferImageGranularity;
+    }
+
+    return *allocator;
+}
+
+VulkanMemoryAllocator* findVulkanMemoryAllocator(vk::Device &device) {
+    lock_guard<mutex> guard(registryLock);
+
+    auto it = allAllocators.find(static_cast<VkDevice>(device));
+    if(it == allAllocators.end()) {
+        return nullptr;
+    }
+    return it->second.get();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// BLOCK MANAGEMENT
+///////////////////////////////////////////////////////////////////////////////
+
+static vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment) {
+    return (alignment > 1) ? ((value + alignment - 1) / alignment) * alignment : value;
+}
+
+static vk::DeviceSize getPreferredBlockSize(VulkanMemoryAllocator &allocator, unsigned int memoryTypeIndex) {
+    unsigned int heapIndex = allocator.memProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    vk::DeviceSize heapSize = allocator.memProperties.memoryHeaps[heapIndex].size;
+    return min(PREFERRED_BLOCK_SIZE, heapSize / 8);
+}
+
+static VulkanMemoryBlock* createVulkanMemoryBlock(  VulkanMemoryAllocator &allocator,
+                                                    unsigned int memoryTypeIndex,
+                                                    vk::DeviceSize size,
+                                                    bool isImage,
+                                                    bool dedicated) {
+    // Allocate ACTUAL device memory
+    auto block = make_unique<VulkanMemoryBlock>();
+    block->memory = allocator.device.allocateMemory(vk::MemoryAllocateInfo(size, memoryTypeIndex));
+    block->size = size;
+    block->memoryTypeIndex = memoryTypeIndex;
+    block->isImage = isImage;
+    block->dedicated = dedicated;
+    block->freeRanges.push_back({0, size});
+
+    // Keep host-visible memory mapped (mapping the same memory twice is invalid,
+    // so resources sharing a block must share this pointer)
+    vk::MemoryPropertyFlags flags = allocator.memProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+    if(flags & vk::MemoryPropertyFlagBits::eHostVisible) {
+        block->mapped = allocator.device.mapMemory(block->memory, 0, VK_WHOLE_SIZE);
+    }
+
+    allocator.blocks.push_back(std::move(block));
+    return allocator.blocks.back().get();
+}
+
+static void destroyVulkanMemoryBlock(VulkanMemoryAllocator &allocator, VulkanMemoryBlock *block) {
+    if(block->mapped) {
+        allocator.device.unmapMemory(block->memory);
+    }
+    allocator.device.freeMemory(block->memory);
+
+    allocator.blocks.erase(remove_if(allocator.blocks.begin(), allocator.blocks.end(),
+                            [block](const unique_ptr<VulkanMemoryBlock> &b) { return b.get() == block; }),
+                            allocator.blocks.end());
+}
+
+// First-fit search of the free list; returns false if nothing fits
+static bool suballocateFromBlock(   VulkanMemoryBlock *block,
+                                    vk::MemoryRequirements &memRequirements,
+                                    VulkanAllocation &allocation) {
+
+    for(unsigned int i = 0; i < block->freeRanges.size(); i++) {
+        VulkanMemoryRange range = block->freeRanges[i];
+        vk::DeviceSize alignedOffset = alignUp(range.offset, memRequirements.alignment);
+        vk::DeviceSize padding = alignedOffset - range.offset;
+
+        if(padding + memRequirements.size > range.size) {
+            continue;
+        }
+
+        // Take the front of the range; the rest stays free
+        vk::DeviceSize consumed = padding + memRequirements.size;
+        if(consumed == range.size) {
+            block->freeRanges.erase(block->freeRanges.begin() + i);
+        }
+        else {
+            block->freeRanges[i].offset += consumed;
+            block->freeRanges[i].size -= consumed;
+        }
+
+        block->bytesUsed += consumed;
+        block->bytesWasted += padding;
+        block->allocationCount++;
+
+        allocation.memory = block->memory;
+        allocation.offset = alignedOffset;
+        allocation.size = memRequirements.size;
+        allocation.padding = padding;
+        allocation.memoryTypeIndex = block->memoryTypeIndex;
+        allocation.mapped = block->mapped ? static_cast<char*>(block->mapped) + alignedOffset : nullptr;
+        allocation.block = block;
+        return true;
+    }
+
+    return false;
+}
+
+// Give a range back and merge it with its neighbors
+static void releaseToBlock(VulkanMemoryBlock *block, VulkanMemoryRange released) {
+    auto it = lower_bound(block->freeRanges.begin(), block->freeRanges.end(), released,
+                            [](const VulkanMemoryRange &a, const VulkanMemoryRange &b) {
+                                return a.offset < b.offset;
+                            });
+    it = block->freeRanges.insert(it, released);
+
+    // Merge with next
+    auto next = it + 1;
+    if(next != block->freeRanges.end() && it->offset + it->size == next->offset) {
+        it->size += next->size;
+        block->freeRanges.erase(next);
+    }
+
+    // Merge with previous
+    if(it != block->freeRanges.begin()) {
+        auto prev = it - 1;
+        if(prev->offset + prev->size == it->offset) {
+            prev->size += it->size;
+            block->freeRanges.erase(it);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ALLOCATION
+///////////////////////////////////////////////////////////////////////////////
+
+// Per-tag totals (allocator lock must be held)
+static void trackVulkanAllocation(VulkanMemoryAllocator &allocator, VulkanAllocation &allocation, bool added) {
+    int tagIndex = static_cast<int>(allocation.tag);
+    if(added) {
+        allocator.tagBytes[tagIndex] += allocation.size;
+        allocator.tagCounts[tagIndex]++;
+    }
+    else {
+        allocator.tagBytes[tagIndex] -= allocation.size;
+        allocator.tagCounts[tagIndex]--;
+    }
+}
+
+VulkanAllocation allocateVulkanMemory(  vk::PhysicalDevice &physicalDevice,
+                                        vk::Device &device,
+                                        vk::MemoryRequirements memRequirements,
+                                        vk::MemoryPropertyFlags properties,
+                                        bool isImage,
+                                        VulkanMemoryTag tag) {
+
+    VulkanMemoryAllocator &allocator = getVulkanMemoryAllocator(physicalDevice, device);
+    lock_guard<mutex> guard(allocator.allocLock);
+
+    unsigned int memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties, physicalDevice);
+    vk::DeviceSize blockSize = getPreferredBlockSize(allocator, memoryTypeIndex);
+
+    // Linear (buffer) and optimal (image) resources never share a block
+    // when the device has a bufferImageGranularity, so neighbors can't alias a page
+    bool separateImages = (allocator.bufferImageGranularity > 1);
+
+    VulkanAllocation allocation;
+    allocation.tag = tag;
+
+    // Large resources get their own block
+    if(memRequirements.size > blockSize / 2) {
+        VulkanMemoryBlock *block = createVulkanMemoryBlock(allocator, memoryTypeIndex,
+                                                            memRequirements.size, isImage, true);
+        suballocateFromBlock(block, memRequirements, allocation);
+        trackVulkanAllocation(allocator, allocation, true);
+        return allocation;
+    }
+
+    // Try existing blocks first
+    for(auto &block : allocator.blocks) {
+        if(block->dedicated || block->memoryTypeIndex != memoryTypeIndex) {
+            continue;
+        }
+        if(separateImages && block->isImage != isImage) {
+            continue;
+        }
+        if(suballocateFromBlock(block.get(), memRequirements, allocation)) {
+            trackVulkanAllocation(allocator, allocation, true);
+            return allocation;
+        }
+    }
+
+    // Otherwise, make a new block
+    VulkanMemoryBlock *block = createVulkanMemoryBlock(allocator, memoryTypeIndex,
+                                                        blockSize, isImage, false);
+    suballocateFromBlock(block, memRequirements, allocation);
+    trackVulkanAllocation(allocator, allocation, true);
+    return allocation;
+}
+
+bool allocateVulkanMemoryInDenserBlock( vk::Device &device,
+                                        vk::MemoryRequirements memRequirements,
+                                        VulkanAllocation &source,
+                                        VulkanAllocation &allocation) {
+    VulkanMemoryAllocator *allocator = findVulkanMemoryAllocator(device);
+    if(!allocator || !source.block) {
+        return false;
+    }
+
+    // Must stay in the same memory type (same properties)
+    if(!(memRequirements.memoryTypeBits & (1u << source.memoryTypeIndex))) {
+        return false;
+    }
+
+    lock_guard<mutex> guard(allocator->allocLock);
+
+    float sourceOccupancy = getVulkanMemoryBlockOccupancy(source.block);
+    VulkanAllocation result;
+    result.tag = source.tag;
+
+    for(auto &block : allocator->blocks) {
+        if(block.get() == source.block || block->dedicated 
+            || block->memoryTypeIndex != source.memoryTypeIndex
+            || block->isImage != source.block->isImage) {
+            continue;
+        }
+        if(getVulkanMemoryBlockOccupancy(block.get()) <= sourceOccupancy) {
+            continue;
+        }
+        if(suballocateFromBlock(block.get(), memRequirements, result)) {
+            trackVulkanAllocation(*allocator, result, true);
+            allocation = result;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+float getVulkanMemoryBlockOccupancy(VulkanMemoryBlock *block) {
+    if(!block || block->size == 0) {
+        return 0.0f;
+    }
+    return static_cast<float>(block->bytesUsed) / static_cast<float>(block->size);
+}
+
+void freeVulkanMemory(vk::Device &device, VulkanAllocation &allocation) {
+    if(!allocation.block) {
+        return;
+    }
+
+    VulkanMemoryAllocator *allocator = findVulkanMemoryAllocator(device);
+    if(!allocator) {
+        throw runtime_error("freeVulkanMemory: No allocator exists for this device!");
+    }
+
+    lock_guard<mutex> guard(allocator->allocLock);
+
+    trackVulkanAllocation(*allocator, allocation, false);
+
+    VulkanMemoryBlock *block = allocation.block;
+    vk::DeviceSize consumed = allocation.padding + allocation.size;
+
+    releaseToBlock(block, { allocation.offset - allocation.padding, consumed });
+    block->bytesUsed -= consumed;
+    block->bytesWasted -= allocation.padding;
+    block->allocationCount--;
+
+    // Return empty blocks to the driver
+    if(block->allocationCount == 0) {
+        destroyVulkanMemoryBlock(*allocator, block);
+    }
+
+    allocation = VulkanAllocation();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// STATISTICS
+///////////////////////////////////////////////////////////////////////////////
+
+VulkanMemoryStats getVulkanMemoryStats(vk::Device &device) {
+    VulkanMemoryStats stats;
+
+    VulkanMemoryAllocator *allocator = findVulkanMemoryAllocator(device);
+    if(!allocator) {
+        return stats;
+    }
+
+    lock_guard<mutex> guard(allocator->allocLock);
+
+    for(auto &block : allocator->blocks) {
+        stats.blockCount++;
+        if(block->dedicated) {
+            stats.dedicatedBlockCount++;
+        }
+        stats.allocationCount += block->allocationCount;
+        stats.bytesAllocated += block->size;
+        stats.bytesUsed += block->bytesUsed - block->bytesWasted;
+        stats.bytesWasted += block->bytesWasted;
+        stats.bytesFree += block->size - block->bytesUsed;
+    }
+
+    return stats;
+}
+
+void printVulkanMemoryStats(vk::Device &device) {
+    VulkanMemoryStats stats = getVulkanMemoryStats(device);
+
+    cout << "Device memory: " << stats.blockCount << " blocks ("
+        << stats.dedicatedBlockCount << " dedicated), "
+        << stats.allocationCount << " allocations" << endl;
+    cout << "\tAllocated: " << stats.bytesAllocated << " bytes" << endl;
+    cout << "\tUsed: " << stats.bytesUsed << " bytes" << endl;
+    cout << "\tWasted: " << stats.bytesWasted << " bytes" << endl;
+    cout << "\tFree: " << stats.bytesFree << " bytes" << endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CLEANUP
+///////////////////////////////////////////////////////////////////////////////
+
+void cleanupVulkanMemoryAllocator(vk::Device &device) {
+    lock_guard<mutex> guard(registryLock);
+
+    auto it = allAllocators.find(static_cast<VkDevice>(device));
+    if(it == allAllocators.end()) {
+        return;
+    }
+
+    VulkanMemoryAllocator &allocator = *(it->second);
+    if(!allocator.blocks.empty()) {
+        cout << "WARNING: " << allocator.blocks.size()
+            << " device memory block(s) still in use at cleanup." << endl;
+    }
+
+    for(auto &block : allocator.blocks) {
+        if(block->mapped) {
+            device.unmapMemory(block->memory);
+        }
+        device.freeMemory(block->memory);
+    }
+
+    allAllocators.erase(it);
+}
@@ -0,0 +1,210 @@
+#include "VKMemoryTelemetry.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// SNAPSHOTS
+///////////////////////////////////////////////////////////////////////////////
+
+VulkanMemoryTelemetry getVulkanMemoryTelemetry(vk::Device &device) {
+    VulkanMemoryTelemetry telemetry;
+
+    VulkanMemoryAllocator *allocator = findVulkanMemoryAllocator(device);
+    if(!allocator) {
+        return telemetry;
+    }
+
+    // Ask the driver for budgets first (outside the lock)
+    vk::PhysicalDeviceMemoryBudgetPropertiesEXT budgetProps;
+    telemetry.hasBudget = allocator->hasMemoryBudget;
+    if(telemetry.hasBudget) {
+        auto propChain = allocator->physicalDevice.getMemoryProperties2<
+                            vk::PhysicalDeviceMemoryProperties2, 
+                            vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+        budgetProps = propChain.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+    }
+
+    lock_guard<mutex> guard(allocator->allocLock);
+
+    vk::PhysicalDeviceMemoryProperties &memProps = allocator->memProperties;
+
+    // Heaps
+    for(unsigned int i = 0; i < memProps.memoryHeapCount; i++) {
+        VulkanHeapTelemetry heap;
+        heap.heapIndex = i;
+        heap.heapSize = memProps.memoryHeaps[i].size;
+        heap.deviceLocal = static_cast<bool>(memProps.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+        telemetry.heaps.push_back(heap);
+    }
+
+    // Types (and heap totals)
+    vector<int> typeSlot(memProps.memoryTypeCount, -1);
+    for(auto &block : allocator->blocks) {
+        unsigned int typeIndex = block->memoryTypeIndex;
+        if(typeSlot[typeIndex] < 0) {
+            VulkanMemoryTypeTelemetry type;
+            type.typeIndex = typeIndex;
+            type.heapIndex = memProps.memoryTypes[typeIndex].heapIndex;
+            type.propertyFlags = memProps.memoryTypes[typeIndex].propertyFlags;
+            typeSlot[typeIndex] = static_cast<int>(telemetry.types.size());
+            telemetry.types.push_back(type);
+        }
+
+        VulkanMemoryTypeTelemetry &type = telemetry.types[typeSlot[typeIndex]];
+        type.blockCount++;
+        type.allocationCount += block->allocationCount;
+        type.bytesAllocated += block->size;
+        type.bytesUsed += block->bytesUsed - block->bytesWasted;
+
+        VulkanHeapTelemetry &heap = telemetry.heaps[type.heapIndex];
+        heap.bytesAllocated += block->size;
+        heap.bytesUsed += block->bytesUsed - block->bytesWasted;
+    }
+
+    // Budget (fall back on what we know)
+    for(auto &heap : telemetry.heaps) {
+        if(telemetry.hasBudget) {
+            heap.budget = budgetProps.heapBudget[heap.heapIndex];
+            heap.usage = budgetProps.heapUsage[heap.heapIndex];
+        }
+        else {
+            heap.budget = heap.heapSize;
+            heap.usage = heap.bytesAllocated;
+        }
+    }
+
+    // Tags
+    for(int i = 0; i < (int)VulkanMemoryTag::Count; i++) {
+        telemetry.tagBytes[i] = allocator->tagBytes[i];
+        telemetry.tagCounts[i] = allocator->tagCounts[i];
+    }
+
+    return telemetry;
+}
+
+bool isVulkanMemoryOverBudget(VulkanMemoryTelemetry &telemetry, float fraction) {
+    for(auto &heap : telemetry.heaps) {
+        if(heap.budget > 0 && heap.usage > fraction * heap.budget) {
+            return true;
+        }
+    }
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// OUTPUT
+///////////////////////////////////////////////////////////////////////////////
+
+static double toMiB(vk::DeviceSize bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+void printVulkanMemoryTelemetry(VulkanMemoryTelemetry &telemetry) {
+    cout << "Device memory telemetry" 
+        << (telemetry.hasBudget ? " (VK_EXT_memory_budget):" : " (no budget extension):") << endl;
+
+    for(auto &heap : telemetry.heaps) {
+        cout << "\tHeap " << heap.heapIndex << (heap.deviceLocal ? " (device-local)" : " (host)") 
+            << ": usage " << toMiB(heap.usage) << " / " << toMiB(heap.budget) << " MiB budget"
+            << ", ours " << toMiB(heap.bytesUsed) << " used of " << toMiB(heap.bytesAllocated) << " MiB allocated"
+            << endl;
+    }
+
+    for(auto &type : telemetry.types) {
+        cout << "\tType " << type.typeIndex << " (heap " << type.heapIndex << ", "
+            << vk::to_string(type.propertyFlags) << "): "
+            << type.blockCount << " blocks, " << type.allocationCount << " allocations, "
+            << toMiB(type.bytesUsed) << " / " << toMiB(type.bytesAllocated) << " MiB" << endl;
+    }
+
+    for(int i = 0; i < (int)VulkanMemoryTag::Count; i++) {
+        if(telemetry.tagCounts[i] == 0) {
+            continue;
+        }
+        cout << "\tTag " << getVulkanMemoryTagName(static_cast<VulkanMemoryTag>(i)) << ": "
+            << telemetry.tagCounts[i] << " allocations, " << toMiB(telemetry.tagBytes[i]) << " MiB" << endl;
+    }
+}
+
+void writeVulkanMemoryTelemetryCSV( ostream &out, VulkanMemoryTelemetry &telemetry,
+                                    float timeSeconds, bool writeHeader) {
+    // One row per snapshot: time, then (usage, budget, ours) per heap, then bytes per tag
+    if(writeHeader) {
+        out << "time";
+        for(auto &heap : telemetry.heaps) {
+            out << ",heap" << heap.heapIndex << "_usage"
+                << ",heap" << heap.heapIndex << "_budget"
+                << ",heap" << heap.heapIndex << "_allocated"
+                << ",heap" << heap.heapIndex << "_used";
+        }
+        for(int i = 0; i < (int)VulkanMemoryTag::Count; i++) {
+            out << "," << getVulkanMemoryTagName(static_cast<VulkanMemoryTag>(i));
+        }
+        out << endl;
+    }
+
+    out << timeSeconds;
+    for(auto &heap : telemetry.heaps) {
+        out << "," << heap.usage << "," << heap.budget 
+            << "," << heap.bytesAllocated << "," << heap.bytesUsed;
+    }
+    for(int i = 0; i < (int)VulkanMemoryTag::Count; i++) {
+        out << "," << telemetry.tagBytes[i];
+    }
+    out << endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PERIODIC LOG
+///////////////////////////////////////////////////////////////////////////////
+
+bool openVulkanMemoryTelemetryLog(  VulkanMemoryTelemetryLog &log, 
+                                    string csvFilename,
+                                    float intervalSeconds,
+                                    bool printToConsole) {
+    log.intervalSeconds = intervalSeconds;
+    log.printToConsole = printToConsole;
+    log.headerWritten = false;
+    log.startTime = getTime();
+    log.lastDumpTime = log.startTime;
+
+    if(!csvFilename.empty()) {
+        log.csv.open(csvFilename, ios::out | ios::trunc);
+        if(!log.csv.is_open()) {
+            cerr << "openVulkanMemoryTelemetryLog: Could not open " << csvFilename << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void updateVulkanMemoryTelemetryLog(vk::Device &device, VulkanMemoryTelemetryLog &log) {
+    auto now = getTime();
+    if(log.headerWritten && getElapsedSeconds(log.lastDumpTime, now) < log.intervalSeconds) {
+        return;
+    }
+
+    VulkanMemoryTelemetry telemetry = getVulkanMemoryTelemetry(device);
+
+    if(log.csv.is_open()) {
+        writeVulkanMemoryTelemetryCSV(log.csv, telemetry, getElapsedSeconds(log.startTime, now), !log.headerWritten);
+    }
+
+    if(log.printToConsole) {
+        printVulkanMemoryTelemetry(telemetry);
+    }
+
+    // Always complain when close to running out
+    if(isVulkanMemoryOverBudget(telemetry, log.warnFraction)) {
+        cerr << "WARNING: Device memory usage is above " << (log.warnFraction * 100.0f) 
+            << "% of a heap budget!" << endl;
+    }
+
+    log.headerWritten = true;
+    log.lastDumpTime = now;
+}
+
+void closeVulkanMemoryTelemetryLog(VulkanMemoryTelemetryLog &log) {
+    if(log.csv.is_open()) {
+        log.csv.close();
+    }
+}
@@ -1,21 +1,147 @@
 #include "VKMesh.hpp"
+#include <cmath>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// Index formats
+///////////////////////////////////////////////////////////////////////////////
+
+vk::IndexType getVulkanIndexType(size_t vertexCnt) {
+    return (vertexCnt < 65536) ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+}
+
+vk::DeviceSize getVulkanIndexSize(vk::IndexType indexType) {
+    return (indexType == vk::IndexType::eUint16) ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+void queueVulkanIndexUpload(VulkanUploadBatch &batch, VulkanBuffer &indices, vk::IndexType indexType,
+                            unsigned int firstIndex, const vector<unsigned int> &hostIndices) {
+    if(hostIndices.empty()) {
+        return;
+    }
+
+    vk::DeviceSize indexSize = getVulkanIndexSize(indexType);
+    if(indexType == vk::IndexType::eUint32) {
+        queueVulkanBufferUpload(batch, indices, indexSize * firstIndex, 
+                                indexSize * hostIndices.size(), hostIndices.data());
+        return;
+    }
+
+    // Staging copies the data right away, so the narrowed copy can be temporary
+    vector<uint16_t> narrowIndices(hostIndices.begin(), hostIndices.end());
+    queueVulkanBufferUpload(batch, indices, indexSize * firstIndex, 
+                            indexSize * narrowIndices.size(), narrowIndices.data());
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 // Vulkan mesh
 ///////////////////////////////////////////////////////////////////////////////
 
 void recordDrawVulkanMesh(vk::CommandBuffer &commandBuffer, VulkanMesh &mesh) {
-    
-    vk::Buffer vertexBuffers[] = {mesh.vertices.buffer};
+    recordBindVulkanMesh(commandBuffer, mesh);
+    recordDrawVulkanMeshRange(commandBuffer, mesh);
+}    
+
+static void recordBindVulkanBuffers(vk::CommandBuffer &commandBuffer, vk::Buffer vertices, vk::Buffer indices,
+                                    vk::IndexType indexType) {
+    vk::Buffer vertexBuffers[] = {vertices};
     vk::DeviceSize offsets[] = {0};
     commandBuffer.bindVertexBuffers(0, vertexBuffers, offsets);
-    commandBuffer.bindIndexBuffer(mesh.indices.buffer, 0, vk::IndexType::eUint32);
-    
-    commandBuffer.drawIndexed(static_cast<unsigned int>(mesh.indexCnt), 1, 0, 0, 0);
-}    
+    commandBuffer.bindIndexBuffer(indices, 0, indexType);
+}
 
+void recordBindVulkanMesh(vk::CommandBuffer &commandBuffer, VulkanMesh &mesh) {
+    recordBindVulkanBuffers(commandBuffer, mesh.vertices.buffer, mesh.indices.buffer, mesh.indexType);
+}
+
+void recordBindVulkanMesh(vk::CommandBuffer &commandBuffer, VulkanMeshBuffers &buffers) {
+    recordBindVulkanBuffers(commandBuffer, buffers.vertices.buffer, buffers.indices.buffer, buffers.indexType);
+}
+
+void recordDrawVulkanMeshRange(vk::CommandBuffer &commandBuffer, VulkanMesh &mesh) {
+    // Assumes this mesh's buffers are already bound
+    commandBuffer.drawIndexed(static_cast<unsigned int>(mesh.indexCnt), 1, 
+                                mesh.firstIndex, mesh.vertexOffset, 0);
+}
+
+unsigned int selectVulkanMeshLOD(const VulkanMesh &mesh, float screenDiameter, float fullDetailPixels) {
+    if(mesh.lods.size() < 2 || screenDiameter >= fullDetailPixels) {
+        return 0;
+    }
+
+    float levels = std::floor(std::log2(fullDetailPixels / std::max(screenDiameter, 1e-6f)));
+    return (unsigned int)std::min(levels, (float)(mesh.lods.size() - 1));
+}
+
+void recordDrawVulkanMeshLOD(vk::CommandBuffer &commandBuffer, VulkanMesh &mesh, unsigned int lod) {
+    // Assumes this mesh's buffers are already bound
+    if(lod >= mesh.lods.size()) {
+        recordDrawVulkanMeshRange(commandBuffer, mesh);
+        return;
+    }
+    commandBuffer.drawIndexed(static_cast<unsigned int>(mesh.lods[lod].indexCnt), 1, 
+                                mesh.lods[lod].firstIndex, mesh.vertexOffset, 0);
+}
+
+void recordDrawVulkanMeshInstanced( vk::CommandBuffer &commandBuffer, VulkanMesh &mesh,
+                                    uint32_t instanceCnt, uint32_t firstInstance) {
+    // Assumes the mesh's buffers and the instance buffer are already bound
+    commandBuffer.drawIndexed(static_cast<unsigned int>(mesh.indexCnt), instanceCnt, 
+                                mesh.firstIndex, mesh.vertexOffset, firstInstance);
+}
+
+void recordBindVulkanInstanceBuffer(vk::CommandBuffer &commandBuffer, uint32_t binding,
+                                    VulkanBuffer &buffer, vk::DeviceSize offset) {
+    commandBuffer.bindVertexBuffers(binding, 1, &buffer.buffer, &offset);
+}
+
+void addVulkanInstanceBinding(AttributeDescData &attribDescData, uint32_t binding, uint32_t stride) {
+    attribDescData.instanceBindDesc.push_back(
+        vk::VertexInputBindingDescription(binding, stride, vk::VertexInputRate::eInstance));
+}
+
+void setVulkanQuantizedVertexAttributes(AttributeDescData &attribDescData, 
+                                        uint32_t posLocation, uint32_t colorLocation, 
+                                        uint32_t normalLocation) {
+    attribDescData.bindDesc = vk::VertexInputBindingDescription(0, sizeof(QuantizedVertex), 
+                                                                vk::VertexInputRate::eVertex);
+    attribDescData.attribDesc.clear();
+    attribDescData.attribDesc.push_back(
+        vk::VertexInputAttributeDescription(posLocation, 0, vk::Format::eR16G16B16A16Unorm, 
+                                            offsetof(QuantizedVertex, pos)));
+    attribDescData.attribDesc.push_back(
+        vk::VertexInputAttributeDescription(colorLocation, 0, vk::Format::eR8G8B8A8Unorm, 
+                                            offsetof(QuantizedVertex, color)));
+    attribDescData.attribDesc.push_back(
+        vk::VertexInputAttributeDescription(normalLocation, 0, vk::Format::eR16G16Snorm, 
+                                            offsetof(QuantizedVertex, normal)));
+}
+
+void addVulkanMat4Attribute(AttributeDescData &attribDescData, 
+                            uint32_t binding, uint32_t location, uint32_t offset) {
+    for(uint32_t i = 0; i < 4; i++) {
+        attribDescData.attribDesc.push_back(
+            vk::VertexInputAttributeDescription(
+                location + i, binding, vk::Format::eR32G32B32A32Sfloat, 
+                offset + i * sizeof(float) * 4));
+    }
+}
 
 void cleanupVulkanMesh(VulkanInitData &vkInitData, VulkanMesh &mesh) {
-    cleanupVulkanBuffer(vkInitData.device, mesh.vertices);
-    cleanupVulkanBuffer(vkInitData.device, mesh.indices);
+    // Merged meshes have no buffers (see cleanupVulkanMeshBuffers())
+    if(mesh.vertices.buffer) {
+        cleanupVulkanBuffer(vkInitData.device, mesh.vertices);
+    }
+    if(mesh.indices.buffer) {
+        cleanupVulkanBuffer(vkInitData.device, mesh.indices);
+    }
+}
+
+void cleanupVulkanMeshBuffers(VulkanInitData &vkInitData, VulkanMeshBuffers &buffers) {
+    if(buffers.vertices.buffer) {
+        cleanupVulkanBuffer(vkInitData.device, buffers.vertices);
+    }
+    if(buffers.indices.buffer) {
+        cleanupVulkanBuffer(vkInitData.device, buffers.indices);
+    }
 }
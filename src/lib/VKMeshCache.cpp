@@ -0,0 +1,636 @@
+#include "VKMeshCache.hpp"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <algorithm>
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// FILE LAYOUT
+// Header, then each section at the offset the header gives (16-byte aligned;
+// the vertex and index blobs are 256-byte aligned)
+///////////////////////////////////////////////////////////////////////////////
+
+static const char VULKAN_MESH_CACHE_MAGIC[8] = {'V', 'K', 'M', 'E', 'S', 'H', 'C', '\0'};
+static const uint64_t SECTION_ALIGNMENT = 16;
+static const uint64_t BLOB_ALIGNMENT = 256;
+
+struct VulkanMeshCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t vertexSize;
+    uint64_t settingsHash;
+    uint64_t sourceSize;
+    int64_t sourceMTime;
+    uint64_t sourceHash;
+    uint64_t fileSize;
+
+    uint32_t indexSize;             // 2 or 4
+    uint32_t meshCnt;
+    uint32_t lodCnt;                // LOD records of all meshes (LOD 0 included)
+    uint32_t nodeCnt;
+    uint32_t nodeMeshCnt;           // SceneGraph::meshIndices
+    uint32_t pad;
+
+    uint64_t meshesOffset;
+    uint64_t lodsOffset;
+    uint64_t nodesOffset;
+    uint64_t nodeMeshesOffset;
+    uint64_t namesOffset;
+    uint64_t namesSize;
+    uint64_t verticesOffset;
+    uint64_t verticesSize;
+    uint64_t indicesOffset;
+    uint64_t indicesSize;
+};
+
+struct VulkanMeshCacheMeshRecord {
+    uint32_t firstIndex;
+    uint32_t indexCnt;
+    int32_t vertexOffset;
+    uint32_t vertexCnt;
+    uint32_t firstLOD;
+    uint32_t lodCnt;
+    float boxMin[3];
+    float boxMax[3];
+    float sphereCenter[3];
+    float sphereRadius;
+};
+
+struct VulkanMeshCacheLODRecord {
+    uint32_t firstIndex;
+    uint32_t indexCnt;
+    float error;
+    uint32_t pad;
+};
+
+struct VulkanMeshCacheNodeRecord {
+    float local[16];                // Column major
+    int32_t parent;
+    uint32_t depth;
+    uint32_t subtreeEnd;
+    uint32_t meshStart;
+    uint32_t meshCnt;
+    uint32_t nameOffset;            // Into the names section
+    uint32_t nameLength;
+    uint32_t pad;
+};
+
+static uint64_t alignCacheOffset(uint64_t offset, uint64_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+template<typename R>
+static const R *getCacheSection(const VulkanMeshCacheFile &cacheFile, uint64_t offset) {
+    return reinterpret_cast<const R*>(cacheFile.data + offset);
+}
+
+static const VulkanMeshCacheHeader &getCacheHeader(const VulkanMeshCacheFile &cacheFile) {
+    return *reinterpret_cast<const VulkanMeshCacheHeader*>(cacheFile.data);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// KEYS
+///////////////////////////////////////////////////////////////////////////////
+
+uint64_t hashVulkanMeshCacheSettings(const string &settings, uint64_t seed) {
+    uint64_t hash = seed;
+    for(char c : settings) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t hashVulkanMeshCacheSource(string sourcePath) {
+    uint64_t hash = 14695981039346656037ull;
+
+    ifstream file(sourcePath, ios::binary);
+    vector<char> chunk(1 << 20);
+    while(file) {
+        file.read(chunk.data(), chunk.size());
+        streamsize readCnt = file.gcount();
+        for(streamsize i = 0; i < readCnt; i++) {
+            hash ^= static_cast<unsigned char>(chunk[i]);
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+bool getVulkanMeshCacheKey(string sourcePath, uint64_t settingsHash, VulkanMeshCacheKey &key) {
+    std::error_code error;
+    filesystem::path path = filesystem::absolute(sourcePath, error);
+    if(error) {
+        return false;
+    }
+
+    key.sourcePath = path.string();
+    key.sourceSize = filesystem::file_size(path, error);
+    if(error) {
+        return false;
+    }
+    key.sourceMTime = static_cast<int64_t>(filesystem::last_write_time(path, error).time_since_epoch().count());
+    if(error) {
+        return false;
+    }
+    key.settingsHash = settingsHash;
+    return true;
+}
+
+string getVulkanMeshCacheFilename(const VulkanMeshCacheKey &key, string directory) {
+    // Readable stem plus a hash of the full path (same file name in two folders)
+    ostringstream name;
+    name << filesystem::path(key.sourcePath).stem().string();
+    name << "_" << hex << setfill('0') << setw(16) << hashVulkanMeshCacheSettings(key.sourcePath);
+    name << "_" << setw(16) << key.settingsHash << ".vkmesh";
+
+    return directory + "/" + name.str();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// MAPPING
+///////////////////////////////////////////////////////////////////////////////
+
+static bool mapCacheFile(string filename, VulkanMeshCacheFile &cacheFile) {
+#ifdef _WIN32
+    // Shared for writing so updateCacheSourceMTime() can patch the header while mapped
+    HANDLE file = CreateFileA(  filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    // The mapping keeps the file open
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if(!mapping) {
+        return false;
+    }
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(!view) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    cacheFile.data = static_cast<const uint8_t*>(view);
+    cacheFile.size = static_cast<size_t>(fileSize.QuadPart);
+    cacheFile.mappingHandle = mapping;
+    return true;
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+
+    // The mapping keeps the file open
+    size_t fileSize = static_cast<size_t>(fileStat.st_size);
+    void *view = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(view == MAP_FAILED) {
+        return false;
+    }
+
+#ifdef MADV_SEQUENTIAL
+    madvise(view, fileSize, MADV_SEQUENTIAL);
+#endif
+
+    cacheFile.data = static_cast<const uint8_t*>(view);
+    cacheFile.size = fileSize;
+    cacheFile.mappingHandle = nullptr;
+    return true;
+#endif
+}
+
+void closeVulkanMeshCache(VulkanMeshCacheFile &cacheFile) {
+    if(!cacheFile.data) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(cacheFile.data);
+    CloseHandle(static_cast<HANDLE>(cacheFile.mappingHandle));
+#else
+    munmap(const_cast<uint8_t*>(cacheFile.data), cacheFile.size);
+#endif
+
+    cacheFile.data = nullptr;
+    cacheFile.size = 0;
+    cacheFile.mappingHandle = nullptr;
+}
+
+// Patches the header in place (only this one field, so a torn write can't
+// make the rest of the cache look valid)
+static bool updateCacheSourceMTime(string filename, int64_t sourceMTime) {
+    fstream file(filename, ios::in | ios::out | ios::binary);
+    if(!file) {
+        return false;
+    }
+    file.seekp(offsetof(VulkanMeshCacheHeader, sourceMTime));
+    file.write(reinterpret_cast<const char*>(&sourceMTime), sizeof(sourceMTime));
+    return static_cast<bool>(file);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// VALIDATION
+///////////////////////////////////////////////////////////////////////////////
+
+static bool isCacheSectionValid(const VulkanMeshCacheHeader &header, uint64_t offset, uint64_t size) {
+    return offset <= header.fileSize && size <= header.fileSize - offset;
+}
+
+// Everything later reads without checking is checked here
+static bool isVulkanMeshCacheLayoutValid(const VulkanMeshCacheFile &cacheFile) {
+    const VulkanMeshCacheHeader &header = getCacheHeader(cacheFile);
+
+    if(header.fileSize != cacheFile.size
+        || header.vertexSize == 0
+        || (header.indexSize != 2 && header.indexSize != 4)
+        || header.verticesSize % header.vertexSize != 0
+        || header.indicesSize % header.indexSize != 0
+        || header.meshesOffset % SECTION_ALIGNMENT != 0
+        || header.lodsOffset % SECTION_ALIGNMENT != 0
+        || header.nodesOffset % SECTION_ALIGNMENT != 0
+        || header.nodeMeshesOffset % SECTION_ALIGNMENT != 0
+        || !isCacheSectionValid(header, header.meshesOffset, sizeof(VulkanMeshCacheMeshRecord) * (uint64_t)header.meshCnt)
+        || !isCacheSectionValid(header, header.lodsOffset, sizeof(VulkanMeshCacheLODRecord) * (uint64_t)header.lodCnt)
+        || !isCacheSectionValid(header, header.nodesOffset, sizeof(VulkanMeshCacheNodeRecord) * (uint64_t)header.nodeCnt)
+        || !isCacheSectionValid(header, header.nodeMeshesOffset, sizeof(uint32_t) * (uint64_t)header.nodeMeshCnt)
+        || !isCacheSectionValid(header, header.namesOffset, header.namesSize)
+        || !isCacheSectionValid(header, header.verticesOffset, header.verticesSize)
+        || !isCacheSectionValid(header, header.indicesOffset, header.indicesSize)) {
+        return false;
+    }
+
+    uint64_t vertexCnt = header.verticesSize / header.vertexSize;
+    uint64_t indexCnt = header.indicesSize / header.indexSize;
+
+    const VulkanMeshCacheMeshRecord *meshes = getCacheSection<VulkanMeshCacheMeshRecord>(cacheFile, header.meshesOffset);
+    const VulkanMeshCacheLODRecord *lods = getCacheSection<VulkanMeshCacheLODRecord>(cacheFile, header.lodsOffset);
+    for(uint32_t i = 0; i < header.meshCnt; i++) {
+        const VulkanMeshCacheMeshRecord &mesh = meshes[i];
+        if(mesh.vertexOffset < 0
+            || (uint64_t)mesh.vertexOffset + mesh.vertexCnt > vertexCnt
+            || (uint64_t)mesh.firstIndex + mesh.indexCnt > indexCnt
+            || (uint64_t)mesh.firstLOD + mesh.lodCnt > header.lodCnt) {
+            return false;
+        }
+        for(uint32_t k = 0; k < mesh.lodCnt; k++) {
+            const VulkanMeshCacheLODRecord &lod = lods[mesh.firstLOD + k];
+            if((uint64_t)lod.firstIndex + lod.indexCnt > indexCnt) {
+                return false;
+            }
+        }
+    }
+
+    const VulkanMeshCacheNodeRecord *nodes = getCacheSection<VulkanMeshCacheNodeRecord>(cacheFile, header.nodesOffset);
+    const uint32_t *nodeMeshes = getCacheSection<uint32_t>(cacheFile, header.nodeMeshesOffset);
+    for(uint32_t i = 0; i < header.nodeCnt; i++) {
+        const VulkanMeshCacheNodeRecord &node = nodes[i];
+        if(node.parent >= (int32_t)i
+            || node.subtreeEnd <= i || node.subtreeEnd > header.nodeCnt
+            || (uint64_t)node.meshStart + node.meshCnt > header.nodeMeshCnt
+            || (uint64_t)node.nameOffset + node.nameLength > header.namesSize) {
+            return false;
+        }
+    }
+    for(uint32_t i = 0; i < header.nodeMeshCnt; i++) {
+        if(nodeMeshes[i] >= header.meshCnt) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool openVulkanMeshCache(   string filename,
+                            const VulkanMeshCacheKey &key,
+                            uint32_t vertexSize,
+                            VulkanMeshCacheFile &cacheFile) {
+    closeVulkanMeshCache(cacheFile);
+    if(!mapCacheFile(filename, cacheFile)) {
+        return false;
+    }
+
+    bool valid = cacheFile.size >= sizeof(VulkanMeshCacheHeader);
+    if(valid) {
+        const VulkanMeshCacheHeader &header = getCacheHeader(cacheFile);
+        valid = memcmp(header.magic, VULKAN_MESH_CACHE_MAGIC, sizeof(header.magic)) == 0
+                && header.version == VULKAN_MESH_CACHE_VERSION
+                && header.vertexSize == vertexSize
+                && header.settingsHash == key.settingsHash
+                && header.sourceSize == key.sourceSize;
+
+        // Touched (or copied) but not changed: only the contents decide
+        bool touched = valid && header.sourceMTime != key.sourceMTime;
+        if(touched) {
+            valid = header.sourceHash == hashVulkanMeshCacheSource(key.sourcePath);
+        }
+
+        if(valid) {
+            valid = isVulkanMeshCacheLayoutValid(cacheFile);
+        }
+
+        // Store the new mtime so later starts don't hash the source again
+        if(valid && touched) {
+            cout << "openVulkanMeshCache: " << key.sourcePath << " was touched but is unchanged" << endl;
+            if(!updateCacheSourceMTime(filename, key.sourceMTime)) {
+                cout << "openVulkanMeshCache: Could not update " << filename << endl;
+            }
+        }
+    }
+
+    if(!valid) {
+        cout << "openVulkanMeshCache: Ignoring stale or invalid cache " << filename << endl;
+        closeVulkanMeshCache(cacheFile);
+    }
+    return valid;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// READING
+///////////////////////////////////////////////////////////////////////////////
+
+SceneGraph getVulkanMeshCacheSceneGraph(const VulkanMeshCacheFile &cacheFile) {
+    const VulkanMeshCacheHeader &header = getCacheHeader(cacheFile);
+    const VulkanMeshCacheNodeRecord *nodes = getCacheSection<VulkanMeshCacheNodeRecord>(cacheFile, header.nodesOffset);
+    const uint32_t *nodeMeshes = getCacheSection<uint32_t>(cacheFile, header.nodeMeshesOffset);
+    const char *names = getCacheSection<char>(cacheFile, header.namesOffset);
+
+    SceneGraph graph;
+    for(uint32_t i = 0; i < header.nodeCnt; i++) {
+        const VulkanMeshCacheNodeRecord &node = nodes[i];
+        glm::mat4 local;
+        memcpy(&local[0][0], node.local, sizeof(node.local));
+
+        graph.parent.push_back(node.parent);
+        graph.depth.push_back(node.depth);
+        graph.subtreeEnd.push_back(node.subtreeEnd);
+        graph.names.push_back(string(names + node.nameOffset, node.nameLength));
+        graph.local.push_back(local);
+        graph.meshStart.push_back(node.meshStart);
+        graph.meshCnt.push_back(node.meshCnt);
+    }
+    graph.meshIndices.assign(nodeMeshes, nodeMeshes + header.nodeMeshCnt);
+
+    completeSceneGraph(graph);
+    return graph;
+}
+
+vector<MeshBounds> getVulkanMeshCacheBounds(const VulkanMeshCacheFile &cacheFile) {
+    const VulkanMeshCacheHeader &header = getCacheHeader(cacheFile);
+    const VulkanMeshCacheMeshRecord *meshes = getCacheSection<VulkanMeshCacheMeshRecord>(cacheFile, header.meshesOffset);
+
+    vector<MeshBounds> allBounds;
+    for(uint32_t i = 0; i < header.meshCnt; i++) {
+        MeshBounds bounds;
+        bounds.box.min = glm::vec3(meshes[i].boxMin[0], meshes[i].boxMin[1], meshes[i].boxMin[2]);
+        bounds.box.max = glm::vec3(meshes[i].boxMax[0], meshes[i].boxMax[1], meshes[i].boxMax[2]);
+        bounds.sphere.center = glm::vec3(meshes[i].sphereCenter[0], meshes[i].sphereCenter[1], meshes[i].sphereCenter[2]);
+        bounds.sphere.radius = meshes[i].sphereRadius;
+        allBounds.push_back(bounds);
+    }
+    return allBounds;
+}
+
+vector<VulkanMesh> queueVulkanMeshCacheUpload(  VulkanUploadBatch &batch,
+                                                const VulkanMeshCacheFile &cacheFile,
+                                                VulkanMeshBuffers &sharedBuffers) {
+    VulkanInitData &vkInitData = *batch.vkInitData;
+    const VulkanMeshCacheHeader &header = getCacheHeader(cacheFile);
+    const VulkanMeshCacheMeshRecord *records = getCacheSection<VulkanMeshCacheMeshRecord>(cacheFile, header.meshesOffset);
+    const VulkanMeshCacheLODRecord *lods = getCacheSection<VulkanMeshCacheLODRecord>(cacheFile, header.lodsOffset);
+
+    sharedBuffers.indexType = (header.indexSize == 2) ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+
+    vector<VulkanMesh> allMeshes;
+    for(uint32_t i = 0; i < header.meshCnt; i++) {
+        VulkanMesh mesh;
+        mesh.indexCnt = static_cast<int>(records[i].indexCnt);
+        mesh.firstIndex = records[i].firstIndex;
+        mesh.vertexOffset = records[i].vertexOffset;
+        mesh.indexType = sharedBuffers.indexType;
+        for(uint32_t k = 0; k < records[i].lodCnt; k++) {
+            const VulkanMeshCacheLODRecord &lod = lods[records[i].firstLOD + k];
+            mesh.lods.push_back({lod.firstIndex, static_cast<int>(lod.indexCnt), lod.error});
+        }
+        allMeshes.push_back(std::move(mesh));
+    }
+
+    if(header.verticesSize == 0 || header.indicesSize == 0) {
+        return allMeshes;
+    }
+
+    sharedBuffers.vertices = createVulkanBuffer(
+        vkInitData.physicalDevice, vkInitData.device, header.verticesSize,
+        vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst
+        | vk::BufferUsageFlagBits::eTransferSrc,
+        vk::MemoryPropertyFlagBits::eDeviceLocal, VulkanMemoryTag::Mesh);
+
+    sharedBuffers.indices = createVulkanBuffer(
+        vkInitData.physicalDevice, vkInitData.device, header.indicesSize,
+        vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst
+        | vk::BufferUsageFlagBits::eTransferSrc,
+        vk::MemoryPropertyFlagBits::eDeviceLocal, VulkanMemoryTag::Mesh);
+
+    // Straight from the mapping into the staging ring
+    queueVulkanBufferUpload(batch, sharedBuffers.vertices, 0, header.verticesSize,
+                            cacheFile.data + header.verticesOffset);
+    queueVulkanBufferUpload(batch, sharedBuffers.indices, 0, header.indicesSize,
+                            cacheFile.data + header.indicesOffset);
+
+    return allMeshes;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// WRITING
+///////////////////////////////////////////////////////////////////////////////
+
+void copyVulkanMeshCacheIndices(VulkanMeshCacheData &data, unsigned int firstIndex, const vector<unsigned int> &indices) {
+    if(indices.empty()) {
+        return;
+    }
+
+    size_t indexSize = getVulkanIndexSize(data.indexType);
+    size_t start = indexSize * firstIndex;
+    if(start + indexSize * indices.size() > data.indices.size()) {
+        throw runtime_error("copyVulkanMeshCacheIndices: Index range is outside the index blob!");
+    }
+
+    if(data.indexType == vk::IndexType::eUint16) {
+        vector<uint16_t> narrowIndices(indices.begin(), indices.end());
+        memcpy(data.indices.data() + start, narrowIndices.data(), indexSize * narrowIndices.size());
+    }
+    else {
+        memcpy(data.indices.data() + start, indices.data(), indexSize * indices.size());
+    }
+}
+
+static void writeCacheBytes(ofstream &file, uint64_t &written, uint64_t offset, const void *data, uint64_t size) {
+    // Zero padding up to the section
+    static const char zeros[BLOB_ALIGNMENT] = {};
+    while(written < offset) {
+        uint64_t pad = std::min<uint64_t>(offset - written, BLOB_ALIGNMENT);
+        file.write(zeros, pad);
+        written += pad;
+    }
+
+    if(size > 0) {
+        file.write(static_cast<const char*>(data), size);
+        written += size;
+    }
+}
+
+bool saveVulkanMeshCacheData(   string filename,
+                                const VulkanMeshCacheKey &key,
+                                const VulkanMeshCacheData &data,
+                                const SceneGraph &graph) {
+    // Flatten everything into records
+    vector<VulkanMeshCacheMeshRecord> meshes;
+    vector<VulkanMeshCacheLODRecord> lods;
+    for(size_t i = 0; i < data.meshes.size(); i++) {
+        const VulkanMesh &mesh = data.meshes[i];
+        const MeshBounds &bounds = data.bounds[i];
+
+        VulkanMeshCacheMeshRecord record = {};
+        record.firstIndex = mesh.firstIndex;
+        record.indexCnt = static_cast<uint32_t>(mesh.indexCnt);
+        record.vertexOffset = mesh.vertexOffset;
+        record.vertexCnt = data.vertexCnts[i];
+        record.firstLOD = static_cast<uint32_t>(lods.size());
+        record.lodCnt = static_cast<uint32_t>(mesh.lods.size());
+        for(int c = 0; c < 3; c++) {
+            record.boxMin[c] = bounds.box.min[c];
+            record.boxMax[c] = bounds.box.max[c];
+            record.sphereCenter[c] = bounds.sphere.center[c];
+        }
+        record.sphereRadius = bounds.sphere.radius;
+        meshes.push_back(record);
+
+        for(auto &lod : mesh.lods) {
+            lods.push_back({lod.firstIndex, static_cast<uint32_t>(lod.indexCnt), lod.error, 0});
+        }
+    }
+
+    vector<VulkanMeshCacheNodeRecord> nodes;
+    string names;
+    for(size_t i = 0; i < graph.parent.size(); i++) {
+        VulkanMeshCacheNodeRecord node = {};
+        memcpy(node.local, &graph.local[i][0][0], sizeof(node.local));
+        node.parent = graph.parent[i];
+        node.depth = graph.depth[i];
+        node.subtreeEnd = graph.subtreeEnd[i];
+        node.meshStart = graph.meshStart[i];
+        node.meshCnt = graph.meshCnt[i];
+        node.nameOffset = static_cast<uint32_t>(names.size());
+        node.nameLength = static_cast<uint32_t>(graph.names[i].size());
+        names += graph.names[i];
+        nodes.push_back(node);
+    }
+
+    // Lay out the sections
+    VulkanMeshCacheHeader header = {};
+    memcpy(header.magic, VULKAN_MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = VULKAN_MESH_CACHE_VERSION;
+    header.vertexSize = data.vertexSize;
+    header.settingsHash = key.settingsHash;
+    header.sourceSize = key.sourceSize;
+    header.sourceMTime = key.sourceMTime;
+    header.sourceHash = hashVulkanMeshCacheSource(key.sourcePath);
+    header.indexSize = static_cast<uint32_t>(getVulkanIndexSize(data.indexType));
+    header.meshCnt = static_cast<uint32_t>(meshes.size());
+    header.lodCnt = static_cast<uint32_t>(lods.size());
+    header.nodeCnt = static_cast<uint32_t>(nodes.size());
+    header.nodeMeshCnt = static_cast<uint32_t>(graph.meshIndices.size());
+
+    uint64_t offset = sizeof(VulkanMeshCacheHeader);
+    auto placeSection = [&offset](uint64_t size, uint64_t alignment) {
+        offset = alignCacheOffset(offset, alignment);
+        uint64_t sectionOffset = offset;
+        offset += size;
+        return sectionOffset;
+    };
+    header.meshesOffset = placeSection(sizeof(VulkanMeshCacheMeshRecord) * meshes.size(), SECTION_ALIGNMENT);
+    header.lodsOffset = placeSection(sizeof(VulkanMeshCacheLODRecord) * lods.size(), SECTION_ALIGNMENT);
+    header.nodesOffset = placeSection(sizeof(VulkanMeshCacheNodeRecord) * nodes.size(), SECTION_ALIGNMENT);
+    header.nodeMeshesOffset = placeSection(sizeof(uint32_t) * graph.meshIndices.size(), SECTION_ALIGNMENT);
+    header.namesSize = names.size();
+    header.namesOffset = placeSection(header.namesSize, SECTION_ALIGNMENT);
+    header.verticesSize = data.vertices.size();
+    header.verticesOffset = placeSection(header.verticesSize, BLOB_ALIGNMENT);
+    header.indicesSize = data.indices.size();
+    header.indicesOffset = placeSection(header.indicesSize, BLOB_ALIGNMENT);
+    header.fileSize = offset;
+
+    // Write to a temporary file first so a crash never leaves half a cache
+    std::error_code error;
+    filesystem::path path(filename);
+    if(path.has_parent_path()) {
+        filesystem::create_directories(path.parent_path(), error);
+    }
+
+    string tempFilename = filename + ".tmp";
+    {
+        ofstream file(tempFilename, ios::binary | ios::trunc);
+        if(!file.is_open()) {
+            cerr << "saveVulkanMeshCacheData: Could not write " << tempFilename << endl;
+            return false;
+        }
+
+        uint64_t written = 0;
+        writeCacheBytes(file, written, 0, &header, sizeof(header));
+        writeCacheBytes(file, written, header.meshesOffset, meshes.data(), sizeof(VulkanMeshCacheMeshRecord) * meshes.size());
+        writeCacheBytes(file, written, header.lodsOffset, lods.data(), sizeof(VulkanMeshCacheLODRecord) * lods.size());
+        writeCacheBytes(file, written, header.nodesOffset, nodes.data(), sizeof(VulkanMeshCacheNodeRecord) * nodes.size());
+        writeCacheBytes(file, written, header.nodeMeshesOffset, graph.meshIndices.data(),
+                        sizeof(uint32_t) * graph.meshIndices.size());
+        writeCacheBytes(file, written, header.namesOffset, names.data(), names.size());
+        writeCacheBytes(file, written, header.verticesOffset, data.vertices.data(), data.vertices.size());
+        writeCacheBytes(file, written, header.indicesOffset, data.indices.data(), data.indices.size());
+
+        if(!file) {
+            cerr << "saveVulkanMeshCacheData: Failed writing " << tempFilename << endl;
+            file.close();
+            filesystem::remove(tempFilename, error);
+            return false;
+        }
+    }
+
+    filesystem::rename(tempFilename, filename, error);
+    if(error) {
+        cerr << "saveVulkanMeshCacheData: Could not replace " << filename << ": " << error.message() << endl;
+        filesystem::remove(tempFilename, error);
+        return false;
+    }
+
+    return true;
+}
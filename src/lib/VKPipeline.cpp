@@ -0,0 +1,270 @@
+#include "VKPipeline.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// PIPELINE CREATION
+///////////////////////////////////////////////////////////////////////////////
+
+// FNV-1a over raw bytes
+static uint64_t hashBytes(const void *data, size_t size, uint64_t hash) {
+    const unsigned char *bytes = static_cast<const unsigned char*>(data);
+    for(size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+template<typename T>
+static uint64_t hashValue(const T &value, uint64_t hash) {
+    return hashBytes(&value, sizeof(T), hash);
+}
+
+uint64_t hashVulkanPipelineDesc(VulkanPipelineDesc &desc,
+                                const vector<char> &vertShaderCode,
+                                const vector<char> &fragShaderCode) {
+    uint64_t hash = hashVulkanShaderCode(vertShaderCode);
+    hash = hashVulkanShaderCode(fragShaderCode, hash);
+
+    // Vertex layout
+    vk::VertexInputBindingDescription &bindDesc = desc.attribDescData.bindDesc;
+    hash = hashValue(bindDesc.binding, hash);
+    hash = hashValue(bindDesc.stride, hash);
+    hash = hashValue(bindDesc.inputRate, hash);
+    for(auto &instanceBind : desc.attribDescData.instanceBindDesc) {
+        hash = hashValue(instanceBind.binding, hash);
+        hash = hashValue(instanceBind.stride, hash);
+        hash = hashValue(instanceBind.inputRate, hash);
+    }
+    for(auto &attrib : desc.attribDescData.attribDesc) {
+        hash = hashValue(attrib.location, hash);
+        hash = hashValue(attrib.binding, hash);
+        hash = hashValue(attrib.format, hash);
+        hash = hashValue(attrib.offset, hash);
+    }
+
+    // Fixed-function state
+    hash = hashValue(desc.topology, hash);
+    hash = hashValue(desc.polygonMode, hash);
+    hash = hashValue(static_cast<VkCullModeFlags>(desc.cullMode), hash);
+    hash = hashValue(desc.frontFace, hash);
+    hash = hashValue(desc.depthTest, hash);
+    hash = hashValue(desc.depthWrite, hash);
+    hash = hashValue(desc.depthCompare, hash);
+    hash = hashValue(desc.alphaBlend, hash);
+
+    return hash;
+}
+
+vk::Pipeline createVulkanGraphicsPipeline(  vk::Device &device,
+                                            VulkanPipelineDesc &desc,
+                                            const vector<char> &vertShaderCode,
+                                            const vector<char> &fragShaderCode,
+                                            vk::RenderPass &renderPass,
+                                            vk::PipelineLayout &pipelineLayout,
+                                            vk::PipelineCache &cache) {
+
+    // Modules are only needed until the pipeline is created
+    vk::ShaderModule vertShaderModule = createVulkanShaderModule(device, vertShaderCode);
+    vk::ShaderModule fragShaderModule = createVulkanShaderModule(device, fragShaderCode);
+
+    vk::PipelineShaderStageCreateInfo shaderStages[] = {
+        vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eVertex, vertShaderModule, "main"),
+        vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eFragment, fragShaderModule, "main")
+    };
+
+    // Vertex layout (per-vertex binding first, then any per-instance ones) and primitives
+    vector<vk::VertexInputBindingDescription> bindDescs = {desc.attribDescData.bindDesc};
+    bindDescs.insert(bindDescs.end(), 
+                    desc.attribDescData.instanceBindDesc.begin(), 
+                    desc.attribDescData.instanceBindDesc.end());
+    vk::PipelineVertexInputStateCreateInfo vertexInputInfo(
+        {}, bindDescs, desc.attribDescData.attribDesc);
+    vk::PipelineInputAssemblyStateCreateInfo inputAssembly({}, desc.topology, false);
+
+    // Viewport and scissors are set when recording
+    vector<vk::DynamicState> dynamicStates = {
+        vk::DynamicState::eViewport,
+        vk::DynamicState::eScissor        
+    };
+    vk::PipelineDynamicStateCreateInfo dynamicState({}, dynamicStates);  
+    vk::PipelineViewportStateCreateInfo viewportState({}, 1, nullptr, 1, nullptr);
+
+    vk::PipelineRasterizationStateCreateInfo rasterizer {};
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.polygonMode = desc.polygonMode;
+    rasterizer.cullMode = desc.cullMode;
+    rasterizer.frontFace = desc.frontFace;
+
+    vk::PipelineColorBlendAttachmentState colorBlendAttachment {};
+    colorBlendAttachment.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG 
+                                        | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+    if(desc.alphaBlend) {
+        colorBlendAttachment.blendEnable = true;
+        colorBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+        colorBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+        colorBlendAttachment.colorBlendOp = vk::BlendOp::eAdd;
+        colorBlendAttachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
+        colorBlendAttachment.dstAlphaBlendFactor = vk::BlendFactor::eZero;
+        colorBlendAttachment.alphaBlendOp = vk::BlendOp::eAdd;
+    }
+    vk::PipelineColorBlendStateCreateInfo colorBlending({}, false, vk::LogicOp::eCopy, colorBlendAttachment);
+
+    vk::PipelineDepthStencilStateCreateInfo depthStencil(
+        {}, desc.depthTest, desc.depthWrite, desc.depthCompare,
+        false, false, {}, {});
+
+    vk::PipelineMultisampleStateCreateInfo multisample({}, vk::SampleCountFlagBits::e1);
+
+    vk::GraphicsPipelineCreateInfo pipelineInfo(vk::PipelineCreateFlags(),
+                                                shaderStages,
+                                                &vertexInputInfo,
+                                                &inputAssembly,
+                                                0,
+                                                &viewportState,
+                                                &rasterizer,
+                                                &multisample,
+                                                &depthStencil,
+                                                &colorBlending,
+                                                &dynamicState,
+                                                pipelineLayout,
+                                                renderPass);    
+    
+    auto ret = device.createGraphicsPipeline(cache, pipelineInfo);
+
+    device.destroyShaderModule(fragShaderModule);
+    device.destroyShaderModule(vertShaderModule);
+
+    if (ret.result != vk::Result::eSuccess) {
+        throw runtime_error("Failed to create graphics pipeline!");
+    }
+
+    return ret.value;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// REGISTRY WORKERS
+///////////////////////////////////////////////////////////////////////////////
+
+static void runVulkanPipelineWorker(VulkanPipelineRegistry *registry) {
+    while(true) {
+        VulkanPipelineEntry *entry = nullptr;
+        {
+            unique_lock<mutex> guard(registry->jobLock);
+            registry->jobReady.wait(guard, [registry]() { return registry->stopping || !registry->jobs.empty(); });
+            if(registry->stopping) {
+                return;
+            }
+            entry = registry->jobs.front();
+            registry->jobs.pop_front();
+        }
+
+        // Pipeline creation (and the cache) are safe to use from several threads
+        try {
+            entry->pipeline = createVulkanGraphicsPipeline( registry->device, entry->desc,
+                                                            *entry->vertShaderCode, *entry->fragShaderCode,
+                                                            registry->renderPass, registry->pipelineLayout,
+                                                            registry->cache);
+            entry->state.store(VulkanPipelineState::Ready, memory_order_release);
+        }
+        catch(const exception &e) {
+            cerr << "VulkanPipelineRegistry: Failed to compile " << entry->desc.vertSPVFilename 
+                << " + " << entry->desc.fragSPVFilename << ": " << e.what() << endl;
+            entry->state.store(VulkanPipelineState::Failed, memory_order_release);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// REGISTRY
+///////////////////////////////////////////////////////////////////////////////
+
+void createVulkanPipelineRegistry(  VulkanInitData &vkInitData,
+                                    VulkanPipelineRegistry &registry,
+                                    vk::RenderPass &renderPass,
+                                    vk::PipelineLayout &pipelineLayout,
+                                    vk::PipelineCache &cache,
+                                    vk::Pipeline &fallback,
+                                    unsigned int workerCnt) {
+    registry.device = vkInitData.device;
+    registry.renderPass = renderPass;
+    registry.pipelineLayout = pipelineLayout;
+    registry.cache = cache;
+    registry.fallback = fallback;
+
+    registry.stopping = false;
+    for(unsigned int i = 0; i < workerCnt; i++) {
+        registry.workers.push_back(thread(runVulkanPipelineWorker, &registry));
+    }
+}
+
+// Shader files are read once and kept for every variant that uses them
+static const vector<char>* getVulkanRegistryShaderCode(VulkanPipelineRegistry &registry, string filename) {
+    auto it = registry.shaderCode.find(filename);
+    if(it == registry.shaderCode.end()) {
+        auto code = make_unique<vector<char>>(readBinaryFile(filename));
+        it = registry.shaderCode.emplace(filename, std::move(code)).first;
+    }
+    return it->second.get();
+}
+
+uint64_t requestVulkanPipeline(VulkanPipelineRegistry &registry, VulkanPipelineDesc &desc) {
+    const vector<char> *vertCode = getVulkanRegistryShaderCode(registry, desc.vertSPVFilename);
+    const vector<char> *fragCode = getVulkanRegistryShaderCode(registry, desc.fragSPVFilename);
+    uint64_t key = hashVulkanPipelineDesc(desc, *vertCode, *fragCode);
+
+    if(registry.entries.find(key) != registry.entries.end()) {
+        return key;
+    }
+
+    auto entry = make_unique<VulkanPipelineEntry>();
+    entry->key = key;
+    entry->desc = desc;
+    entry->vertShaderCode = vertCode;
+    entry->fragShaderCode = fragCode;
+    VulkanPipelineEntry *job = entry.get();
+    registry.entries.emplace(key, std::move(entry));
+
+    {
+        lock_guard<mutex> guard(registry.jobLock);
+        registry.jobs.push_back(job);
+    }
+    registry.jobReady.notify_one();
+
+    return key;
+}
+
+bool isVulkanPipelineReady(VulkanPipelineRegistry &registry, uint64_t key) {
+    auto it = registry.entries.find(key);
+    return it != registry.entries.end() 
+            && it->second->state.load(memory_order_acquire) == VulkanPipelineState::Ready;
+}
+
+vk::Pipeline getVulkanPipeline(VulkanPipelineRegistry &registry, uint64_t key) {
+    if(isVulkanPipelineReady(registry, key)) {
+        return registry.entries[key]->pipeline;
+    }
+    return registry.fallback;
+}
+
+void cleanupVulkanPipelineRegistry(VulkanPipelineRegistry &registry) {
+    // Anything not started yet is dropped; running compiles finish first
+    {
+        lock_guard<mutex> guard(registry.jobLock);
+        registry.stopping = true;
+        registry.jobs.clear();
+    }
+    registry.jobReady.notify_all();
+
+    for(auto &worker : registry.workers) {
+        worker.join();
+    }
+    registry.workers.clear();
+
+    for(auto &it : registry.entries) {
+        if(it.second->state.load() == VulkanPipelineState::Ready) {
+            registry.device.destroyPipeline(it.second->pipeline);
+        }
+    }
+    registry.entries.clear();
+    registry.shaderCode.clear();
+}
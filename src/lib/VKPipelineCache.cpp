@@ -0,0 +1,141 @@
+#include "VKPipelineCache.hpp"
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+
+///////////////////////////////////////////////////////////////////////////////
+// KEYS
+///////////////////////////////////////////////////////////////////////////////
+
+// FNV-1a (chain calls by passing the previous hash as the seed)
+uint64_t hashVulkanShaderCode(const vector<char> &code, uint64_t seed) {
+    uint64_t hash = seed;
+    for(char c : code) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+string getVulkanPipelineCacheFilename(  VulkanInitData &vkInitData,
+                                        uint64_t shaderHash,
+                                        string directory) {
+    vk::PhysicalDeviceProperties properties = vkInitData.physicalDevice.getProperties();
+
+    ostringstream name;
+    name << hex << setfill('0');
+    for(unsigned int i = 0; i < VK_UUID_SIZE; i++) {
+        name << setw(2) << static_cast<unsigned int>(properties.pipelineCacheUUID[i]);
+    }
+    name << "_" << setw(8) << properties.driverVersion;
+    name << "_" << setw(16) << shaderHash << ".bin";
+
+    return directory + "/" + name.str();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// VALIDATION
+///////////////////////////////////////////////////////////////////////////////
+
+// Header the driver puts at the start of the data (version ONE)
+struct VulkanPipelineCacheHeader {
+    uint32_t headerSize;
+    uint32_t headerVersion;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+};
+
+bool isVulkanPipelineCacheDataValid(VulkanInitData &vkInitData, const vector<char> &data) {
+    if(data.size() < sizeof(VulkanPipelineCacheHeader)) {
+        return false;
+    }
+
+    VulkanPipelineCacheHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+
+    vk::PhysicalDeviceProperties properties = vkInitData.physicalDevice.getProperties();
+
+    return header.headerSize >= sizeof(VulkanPipelineCacheHeader)
+            && header.headerSize <= data.size()
+            && header.headerVersion == static_cast<uint32_t>(vk::PipelineCacheHeaderVersion::eOne)
+            && header.vendorID == properties.vendorID
+            && header.deviceID == properties.deviceID
+            && memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// LOAD AND SAVE
+///////////////////////////////////////////////////////////////////////////////
+
+vk::PipelineCache loadVulkanPipelineCache(VulkanInitData &vkInitData, string filename) {
+    vector<char> data;
+
+    ifstream file(filename, ios::ate | ios::binary);
+    if(file.is_open()) {
+        size_t fileSize = static_cast<size_t>(file.tellg());
+        data.resize(fileSize);
+        file.seekg(0);
+        file.read(data.data(), fileSize);
+        file.close();
+
+        if(!isVulkanPipelineCacheDataValid(vkInitData, data)) {
+            cout << "loadVulkanPipelineCache: Ignoring stale or invalid cache " << filename << endl;
+            data.clear();
+        }
+    }
+
+    vk::PipelineCacheCreateInfo cacheInfo;
+    if(!data.empty()) {
+        cacheInfo.setInitialDataSize(data.size())
+                 .setPInitialData(data.data());
+    }
+
+    try {
+        return vkInitData.device.createPipelineCache(cacheInfo);
+    }
+    catch(const vk::SystemError &e) {
+        // Driver rejected the data after all; start over
+        cout << "loadVulkanPipelineCache: Driver rejected " << filename << "; starting empty." << endl;
+        return vkInitData.device.createPipelineCache(vk::PipelineCacheCreateInfo());
+    }
+}
+
+bool saveVulkanPipelineCache(VulkanInitData &vkInitData, vk::PipelineCache &cache, string filename) {
+    if(!cache) {
+        return false;
+    }
+
+    vector<uint8_t> data = vkInitData.device.getPipelineCacheData(cache);
+    if(data.empty()) {
+        return false;
+    }
+
+    // Write to a temporary file first so a crash never leaves half a cache
+    std::error_code error;
+    filesystem::path path(filename);
+    if(path.has_parent_path()) {
+        filesystem::create_directories(path.parent_path(), error);
+    }
+
+    string tempFilename = filename + ".tmp";
+    {
+        ofstream file(tempFilename, ios::binary | ios::trunc);
+        if(!file.is_open()) {
+            cerr << "saveVulkanPipelineCache: Could not write " << tempFilename << endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    }
+
+    filesystem::rename(tempFilename, filename, error);
+    if(error) {
+        cerr << "saveVulkanPipelineCache: Could not replace " << filename << ": " << error.message() << endl;
+        filesystem::remove(tempFilename, error);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,278 @@
+#include "VKProfiler.hpp"
+#include <iomanip>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// SETUP
+///////////////////////////////////////////////////////////////////////////////
+
+static vk::QueryPool createVulkanTimestampPool(vk::Device &device, unsigned int queryCnt) {
+    return device.createQueryPool(vk::QueryPoolCreateInfo({}, vk::QueryType::eTimestamp, queryCnt));
+}
+
+static uint64_t getTimestampMask(unsigned int validBits) {
+    return (validBits >= 64) ? ~0ull : ((1ull << validBits) - 1);
+}
+
+VulkanGPUProfiler createVulkanGPUProfiler(  VulkanInitData &vkInitData,
+                                            unsigned int frameCnt,
+                                            unsigned int maxScopes,
+                                            unsigned int uploadTimerCnt) {
+    VulkanGPUProfiler profiler;
+
+    vk::PhysicalDeviceProperties properties = vkInitData.physicalDevice.getProperties();
+    vector<vk::QueueFamilyProperties> families = vkInitData.physicalDevice.getQueueFamilyProperties();
+
+    unsigned int graphicsBits = families.at(vkInitData.graphicsQueue.index).timestampValidBits;
+    if(graphicsBits == 0) {
+        cout << "VulkanGPUProfiler: Graphics queue does not support timestamps; profiling disabled." << endl;
+        return profiler;
+    }
+
+    profiler.enabled = true;
+    profiler.msPerTick = properties.limits.timestampPeriod / 1000000.0;
+    profiler.timestampMask = getTimestampMask(graphicsBits);
+    profiler.maxQueries = maxScopes * 2;
+
+    for(unsigned int i = 0; i < frameCnt; i++) {
+        VulkanGPUProfilerFrame frame;
+        frame.queryPool = createVulkanTimestampPool(vkInitData.device, profiler.maxQueries);
+        profiler.frames.push_back(frame);
+    }
+
+    // Queries can only be reset on graphics/compute queues
+    vk::QueueFamilyProperties &transferFamily = families.at(vkInitData.transferQueue.index);
+    bool canReset = bool(transferFamily.queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute));
+    bool sameMask = getTimestampMask(transferFamily.timestampValidBits) == profiler.timestampMask;
+    if(uploadTimerCnt > 0 && canReset && sameMask && transferFamily.timestampValidBits > 0) {
+        profiler.uploadsEnabled = true;
+        profiler.uploadQueryPool = createVulkanTimestampPool(vkInitData.device, uploadTimerCnt * 2);
+        profiler.uploadTimerBusy.resize(uploadTimerCnt, false);
+    }
+
+    return profiler;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// RESULTS
+///////////////////////////////////////////////////////////////////////////////
+
+static void addVulkanGPUSample(VulkanGPUProfiler &profiler, string name, double ms) {
+    VulkanGPUScopeStats *entry = nullptr;
+    for(auto &s : profiler.stats) {
+        if(s.name == name) {
+            entry = &s;
+            break;
+        }
+    }
+    if(!entry) {
+        VulkanGPUScopeStats s;
+        s.name = name;
+        s.minMS = ms;
+        s.maxMS = ms;
+        profiler.stats.push_back(s);
+        entry = &profiler.stats.back();
+    }
+
+    entry->sampleCnt++;
+    entry->totalMS += ms;
+    entry->minMS = std::min(entry->minMS, ms);
+    entry->maxMS = std::max(entry->maxMS, ms);
+    entry->lastMS = ms;
+}
+
+static double getElapsedMS(VulkanGPUProfiler &profiler, uint64_t start, uint64_t end) {
+    uint64_t ticks = (end - start) & profiler.timestampMask;
+    return ticks * profiler.msPerTick;
+}
+
+// Read everything the slot recorded last time it was used
+static void collectVulkanGPUProfilerFrame(vk::Device &device, VulkanGPUProfiler &profiler, VulkanGPUProfilerFrame &frame) {
+    if(frame.queryCnt == 0) {
+        frame.scopes.clear();
+        return;
+    }
+
+    auto results = device.getQueryPoolResults<uint64_t>(frame.queryPool, 0, frame.queryCnt,
+                                                        frame.queryCnt * sizeof(uint64_t), sizeof(uint64_t),
+                                                        vk::QueryResultFlagBits::e64);
+
+    // Only report complete frames (e.g., a frame that was never submitted)
+    if(results.result == vk::Result::eSuccess) {
+        profiler.lastFrameResults.clear();
+        for(auto &scope : frame.scopes) {
+            if(scope.recorded) {
+                double ms = getElapsedMS(profiler, results.value[scope.beginQuery], results.value[scope.beginQuery + 1]);
+                profiler.lastFrameResults.push_back({ scope.name, scope.depth, ms });
+                addVulkanGPUSample(profiler, scope.name, ms);
+            }
+        }
+    }
+
+    frame.scopes.clear();
+    frame.queryCnt = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// FRAME SCOPES
+///////////////////////////////////////////////////////////////////////////////
+
+void beginVulkanGPUProfilerFrame(   vk::Device &device,
+                                    VulkanGPUProfiler &profiler,
+                                    unsigned int frameSlot,
+                                    vk::CommandBuffer &commandBuffer) {
+    commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+    if(profiler.enabled) {
+        VulkanGPUProfilerFrame &frame = profiler.frames.at(frameSlot);
+        collectVulkanGPUProfilerFrame(device, profiler, frame);
+        commandBuffer.resetQueryPool(frame.queryPool, 0, profiler.maxQueries);
+
+        profiler.currentFrame = frameSlot;
+        profiler.openScopes.clear();
+    }
+
+    commandBuffer.end();
+}
+
+void beginVulkanGPUScope(VulkanGPUProfiler &profiler, vk::CommandBuffer &commandBuffer, string name) {
+    if(!profiler.enabled) {
+        return;
+    }
+
+    VulkanGPUProfilerFrame &frame = profiler.frames.at(profiler.currentFrame);
+
+    VulkanGPUScope scope;
+    scope.name = name;
+    scope.depth = static_cast<unsigned int>(profiler.openScopes.size());
+    scope.beginQuery = frame.queryCnt;
+    scope.recorded = (frame.queryCnt + 2 <= profiler.maxQueries);
+
+    // Both queries are reserved now (so end is always beginQuery + 1)
+    if(scope.recorded) {
+        commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, frame.queryPool, scope.beginQuery);
+        frame.queryCnt += 2;
+    }
+
+    profiler.openScopes.push_back(static_cast<unsigned int>(frame.scopes.size()));
+    frame.scopes.push_back(scope);
+}
+
+void endVulkanGPUScope(VulkanGPUProfiler &profiler, vk::CommandBuffer &commandBuffer) {
+    if(!profiler.enabled || profiler.openScopes.empty()) {
+        return;
+    }
+
+    VulkanGPUProfilerFrame &frame = profiler.frames.at(profiler.currentFrame);
+    VulkanGPUScope &scope = frame.scopes.at(profiler.openScopes.back());
+    profiler.openScopes.pop_back();
+
+    if(scope.recorded) {
+        commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, frame.queryPool, scope.beginQuery + 1);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// UPLOAD TIMERS
+///////////////////////////////////////////////////////////////////////////////
+
+int beginVulkanGPUUploadTimer(VulkanGPUProfiler &profiler, vk::CommandBuffer &commandBuffer) {
+    if(!profiler.uploadsEnabled) {
+        return -1;
+    }
+
+    for(unsigned int i = 0; i < profiler.uploadTimerBusy.size(); i++) {
+        if(!profiler.uploadTimerBusy[i]) {
+            profiler.uploadTimerBusy[i] = true;
+            commandBuffer.resetQueryPool(profiler.uploadQueryPool, i * 2, 2);
+            commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, profiler.uploadQueryPool, i * 2);
+            return static_cast<int>(i);
+        }
+    }
+
+    // Too many uploads in flight; this one goes untimed
+    return -1;
+}
+
+void endVulkanGPUUploadTimer(VulkanGPUProfiler &profiler, vk::CommandBuffer &commandBuffer, int slot) {
+    if(slot >= 0) {
+        commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, profiler.uploadQueryPool, slot * 2 + 1);
+    }
+}
+
+void collectVulkanGPUUploadTimer(vk::Device &device, VulkanGPUProfiler &profiler, int slot) {
+    if(slot < 0) {
+        return;
+    }
+
+    auto results = device.getQueryPoolResults<uint64_t>(profiler.uploadQueryPool, slot * 2, 2,
+                                                        2 * sizeof(uint64_t), sizeof(uint64_t),
+                                                        vk::QueryResultFlagBits::e64);
+    if(results.result == vk::Result::eSuccess) {
+        double ms = getElapsedMS(profiler, results.value[0], results.value[1]);
+
+        // Not part of any one frame, so only the running stats get it
+        addVulkanGPUSample(profiler, "upload", ms);
+    }
+
+    profiler.uploadTimerBusy[slot] = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// REPORTING
+///////////////////////////////////////////////////////////////////////////////
+
+vector<VulkanGPUScopeResult>& getVulkanGPUFrameResults(VulkanGPUProfiler &profiler) {
+    return profiler.lastFrameResults;
+}
+
+vector<VulkanGPUScopeStats>& getVulkanGPUScopeStats(VulkanGPUProfiler &profiler) {
+    return profiler.stats;
+}
+
+void resetVulkanGPUScopeStats(VulkanGPUProfiler &profiler) {
+    profiler.stats.clear();
+}
+
+void printVulkanGPUProfileReport(VulkanGPUProfiler &profiler) {
+    if(!profiler.enabled) {
+        cout << "GPU profile: (timestamps not supported)" << endl;
+        return;
+    }
+
+    cout << "GPU profile (ms):" << endl;
+    cout << fixed << setprecision(3);
+
+    cout << "  Last frame:" << endl;
+    for(auto &r : profiler.lastFrameResults) {
+        cout << "    " << string(r.depth * 2, ' ') << r.name << ": " << r.ms << endl;
+    }
+
+    cout << "  All frames (avg / min / max over samples):" << endl;
+    for(auto &s : profiler.stats) {
+        double avg = (s.sampleCnt > 0) ? s.totalMS / s.sampleCnt : 0.0;
+        cout << "    " << s.name << ": " << avg << " / " << s.minMS << " / " << s.maxMS
+            << " (" << s.sampleCnt << ")" << endl;
+    }
+
+    cout << defaultfloat;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CLEANUP
+///////////////////////////////////////////////////////////////////////////////
+
+void cleanupVulkanGPUProfiler(vk::Device &device, VulkanGPUProfiler &profiler) {
+    for(auto &frame : profiler.frames) {
+        device.destroyQueryPool(frame.queryPool);
+    }
+    profiler.frames.clear();
+
+    if(profiler.uploadQueryPool) {
+        device.destroyQueryPool(profiler.uploadQueryPool);
+        profiler.uploadQueryPool = nullptr;
+    }
+    profiler.uploadTimerBusy.clear();
+    profiler.enabled = false;
+    profiler.uploadsEnabled = false;
+}
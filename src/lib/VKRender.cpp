@@ -4,7 +4,9 @@
 // Constructors and Destructor
 ///////////////////////////////////////////////////////////////////////////////
 
-VulkanRenderEngine::VulkanRenderEngine(VulkanInitData &vkInitData) : vkInitData(vkInitData) {}
+VulkanRenderEngine::VulkanRenderEngine(VulkanInitData &vkInitData) : vkInitData(vkInitData) {
+    createFrameStats(this->frameStats);
+}
 
 bool VulkanRenderEngine::initialize(VulkanInitRenderParams *params) {
 
@@ -23,6 +25,11 @@ bool VulkanRenderEngine::initialize(VulkanInitRenderParams *params) {
                                                         params->vertSPVFilename, 
                                                         params->fragSPVFilename);
 
+        // Other pipelines share the layout and cache, and fall back to this one
+        createVulkanPipelineRegistry(   vkInitData, this->pipelineRegistry, this->renderPass,
+                                        this->pipelineData.pipelineLayout, this->pipelineData.cache,
+                                        this->pipelineData.graphicsPipeline);
+
         // Create frame buffers
         this->framebuffers = createVulkanFramebuffers(this->renderPass, this->depthImage);
 
@@ -33,6 +40,33 @@ bool VulkanRenderEngine::initialize(VulkanInitRenderParams *params) {
         // Create command pool
         this->commandPool = createVulkanCommandPool(device, graphicsQueueIndex);     
 
+        // Create GPU profiler (one query pool per frame in flight)
+        this->gpuProfiler = createVulkanGPUProfiler(vkInitData, MAX_FRAMES_IN_FLIGHT);
+
+        // Create staging ring for uploads
+        if(vkInitData.transferQueue.index != graphicsQueueIndex) {
+            // Copy on the transfer queue, hand ownership to the graphics queue
+            this->transferCommandPool = createVulkanCommandPool(device, vkInitData.transferQueue.index);
+            this->stagingRing = createVulkanStagingRing(vkInitData.physicalDevice, device,
+                                                        this->transferCommandPool, vkInitData.transferQueue,
+                                                        this->commandPool, vkInitData.graphicsQueue,
+                                                        STAGING_RING_SIZE);
+        }
+        else {
+            this->stagingRing = createVulkanStagingRing(vkInitData.physicalDevice, device,
+                                                        this->commandPool, vkInitData.graphicsQueue,
+                                                        STAGING_RING_SIZE);
+        }
+
+        // Time every batch of uploads
+        this->stagingRing.profiler = &this->gpuProfiler;
+
+        // Readback buffers for frame capture
+        createVulkanCaptureRing(vkInitData, this->captureRing, this->commandPool, MAX_FRAMES_IN_FLIGHT + 2);
+
+        // Deferred deletions wait until every frame in flight is done
+        this->deletionQueue.framesToWait = MAX_FRAMES_IN_FLIGHT;
+
         // For each possible frame in flight
         for(unsigned int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {   
             // Start with struct
@@ -40,6 +74,8 @@ bool VulkanRenderEngine::initialize(VulkanInitRenderParams *params) {
 
             // Create command buffers            
             frameData.commandBuffer = createVulkanCommandBuffer(device, this->commandPool);
+            frameData.profilerCommandBuffer = createVulkanCommandBuffer(device, this->commandPool);
+            frameData.computeCommandBuffer = createVulkanCommandBuffer(device, this->commandPool);
 
             // Create sync objects
             frameData.imageAvailableSemaphore = createVulkanSemaphore(device);
@@ -68,9 +104,24 @@ VulkanRenderEngine::~VulkanRenderEngine() {
             cleanupVulkanSemaphore(vkInitData.device, this->allFrameData.at(i).imageAvailableSemaphore);
         }
         
+        // Assumes the device is idle
+        flushVulkanDeletionQueue(this->deletionQueue);
+
+        // Finishes writing any captured frames
+        cleanupVulkanCaptureRing(vkInitData, this->captureRing);
+
+        cleanupVulkanStagingRing(vkInitData.device, this->stagingRing);
+        cleanupVulkanGPUProfiler(vkInitData.device, this->gpuProfiler);
+        if(this->transferCommandPool) {
+            cleanupVulkanCommandPool(vkInitData.device, this->transferCommandPool);
+        }
         cleanupVulkanCommandPool(vkInitData.device, this->commandPool);
 
         cleanupVulkanFramebuffers(this->framebuffers);
+        for(auto &computePipeline : this->computePipelines) {
+            cleanupVulkanComputePipelineData(vkInitData.device, computePipeline);
+        }
+        cleanupVulkanPipelineRegistry(this->pipelineRegistry);
         cleanupVulkanPipelineData(this->pipelineData);    
         cleanupVulkanRenderPass(this->renderPass);
         cleanupVulkanImage(vkInitData, this->depthImage);
@@ -88,11 +139,62 @@ vk::CommandPool& VulkanRenderEngine::getCommandPool() {
     return this->commandPool;
 }
 
+VulkanStagingRing& VulkanRenderEngine::getStagingRing() {
+    return this->stagingRing;
+}
+
+VulkanDeletionQueue& VulkanRenderEngine::getDeletionQueue() {
+    return this->deletionQueue;
+}
+
+VulkanGPUProfiler& VulkanRenderEngine::getGPUProfiler() {
+    return this->gpuProfiler;
+}
+
+FrameStats& VulkanRenderEngine::getFrameStats() {
+    return this->frameStats;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Pipeline variants
+///////////////////////////////////////////////////////////////////////////////
+
+VulkanPipelineDesc VulkanRenderEngine::getBasePipelineDesc() {
+    return this->basePipelineDesc;
+}
+
+uint64_t VulkanRenderEngine::requestPipeline(VulkanPipelineDesc &desc) {
+    return requestVulkanPipeline(this->pipelineRegistry, desc);
+}
+
+bool VulkanRenderEngine::isPipelineReady(uint64_t key) {
+    return isVulkanPipelineReady(this->pipelineRegistry, key);
+}
+
+vk::Pipeline VulkanRenderEngine::getPipeline(uint64_t key) {
+    return getVulkanPipeline(this->pipelineRegistry, key);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Frame capture
+///////////////////////////////////////////////////////////////////////////////
+
+void VulkanRenderEngine::requestCapture(string filename) {
+    requestVulkanCapture(this->captureRing, filename);
+}
+
+void VulkanRenderEngine::requestCaptureSequence(string filenamePrefix, unsigned int frameCnt) {
+    requestVulkanCaptureSequence(this->captureRing, filenamePrefix, frameCnt);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Swap chain recreation
 ///////////////////////////////////////////////////////////////////////////////
 
 void VulkanRenderEngine::recreateSwapChain() {    
+    // This frame will be a hitch
+    flagFrameStatsFrame(this->frameStats, FRAME_FLAG_SWAPCHAIN_RECREATED);
+
     // Wait until device is idle
     vkInitData.device.waitIdle();
 
@@ -136,7 +238,9 @@ vk::RenderPass VulkanRenderEngine::createVulkanRenderPass(VulkanImage &depthImag
         vk::AttachmentLoadOp::eDontCare,    // Don't care about stencil buffer
         vk::AttachmentStoreOp::eDontCare,
         vk::ImageLayout::eUndefined,        // Initially undefined before presentation
-        vk::ImageLayout::ePresentSrcKHR     // Present appropriate to surface
+        vkInitData.headless                 // Present appropriate to surface
+            ? vk::ImageLayout::eTransferSrcOptimal  // (or ready to copy out if headless)
+            : vk::ImageLayout::ePresentSrcKHR
     ));
     
     // Depth attachment
@@ -237,82 +341,11 @@ VulkanPipelineData VulkanRenderEngine::createVulkanPipelineData(
     auto vertShaderCode = readBinaryFile(vertSPVFilename);
     auto fragShaderCode = readBinaryFile(fragSPVFilename);
 
-    // Compiling/linking to GPU machine code doesn't happen until graphics pipeline created.
-    // Once the pipeline is created, we will be able to destroy these modules safely.
-    vk::ShaderModule vertShaderModule = createVulkanShaderModule(vkInitData.device, vertShaderCode);
-    vk::ShaderModule fragShaderModule = createVulkanShaderModule(vkInitData.device, fragShaderCode);
-
-    // Assign VERTEX SHADER to appropriate stage
-    vk::PipelineShaderStageCreateInfo vertShaderStageInfo(
-        {}, vk::ShaderStageFlagBits::eVertex, vertShaderModule, "main");  
-   
-    // Assign FRAGMENT SHADER to appropriate stage
-    vk::PipelineShaderStageCreateInfo fragShaderStageInfo(
-        {}, vk::ShaderStageFlagBits::eFragment, fragShaderModule, "main");  
-
-    // Combine them
-    vk::PipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
-
-    // Get the attribute description data
-    AttributeDescData attribDescData = getAttributeDescData(); 
-    
-    // Set up how attributes are arranged
-    vk::PipelineVertexInputStateCreateInfo vertexInputInfo(
-        {}, attribDescData.bindDesc, attribDescData.attribDesc);
-        
-    // Render a regular triangle list
-    vk::PipelineInputAssemblyStateCreateInfo inputAssembly({}, vk::PrimitiveTopology::eTriangleList, false);
-    
-    // Set viewport (startx, starty, width, height, mindepth, maxdepth)
-    vk::Viewport viewport(0, 0, 
-                            (float)vkInitData.swapchain.extent.width, 
-                            (float)vkInitData.swapchain.extent.height, 
-                            0.0f, 1.0f);
-
-    // Set scissors (if we wanted to only draw part of the screen)
-    // Using full screen here
-    vk::Rect2D scissor({0,0}, vkInitData.swapchain.extent);
-          
-    // Identify properties that you want to be able to change dynamically
-    // WITHOUT recreating the whole pipeline
-    vector<vk::DynamicState> dynamicStates = {
-        vk::DynamicState::eViewport,
-        vk::DynamicState::eScissor        
-    };
-
-    vk::PipelineDynamicStateCreateInfo dynamicState({}, dynamicStates);  
-
-    vk::PipelineViewportStateCreateInfo viewportState({}, viewport, scissor);
-    
-    // Set RASTERIZER stage values
-    // Defaults to:
-    // - discard fragments outside near/far planes
-    // - polygon fill mode    
-
-    vk::PipelineRasterizationStateCreateInfo rasterizer {};
-    // Change the following:
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = vk::CullModeFlagBits::eNone; // eBack;
-    rasterizer.frontFace = vk::FrontFace::eCounterClockwise; 
-                
-    // Set up BLENDING
-    // Basically no blending here
-    // Per frame buffer...
-    vk::PipelineColorBlendAttachmentState colorBlendAttachment {};
-    colorBlendAttachment.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
-    
-    // Set up depth testing
-    vk::PipelineDepthStencilStateCreateInfo depthStencil(
-        {},
-        true,                   // Enable depth testing
-        true,                   // Enable depth writing
-        vk::CompareOp::eLess,   // Lower depth = closer = keep
-        false,                  // Not putting bounds on depth test
-        false, {}, {}          // Not using stencil test
-    );
-
-    // Global blend settings
-    vk::PipelineColorBlendStateCreateInfo colorBlending({}, false, vk::LogicOp::eCopy, colorBlendAttachment);
+    // Describe the pipeline (default state; variants can start from this)
+    VulkanPipelineDesc &desc = this->basePipelineDesc;
+    desc.vertSPVFilename = vertSPVFilename;
+    desc.fragSPVFilename = fragSPVFilename;
+    desc.attribDescData = getAttributeDescData(); 
         
     // Get the pipeline creation info
     data.descriptorSetLayouts = getDescriptorSetLayouts();
@@ -327,39 +360,20 @@ VulkanPipelineData VulkanRenderEngine::createVulkanPipelineData(
     // Create the pipeline layout
     data.pipelineLayout = vkInitData.device.createPipelineLayout(pipelineLayoutInfo);
 
-    // Not doing multisample AA
-    vk::PipelineMultisampleStateCreateInfo multisample({}, vk::SampleCountFlagBits::e1);
-
-    // Create pipeline cache
-    data.cache = vkInitData.device.createPipelineCache( vk::PipelineCacheCreateInfo());
+    // Load pipeline cache from the last run (keyed by device, driver, and shaders)
+    uint64_t shaderHash = hashVulkanShaderCode(fragShaderCode, hashVulkanShaderCode(vertShaderCode));
+    data.cacheFilename = getVulkanPipelineCacheFilename(vkInitData, shaderHash);
+    data.cache = loadVulkanPipelineCache(vkInitData, data.cacheFilename);
+    auto pipelineStartTime = getTime();
 
     // CREATE ACTUAL PIPELINE
-    vk::GraphicsPipelineCreateInfo pipelineInfo(vk::PipelineCreateFlags(),
-                                                shaderStages,
-                                                &vertexInputInfo,
-                                                &inputAssembly,
-                                                0,
-                                                &viewportState,
-                                                &rasterizer,
-                                                &multisample,
-                                                &depthStencil,
-                                                &colorBlending,
-                                                &dynamicState,
-                                                data.pipelineLayout,
-                                                renderPass);    
-    
-    auto ret = vkInitData.device.createGraphicsPipeline(data.cache, pipelineInfo);
-
-    if (ret.result != vk::Result::eSuccess) {
-        throw runtime_error("Failed to create graphics pipeline!");
-    }
-
-    // Set pipeline
-    data.graphicsPipeline = ret.value;
-
-    // Cleanup modules
-    vkInitData.device.destroyShaderModule(fragShaderModule);
-    vkInitData.device.destroyShaderModule(vertShaderModule);
+    // (compiling/linking to GPU machine code happens here)
+    data.graphicsPipeline = createVulkanGraphicsPipeline(   vkInitData.device, desc,
+                                                            vertShaderCode, fragShaderCode,
+                                                            renderPass, data.pipelineLayout,
+                                                            data.cache);
+    cout << "Graphics pipeline created in " 
+        << getElapsedSeconds(pipelineStartTime, getTime()) * 1000.0f << " ms" << endl;
     
     // Return data
     return data;
@@ -370,11 +384,29 @@ void VulkanRenderEngine::cleanupVulkanPipelineData(VulkanPipelineData &pipelineD
         vkInitData.device.destroyDescriptorSetLayout(pipelineData.descriptorSetLayouts.at(i));
     }
 
+    // Keep compiled pipelines for next time
+    saveVulkanPipelineCache(vkInitData, pipelineData.cache, pipelineData.cacheFilename);
     vkInitData.device.destroyPipelineCache(pipelineData.cache);
     vkInitData.device.destroyPipelineLayout(pipelineData.pipelineLayout);
     vkInitData.device.destroyPipeline(pipelineData.graphicsPipeline);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Compute pipelines
+///////////////////////////////////////////////////////////////////////////////
+
+VulkanComputePipelineData VulkanRenderEngine::createComputePipeline(
+    string compSPVFilename,
+    const vector<vk::DescriptorSetLayout> &descriptorSetLayouts,
+    const vector<vk::PushConstantRange> &pushConstantRanges) {
+
+    VulkanComputePipelineData data = createVulkanComputePipelineData(   vkInitData.device, compSPVFilename,
+                                                                        descriptorSetLayouts, pushConstantRanges,
+                                                                        this->pipelineData.cache);
+    this->computePipelines.push_back(data);
+    return data;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Vulkan framebuffers
 ///////////////////////////////////////////////////////////////////////////////
@@ -432,6 +464,7 @@ void VulkanRenderEngine::recordCommandBuffer(   void *userData,
     clearValues[0].color = vk::ClearColorValue(0.6f, 0.1f, 0.7f, 1.0f);
     clearValues[1].depthStencil = vk::ClearDepthStencilValue(1.0f, 0.0f);
     
+    beginGPUScope(commandBuffer, "renderPass");
     commandBuffer.beginRenderPass(vk::RenderPassBeginInfo(
         this->renderPass, 
         this->framebuffers[frameIndex], 
@@ -456,11 +489,25 @@ void VulkanRenderEngine::recordCommandBuffer(   void *userData,
     
     // Stop render pass
     commandBuffer.endRenderPass();
+    endGPUScope(commandBuffer);
     
     // End command buffer
     commandBuffer.end();
 }
 
+bool VulkanRenderEngine::recordComputeCommands(void *userData, vk::CommandBuffer &commandBuffer) {
+    // Nothing by default
+    return false;
+}
+
+void VulkanRenderEngine::beginGPUScope(vk::CommandBuffer &commandBuffer, string name) {
+    beginVulkanGPUScope(this->gpuProfiler, commandBuffer, name);
+}
+
+void VulkanRenderEngine::endGPUScope(vk::CommandBuffer &commandBuffer) {
+    endVulkanGPUScope(this->gpuProfiler, commandBuffer);
+}
+
 void VulkanRenderEngine::notifyFrameResize() {
     frameBufferResized.store(true);
 }
@@ -468,10 +515,12 @@ void VulkanRenderEngine::notifyFrameResize() {
 void VulkanRenderEngine::drawFrame(void *userData) {
 
     // Is the current size 0 x 0 (minimized?)
-    int windowWidth = 0, windowHeight = 0;
-    glfwGetFramebufferSize(vkInitData.window, &windowWidth, &windowHeight);
-    if(windowWidth == 0 || windowHeight == 0) {
-        return;
+    if(!vkInitData.headless) {
+        int windowWidth = 0, windowHeight = 0;
+        glfwGetFramebufferSize(vkInitData.window, &windowWidth, &windowHeight);
+        if(windowWidth == 0 || windowHeight == 0) {
+            return;
+        }
     }
 
     // Have we resized recently?
@@ -481,17 +530,35 @@ void VulkanRenderEngine::drawFrame(void *userData) {
         return;
     }
 
+    // Hand finished background uploads over to the graphics queue
+    updateVulkanStagingRing(vkInitData.device, this->stagingRing);
+
     // Wait for this image to finish
+    beginFrameStage(this->frameStats);
     auto waitRes = vkInitData.device.waitForFences(1, &this->allFrameData[currentImage].inFlightFence, true, UINT64_MAX);
     if(waitRes != vk::Result::eSuccess) {
         throw runtime_error("drawFrame: Timeout while waiting for image fence!");
     }
+    endFrameStage(this->frameStats, FrameStage::Wait);
 
-    // Acquire a frame index from the swap chain
-    auto result = vkInitData.device.acquireNextImageKHR(vkInitData.swapchain.chain, 
-                                                        UINT64_MAX, 
-                                                        this->allFrameData[currentImage].imageAvailableSemaphore, 
-                                                        nullptr);   
+    // Destroy anything no frame in flight can still be using
+    updateVulkanDeletionQueue(this->deletionQueue);
+
+    // Copies from this frame's last use are done; write them out in the background
+    completeVulkanCaptures(this->captureRing, currentImage);
+
+    // Acquire a frame index from the swap chain (or the offscreen images)
+    unsigned int frameIndex = 0;
+    if(vkInitData.headless) {
+        frameIndex = acquireVulkanOffscreenImage(vkInitData);
+    }
+    else {
+        auto result = vkInitData.device.acquireNextImageKHR(vkInitData.swapchain.chain, 
+                                                            UINT64_MAX, 
+                                                            this->allFrameData[currentImage].imageAvailableSemaphore, 
+                                                            nullptr);   
+        frameIndex = result.value;
+    }
 
     // Reset the fence since we're about to submit work
     auto resetRes = vkInitData.device.resetFences(1, &this->allFrameData[currentImage].inFlightFence);
@@ -499,14 +566,40 @@ void VulkanRenderEngine::drawFrame(void *userData) {
         throw runtime_error("drawFrame: Failed to reset image fence!");
     }
     
-    // Get actual image index for framebuffer purposes
-    unsigned int frameIndex = result.value;
-    
+    // Read back this slot's GPU timings from last time and reset its queries
+    beginFrameStage(this->frameStats);
+    this->allFrameData[currentImage].profilerCommandBuffer.reset();
+    beginVulkanGPUProfilerFrame(vkInitData.device, this->gpuProfiler, currentImage, 
+                                this->allFrameData[currentImage].profilerCommandBuffer);
+
+    // Record any compute work the drawing needs (submitted ahead of it)
+    vk::CommandBuffer &computeBuffer = this->allFrameData[currentImage].computeCommandBuffer;
+    computeBuffer.reset();
+    computeBuffer.begin(vk::CommandBufferBeginInfo());
+    bool hasCompute = recordComputeCommands(userData, computeBuffer);
+    if(hasCompute) {
+        recordVulkanComputeToGraphicsBarrier(computeBuffer);
+    }
+    computeBuffer.end();
+
     // Record a command buffer which draws the scene onto that image
     this->allFrameData[currentImage].commandBuffer.reset();        
     recordCommandBuffer(userData, this->allFrameData[currentImage].commandBuffer, frameIndex);
 
-    // Submit the recorded command buffer
+    // Copy the finished image out if a capture was requested
+    vector<vk::CommandBuffer> commandBuffers = {    this->allFrameData[currentImage].profilerCommandBuffer };
+    if(hasCompute) {
+        commandBuffers.push_back(computeBuffer);
+    }
+    commandBuffers.push_back(this->allFrameData[currentImage].commandBuffer);
+    vk::CommandBuffer captureBuffer = recordVulkanCapture(vkInitData, this->captureRing, currentImage, frameIndex);
+    if(captureBuffer) {
+        commandBuffers.push_back(captureBuffer);
+    }
+
+    endFrameStage(this->frameStats, FrameStage::Record);
+
+    // Submit the recorded command buffer(s)
     vk::Semaphore waitSemaphores[] = {this->allFrameData[currentImage].imageAvailableSemaphore};
     vk::Semaphore signalSemaphores[] = {this->allFrameData[currentImage].renderFinishedSemaphore};
     vk::PipelineStageFlags waitStages[] = {vk::PipelineStageFlagBits::eColorAttachmentOutput};
@@ -514,22 +607,33 @@ void VulkanRenderEngine::drawFrame(void *userData) {
     vk::SubmitInfo submitInfo(
         waitSemaphores,
         waitStages,
-        this->allFrameData[currentImage].commandBuffer,
+        commandBuffers,
         signalSemaphores);
+
+    // Nothing to wait on or present when headless
+    if(vkInitData.headless) {
+        submitInfo = vk::SubmitInfo().setCommandBuffers(commandBuffers);
+    }
                 
+    beginFrameStage(this->frameStats);
     vkInitData.graphicsQueue.queue.submit(submitInfo, this->allFrameData[currentImage].inFlightFence);
+    endFrameStage(this->frameStats, FrameStage::Submit);
         
     // Present the swap chain image
-    vk::SwapchainKHR swapChains[] = {vkInitData.swapchain.chain};
-    uint32_t imageIndices[] = {frameIndex};
-    vk::PresentInfoKHR presentInfo(signalSemaphores, swapChains, imageIndices);
-    
-    try {
-        auto presentRes = vkInitData.presentQueue.queue.presentKHR(presentInfo);
-    }
-    catch(const vk::OutOfDateKHRError& e) {
-        // Recreate swap chain
-        recreateSwapChain();
+    if(!vkInitData.headless) {
+        vk::SwapchainKHR swapChains[] = {vkInitData.swapchain.chain};
+        uint32_t imageIndices[] = {frameIndex};
+        vk::PresentInfoKHR presentInfo(signalSemaphores, swapChains, imageIndices);
+        
+        beginFrameStage(this->frameStats);
+        try {
+            auto presentRes = vkInitData.presentQueue.queue.presentKHR(presentInfo);
+        }
+        catch(const vk::OutOfDateKHRError& e) {
+            // Recreate swap chain
+            recreateSwapChain();
+        }
+        endFrameStage(this->frameStats, FrameStage::Present);
     }
     
     // Increment current frame for in-flight work
@@ -32,10 +32,19 @@ void cleanupGLFWWindow(GLFWwindow *window) {
 // Vulkan Boiletplate Setup (using vk-bootstrap and VulkanHPP)
 ///////////////////////////////////////////////////////////////////////////////
 
-bool initVulkanBootstrap(string appName, GLFWwindow *window, VulkanInitData &vkInitData) {
+bool initVulkanHeadless(string appName, int width, int height, VulkanInitData &vkInitData,
+                        bool useTransferQueue) {
+    // Offscreen images use this size
+    vkInitData.swapchain.extent = vk::Extent2D(width, height);
+    return initVulkanBootstrap(appName, nullptr, vkInitData, useTransferQueue);
+}
+
+bool initVulkanBootstrap(string appName, GLFWwindow *window, VulkanInitData &vkInitData,
+                        bool useTransferQueue) {
 
-    // Store window for reference
+    // Store window for reference (no window = headless)
     vkInitData.window = window;
+    vkInitData.headless = (window == nullptr);
 
     ///////////////////////////////////////////////////////////////////////////
     // INSTANCE
@@ -48,6 +57,7 @@ bool initVulkanBootstrap(string appName, GLFWwindow *window, VulkanInitData &vkI
                         .set_engine_name("Forge Engine")
                         .request_validation_layers()
                         .use_default_debug_messenger()
+                        .set_headless(vkInitData.headless)
                         .build();
 
     // Did we succeed?
@@ -68,13 +78,15 @@ bool initVulkanBootstrap(string appName, GLFWwindow *window, VulkanInitData &vkI
     // SURFACE
     ///////////////////////////////////////////////////////////////////////////
 
-    // Create a window surface
+    // Create a window surface (if we have a window)
     VkSurfaceKHR surface = nullptr;
-    VkResult surfErr = glfwCreateWindowSurface(vkbInstance.instance, window, NULL, &surface);
-    if(surfErr != VK_SUCCESS) {
-        cerr << "initVulkanBootstrap: Failed to create window surface." << endl;
-        cerr << "Error: " << surfErr << endl;
-        return false;
+    if(!vkInitData.headless) {
+        VkResult surfErr = glfwCreateWindowSurface(vkbInstance.instance, window, NULL, &surface);
+        if(surfErr != VK_SUCCESS) {
+            cerr << "initVulkanBootstrap: Failed to create window surface." << endl;
+            cerr << "Error: " << surfErr << endl;
+            return false;
+        }
     }
 
     // Convert to vk::SurfaceKHR
@@ -90,8 +102,10 @@ bool initVulkanBootstrap(string appName, GLFWwindow *window, VulkanInitData &vkI
 
     // Select physical device
     vkb::PhysicalDeviceSelector selector { vkbInstance };
-    auto physRet = selector.set_surface(surface)
-                        .set_minimum_version(1,1) // require at least a Vulkan 1.1 device
+    if(!vkInitData.headless) {
+        selector.set_surface(surface);
+    }
+    auto physRet = selector.set_minimum_version(1,1) // require at least a Vulkan 1.1 device
                         //.require_dedicated_transfer_queue()
                         .set_required_features(requiredDeviceFeatures)
                         .select();
@@ -104,10 +118,21 @@ bool initVulkanBootstrap(string appName, GLFWwindow *window, VulkanInitData &vkI
     }
 
     // Get physical device
-    vkInitData.physicalDevice = vk::PhysicalDevice { physRet.value().physical_device };
+    vkb::PhysicalDevice vkbPhysicalDevice = physRet.value();
+    vkInitData.physicalDevice = vk::PhysicalDevice { vkbPhysicalDevice.physical_device };
+
+    // Memory budget queries are optional (telemetry only)
+    bool hasMemoryBudget = vkbPhysicalDevice.enable_extension_if_present(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    // GPU-driven drawing works without these, but needs more draws
+    vk::PhysicalDeviceFeatures indirectFeatures {};
+    indirectFeatures.multiDrawIndirect = true;
+    indirectFeatures.drawIndirectFirstInstance = true;
+    vkInitData.hasMultiDrawIndirect = vkbPhysicalDevice.enable_features_if_present(indirectFeatures);
+    vkInitData.hasDrawIndirectCount = vkbPhysicalDevice.enable_extension_if_present(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
 
     // Create a vkb::Device (which has a VkDevice inside it)
-    vkb::DeviceBuilder deviceBuilder { physRet.value() };
+    vkb::DeviceBuilder deviceBuilder { vkbPhysicalDevice };
     auto devRet = deviceBuilder.build();
 
     if(!devRet) {
@@ -123,6 +148,9 @@ bool initVulkanBootstrap(string appName, GLFWwindow *window, VulkanInitData &vkI
 
     // Store reference to bootstrap device for later
     vkInitData.bootDevice = vkbDevice;
+
+    // Create the device's memory allocator up front
+    getVulkanMemoryAllocator(vkInitData.physicalDevice, vkInitData.device).hasMemoryBudget = hasMemoryBudget;
     
     ///////////////////////////////////////////////////////////////////////////
     // QUEUES
@@ -139,16 +167,34 @@ bool initVulkanBootstrap(string appName, GLFWwindow *window, VulkanInitData &vkI
     vkInitData.graphicsQueue.queue = vk::Queue { graphicsQueueRet.value() };
     vkInitData.graphicsQueue.index = vkbDevice.get_queue_index(vkb::QueueType::graphics).value();
     
-    // Get present queue
-    auto presentQueueRet = vkbDevice.get_queue(vkb::QueueType::present);
-    if(!presentQueueRet) {
-        cerr << "initVulkanBootstrap: Failed to get present queue." << endl;
-        cerr << "Error: " << presentQueueRet.error().message() << endl;
-        return false;
+    // Get present queue (nothing is presented when headless)
+    if(vkInitData.headless) {
+        vkInitData.presentQueue = vkInitData.graphicsQueue;
+    }
+    else {
+        auto presentQueueRet = vkbDevice.get_queue(vkb::QueueType::present);
+        if(!presentQueueRet) {
+            cerr << "initVulkanBootstrap: Failed to get present queue." << endl;
+            cerr << "Error: " << presentQueueRet.error().message() << endl;
+            return false;
+        }
+
+        vkInitData.presentQueue.queue = vk::Queue { presentQueueRet.value() };
+        vkInitData.presentQueue.index = vkbDevice.get_queue_index(vkb::QueueType::present).value();
     }
 
-    vkInitData.presentQueue.queue = vk::Queue { presentQueueRet.value() };
-    vkInitData.presentQueue.index = vkbDevice.get_queue_index(vkb::QueueType::present).value();
+    // Get transfer queue (if requested and the device has a separate family for it)
+    vkInitData.transferQueue = vkInitData.graphicsQueue;
+    if(useTransferQueue) {
+        auto transferQueueRet = vkbDevice.get_queue(vkb::QueueType::transfer);
+        if(transferQueueRet) {
+            vkInitData.transferQueue.queue = vk::Queue { transferQueueRet.value() };
+            vkInitData.transferQueue.index = vkbDevice.get_queue_index(vkb::QueueType::transfer).value();
+        }
+        else {
+            cout << "initVulkanBootstrap: No separate transfer queue; using graphics queue." << endl;
+        }
+    }
     
     ///////////////////////////////////////////////////////////////////////////
     // SWAPCHAIN
@@ -162,7 +208,60 @@ bool initVulkanBootstrap(string appName, GLFWwindow *window, VulkanInitData &vkI
     return true;
 }
 
+// Offscreen color images instead of a swapchain
+static bool createVulkanOffscreenTargets(VulkanInitData &vkInitData) {
+    if(vkInitData.swapchain.extent.width == 0 || vkInitData.swapchain.extent.height == 0) {
+        vkInitData.swapchain.extent = vk::Extent2D(800, 600);
+    }
+    vkInitData.swapchain.format = vk::Format::eB8G8R8A8Unorm;
+    vkInitData.swapchain.nextOffscreenImage = 0;
+
+    for(unsigned int i = 0; i < HEADLESS_IMAGE_COUNT; i++) {
+        // Can be rendered to AND copied out (e.g., for saving frames)
+        vk::ImageCreateInfo imageInfo(
+            {},
+            vk::ImageType::e2D,
+            vkInitData.swapchain.format,
+            vk::Extent3D(vkInitData.swapchain.extent, 1),
+            1, 1, vk::SampleCountFlagBits::e1,
+            vk::ImageTiling::eOptimal,
+            vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+            vk::SharingMode::eExclusive
+        );
+        vk::Image image = vkInitData.device.createImage(imageInfo);
+
+        vk::MemoryRequirements memRequirements = vkInitData.device.getImageMemoryRequirements(image);
+        VulkanAllocation allocation = allocateVulkanMemory( vkInitData.physicalDevice, vkInitData.device, 
+                                                            memRequirements,
+                                                            vk::MemoryPropertyFlagBits::eDeviceLocal,
+                                                            true, VulkanMemoryTag::Texture);
+        vkInitData.device.bindImageMemory(image, allocation.memory, allocation.offset);
+
+        vk::ImageView view = vkInitData.device.createImageView(vk::ImageViewCreateInfo(
+            {}, image, vk::ImageViewType::e2D, vkInitData.swapchain.format,
+            {}, { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 }));
+
+        vkInitData.swapchain.offscreenImages.push_back(image);
+        vkInitData.swapchain.images.push_back(image);
+        vkInitData.swapchain.offscreenMemory.push_back(allocation);
+        vkInitData.swapchain.views.push_back(view);
+    }
+
+    return true;
+}
+
+unsigned int acquireVulkanOffscreenImage(VulkanInitData &vkInitData) {
+    // Simple round robin (frames finish in order on one queue)
+    unsigned int index = vkInitData.swapchain.nextOffscreenImage;
+    vkInitData.swapchain.nextOffscreenImage = (index + 1) % vkInitData.swapchain.views.size();
+    return index;
+}
+
 bool createVulkanSwapchain(VulkanInitData &vkInitData) {
+    if(vkInitData.headless) {
+        return createVulkanOffscreenTargets(vkInitData);
+    }
+
     // Create swapchain
     vkb::SwapchainBuilder swapchainBuilder { vkInitData.bootDevice };
 
@@ -172,7 +271,10 @@ bool createVulkanSwapchain(VulkanInitData &vkInitData) {
     desiredFormat.format = VK_FORMAT_B8G8R8A8_UNORM;
     desiredFormat.colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
 
-    auto swapRet = swapchainBuilder.set_desired_format(desiredFormat).build();
+    // Images can also be copied out (e.g., for frame capture)
+    auto swapRet = swapchainBuilder.set_desired_format(desiredFormat)
+                                    .add_image_usage_flags(VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+                                    .build();
 
     if(!swapRet) {
         cerr << "initVulkanBootstrap: Failed to create swapchain." << endl;
@@ -192,6 +294,11 @@ bool createVulkanSwapchain(VulkanInitData &vkInitData) {
         vkInitData.swapchain.views.push_back(vk::ImageView { vkViews.at(i) });
     }
 
+    vector<VkImage> vkImages = vkSwapchain.get_images().value();
+    for(unsigned int i = 0; i < vkImages.size(); i++) {
+        vkInitData.swapchain.images.push_back(vk::Image { vkImages.at(i) });
+    }
+
     return true;
 }
 
@@ -200,17 +307,25 @@ void cleanupVulkanSwapchain(VulkanInitData &vkInitData) {
         vkInitData.device.destroyImageView(vkInitData.swapchain.views.at(i));
     }
     vkInitData.swapchain.views.clear();    
+    vkInitData.swapchain.images.clear();
+
+    // Headless images
+    for(unsigned int i = 0; i < vkInitData.swapchain.offscreenImages.size(); i++) {
+        vkInitData.device.destroyImage(vkInitData.swapchain.offscreenImages.at(i));
+        freeVulkanMemory(vkInitData.device, vkInitData.swapchain.offscreenMemory.at(i));
+    }
+    vkInitData.swapchain.offscreenImages.clear();
+    vkInitData.swapchain.offscreenMemory.clear();
+
     vkInitData.device.destroySwapchainKHR(vkInitData.swapchain.chain);
+    vkInitData.swapchain.chain = nullptr;
 }
 
 void cleanupVulkanBootstrap(VulkanInitData &vkInitData) {
     
-    for(unsigned int i = 0; i < vkInitData.swapchain.views.size(); i++) {
-        vkInitData.device.destroyImageView(vkInitData.swapchain.views.at(i));
-    }
-    vkInitData.swapchain.views.clear();    
-    vkInitData.device.destroySwapchainKHR(vkInitData.swapchain.chain);
+    cleanupVulkanSwapchain(vkInitData);
 
+    cleanupVulkanMemoryAllocator(vkInitData.device);
     vkInitData.device.destroy();
     vkInitData.instance.destroySurfaceKHR(vkInitData.surface);    
     
@@ -0,0 +1,567 @@
+#include "VKStaging.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// RING CREATION
+///////////////////////////////////////////////////////////////////////////////
+
+VulkanStagingRing createVulkanStagingRing(  vk::PhysicalDevice &physicalDevice,
+                                            vk::Device &device,
+                                            vk::CommandPool &commandPool,
+                                            VulkanQueue &queue,
+                                            vk::DeviceSize capacity) {
+    VulkanStagingRing ring;
+
+    // Host-visible source buffer that stays mapped for the life of the ring
+    ring.buffer = createVulkanBuffer(physicalDevice, device, capacity,
+                                    vk::BufferUsageFlagBits::eTransferSrc,
+                                    vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                                    VulkanMemoryTag::Staging);
+    ring.mapped = static_cast<char*>(ring.buffer.allocation.mapped);
+    ring.capacity = capacity;
+
+    ring.commandPool = commandPool;
+    ring.queue = queue;
+    ring.ownerCommandPool = commandPool;
+    ring.ownerQueue = queue;
+
+    return ring;
+}
+
+VulkanStagingRing createVulkanStagingRing(  vk::PhysicalDevice &physicalDevice,
+                                            vk::Device &device,
+                                            vk::CommandPool &transferCommandPool,
+                                            VulkanQueue &transferQueue,
+                                            vk::CommandPool &ownerCommandPool,
+                                            VulkanQueue &ownerQueue,
+                                            vk::DeviceSize capacity) {
+
+    VulkanStagingRing ring = createVulkanStagingRing(   physicalDevice, device,
+                                                        transferCommandPool, transferQueue,
+                                                        capacity);
+    ring.ownerCommandPool = ownerCommandPool;
+    ring.ownerQueue = ownerQueue;
+
+    return ring;
+}
+
+bool usesVulkanOwnershipTransfer(VulkanStagingRing &ring) {
+    return ring.queue.index != ring.ownerQueue.index;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// RING SPACE MANAGEMENT
+///////////////////////////////////////////////////////////////////////////////
+
+// Copies are aligned so any dst offset/format is safe to copy from
+static const vk::DeviceSize STAGING_ALIGNMENT = 16;
+
+// Acquire ownership on the owner queue for a batch whose copies are DONE
+// (the release semaphore is already signaled, so this never stalls rendering)
+static void submitVulkanStagingAcquire(vk::Device &device, VulkanStagingRing &ring, VulkanStagingSubmit &submit) {
+    VulkanStagingAcquire acquire;
+    acquire.waitSemaphore = submit.releaseSemaphore;
+    acquire.fence = device.createFence(vk::FenceCreateInfo());
+    acquire.commandBuffer = createAndStartOneTimeVulkanCommandBuffer(device, ring.ownerCommandPool);
+
+    acquire.commandBuffer.pipelineBarrier(  vk::PipelineStageFlagBits::eAllCommands,
+                                            vk::PipelineStageFlagBits::eVertexInput
+                                            | vk::PipelineStageFlagBits::eVertexShader
+                                            | vk::PipelineStageFlagBits::eFragmentShader,
+                                            {}, {}, submit.acquireBuffers, submit.acquireImages);
+    acquire.commandBuffer.end();
+
+    vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
+    vk::SubmitInfo submitInfo(acquire.waitSemaphore, waitStage, acquire.commandBuffer);
+    ring.ownerQueue.queue.submit(submitInfo, acquire.fence);
+
+    ring.acquiresInFlight.push_back(acquire);
+}
+
+static void retireCompletedAcquires(vk::Device &device, VulkanStagingRing &ring, bool waitForAll) {
+    while(!ring.acquiresInFlight.empty()) {
+        VulkanStagingAcquire &acquire = ring.acquiresInFlight.front();
+
+        if(waitForAll) {
+            auto waitRes = device.waitForFences(acquire.fence, true, UINT64_MAX);
+            if(waitRes != vk::Result::eSuccess) {
+                throw runtime_error("retireCompletedAcquires: Timeout while waiting for acquire fence!");
+            }
+        }
+        else if(device.getFenceStatus(acquire.fence) != vk::Result::eSuccess) {
+            break;
+        }
+
+        device.freeCommandBuffers(ring.ownerCommandPool, acquire.commandBuffer);
+        device.destroyFence(acquire.fence);
+        device.destroySemaphore(acquire.waitSemaphore);
+        ring.acquiresInFlight.pop_front();
+    }
+}
+
+static void retireVulkanStagingSubmit(vk::Device &device, VulkanStagingRing &ring) {
+    VulkanStagingSubmit &submit = ring.inFlight.front();
+
+    if(submit.releaseSemaphore) {
+        submitVulkanStagingAcquire(device, ring, submit);
+    }
+
+    if(ring.profiler) {
+        collectVulkanGPUUploadTimer(device, *ring.profiler, submit.timerSlot);
+    }
+
+    if(submit.reclaimSemaphore) {
+        device.destroySemaphore(submit.reclaimSemaphore);
+    }
+
+    device.freeCommandBuffers(ring.commandPool, submit.commandBuffer);
+    device.destroyFence(submit.fence);
+    ring.lastCompleted = submit.serial;
+    ring.inFlight.pop_front();
+}
+
+// Release every region whose copies are done (never blocks)
+static void retireCompletedStaging(vk::Device &device, VulkanStagingRing &ring) {
+    while(!ring.inFlight.empty()
+            && device.getFenceStatus(ring.inFlight.front().fence) == vk::Result::eSuccess) {
+        retireVulkanStagingSubmit(device, ring);
+    }
+    retireCompletedAcquires(device, ring, false);
+}
+
+static void waitForOldestStaging(vk::Device &device, VulkanStagingRing &ring) {
+    auto waitRes = device.waitForFences(ring.inFlight.front().fence, true, UINT64_MAX);
+    if(waitRes != vk::Result::eSuccess) {
+        throw runtime_error("waitForOldestStaging: Timeout while waiting for staging fence!");
+    }
+    retireVulkanStagingSubmit(device, ring);
+}
+
+// Releases buffers the owner queue family already holds back to the copy queue
+// family; fills in the matching acquires and returns the semaphore the copies
+// must wait on
+static vk::Semaphore submitVulkanStagingReclaim(vk::Device &device, VulkanStagingRing &ring,
+                                                vector<vk::BufferMemoryBarrier> &acquireBuffers) {
+    // Earlier batches must be acquired on the owner queue BEFORE this release
+    while(!ring.inFlight.empty()) {
+        waitForOldestStaging(device, ring);
+    }
+
+    vector<vk::BufferMemoryBarrier> releaseBuffers;
+    for(VkBuffer buffer : ring.reclaimBuffers) {
+        releaseBuffers.push_back(vk::BufferMemoryBarrier(
+            {}, {},
+            ring.ownerQueue.index, ring.queue.index,
+            vk::Buffer(buffer), 0, VK_WHOLE_SIZE));
+        acquireBuffers.push_back(vk::BufferMemoryBarrier(
+            {}, vk::AccessFlagBits::eTransferWrite,
+            ring.ownerQueue.index, ring.queue.index,
+            vk::Buffer(buffer), 0, VK_WHOLE_SIZE));
+    }
+    ring.reclaimBuffers.clear();
+
+    // Queued after everything already submitted on the owner queue (so after any reads)
+    VulkanStagingAcquire release;
+    release.fence = device.createFence(vk::FenceCreateInfo());
+    release.commandBuffer = createAndStartOneTimeVulkanCommandBuffer(device, ring.ownerCommandPool);
+    release.commandBuffer.pipelineBarrier(  vk::PipelineStageFlagBits::eAllCommands,
+                                            vk::PipelineStageFlagBits::eBottomOfPipe,
+                                            {}, {}, releaseBuffers, {});
+    release.commandBuffer.end();
+
+    vk::Semaphore semaphore = createVulkanSemaphore(device);
+    vk::SubmitInfo submitInfo = vk::SubmitInfo().setCommandBuffers(release.commandBuffer)
+                                                .setSignalSemaphores(semaphore);
+    ring.ownerQueue.queue.submit(submitInfo, release.fence);
+
+    // Retired with the acquires (the semaphore belongs to the staging submit)
+    ring.acquiresInFlight.push_back(release);
+    return semaphore;
+}
+
+// Returns offset of [size] free bytes in the ring, flushing or waiting if full
+static vk::DeviceSize reserveStagingSpace(vk::Device &device, VulkanStagingRing &ring, vk::DeviceSize size) {
+    while(true) {
+        retireCompletedStaging(device, ring);
+
+        // Nothing in use, so start again from the beginning
+        bool isEmpty = ring.inFlight.empty() 
+                        && ring.pendingCopies.empty() 
+                        && ring.pendingImageCopies.empty();
+        if(isEmpty) {
+            ring.head = 0;
+            ring.pendingStart = 0;
+        }
+
+        // Oldest byte still in use
+        vk::DeviceSize tail = ring.inFlight.empty() ? ring.pendingStart : ring.inFlight.front().start;
+        vk::DeviceSize offset = ((ring.head + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT) * STAGING_ALIGNMENT;
+        bool found = false;
+
+        if(isEmpty || ring.head > tail) {
+            // Used region is [tail, head); space at the end OR wrap to the front
+            if(offset + size <= ring.capacity) {
+                found = true;
+            }
+            else if(size < tail) {
+                offset = 0;
+                found = true;
+            }
+        }
+        else if(offset + size < tail) {
+            // Used region wraps; space is [head, tail)
+            found = true;
+        }
+
+        if(found) {
+            ring.head = offset + size;
+            return offset;
+        }
+
+        // Out of room: send what we have (buffers stay on this queue until the
+        // batch ends), otherwise wait on the oldest batch
+        if(!ring.pendingCopies.empty() || !ring.pendingImageCopies.empty()) {
+            flushVulkanStagingRing(device, ring, false);
+        }
+        else {
+            waitForOldestStaging(device, ring);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// UPLOADS
+///////////////////////////////////////////////////////////////////////////////
+
+void stageDataToVulkanBuffer(   vk::Device &device,
+                                VulkanStagingRing &ring,
+                                VulkanBuffer &dst,
+                                vk::DeviceSize dstOffset,
+                                vk::DeviceSize size,
+                                const void *data) {
+
+    const char *src = static_cast<const char*>(data);
+
+    // Released at the end of the batch (taken back first if the owner queue has it)
+    if(usesVulkanOwnershipTransfer(ring) && size > 0) {
+        VkBuffer handle = static_cast<VkBuffer>(dst.buffer);
+        if(ring.ownerBuffers.erase(handle) > 0) {
+            ring.reclaimBuffers.insert(handle);
+        }
+        ring.transferBuffers.insert(handle);
+    }
+
+    // Data bigger than the ring goes through in pieces
+    vk::DeviceSize maxChunk = ring.capacity / 2;
+
+    while(size > 0) {
+        vk::DeviceSize chunk = min(size, maxChunk);
+        vk::DeviceSize srcOffset = reserveStagingSpace(device, ring, chunk);
+
+        memcpy(ring.mapped + srcOffset, src, chunk);
+        ring.pendingCopies.push_back({ dst.buffer, vk::BufferCopy(srcOffset, dstOffset, chunk) });
+
+        src += chunk;
+        dstOffset += chunk;
+        size -= chunk;
+    }
+}
+
+void stageDataToVulkanImage(vk::Device &device,
+                            VulkanStagingRing &ring,
+                            VulkanImage &dst,
+                            int width, int height,
+                            vk::DeviceSize size,
+                            const void *data) {
+
+    // Images are copied in one piece, so they must fit in the ring
+    if(size > ring.capacity) {
+        throw runtime_error("stageDataToVulkanImage: Image is larger than the staging ring!");
+    }
+
+    vk::DeviceSize srcOffset = reserveStagingSpace(device, ring, size);
+    memcpy(ring.mapped + srcOffset, data, size);
+
+    vk::BufferImageCopy region(
+        srcOffset, 0, 0,                                        // Tightly packed rows
+        vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1),
+        vk::Offset3D(0, 0, 0),
+        vk::Extent3D(width, height, 1));
+
+    ring.pendingImageCopies.push_back({ dst.image, region });
+}
+
+uint64_t flushVulkanStagingRing(vk::Device &device, VulkanStagingRing &ring, bool releaseOwnership) {
+    // Copies on another queue family must hand the resources over afterwards
+    bool transferOwnership = usesVulkanOwnershipTransfer(ring);
+    bool releasePending = transferOwnership && releaseOwnership && !ring.transferBuffers.empty();
+    if(ring.pendingCopies.empty() && ring.pendingImageCopies.empty() && !releasePending) {
+        return ring.lastSubmitted;
+    }
+
+    // Buffers the owner queue already has are given back first
+    VulkanStagingSubmit submit;
+    vector<vk::BufferMemoryBarrier> reclaimBuffers;
+    if(transferOwnership && !ring.reclaimBuffers.empty()) {
+        submit.reclaimSemaphore = submitVulkanStagingReclaim(device, ring, reclaimBuffers);
+    }
+
+    // Record ALL pending copies into one command buffer
+    vk::CommandBuffer commandBuffer = createAndStartOneTimeVulkanCommandBuffer(device, ring.commandPool);
+
+    int timerSlot = -1;
+    if(ring.profiler) {
+        timerSlot = beginVulkanGPUUploadTimer(*ring.profiler, commandBuffer);
+    }
+
+    if(!reclaimBuffers.empty()) {
+        commandBuffer.pipelineBarrier(  vk::PipelineStageFlagBits::eTopOfPipe,
+                                        vk::PipelineStageFlagBits::eTransfer,
+                                        {}, {}, reclaimBuffers, {});
+    }
+
+    vector<vk::BufferCopy> regions;
+    for(unsigned int i = 0; i < ring.pendingCopies.size(); i++) {
+        regions.push_back(ring.pendingCopies[i].region);
+
+        // Consecutive copies to the same buffer go in one call
+        bool lastForDst = (i + 1 == ring.pendingCopies.size())
+                            || (ring.pendingCopies[i + 1].dst != ring.pendingCopies[i].dst);
+        if(lastForDst) {
+            commandBuffer.copyBuffer(ring.buffer.buffer, ring.pendingCopies[i].dst, regions);
+            regions.clear();
+        }
+    }
+
+    vector<vk::BufferMemoryBarrier> releaseBuffers;
+    vector<vk::ImageMemoryBarrier> releaseImages;
+
+    // Images: undefined -> transfer dst, copy, then transfer dst -> shader read
+    if(!ring.pendingImageCopies.empty()) {
+        vector<vk::ImageMemoryBarrier> toTransfer;
+        vector<vk::ImageMemoryBarrier> toShader;
+
+        for(auto &copy : ring.pendingImageCopies) {
+            vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+
+            toTransfer.push_back(vk::ImageMemoryBarrier(
+                {}, vk::AccessFlagBits::eTransferWrite,
+                vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+                vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
+                copy.dst, range));
+
+            if(transferOwnership) {
+                // Same layout change is done by BOTH the release and the acquire
+                releaseImages.push_back(vk::ImageMemoryBarrier(
+                    vk::AccessFlagBits::eTransferWrite, {},
+                    vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+                    ring.queue.index, ring.ownerQueue.index,
+                    copy.dst, range));
+                submit.acquireImages.push_back(vk::ImageMemoryBarrier(
+                    {}, vk::AccessFlagBits::eShaderRead,
+                    vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+                    ring.queue.index, ring.ownerQueue.index,
+                    copy.dst, range));
+            }
+            else {
+                toShader.push_back(vk::ImageMemoryBarrier(
+                    vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead,
+                    vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+                    vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
+                    copy.dst, range));
+            }
+        }
+
+        commandBuffer.pipelineBarrier(  vk::PipelineStageFlagBits::eTopOfPipe,
+                                        vk::PipelineStageFlagBits::eTransfer,
+                                        {}, {}, {}, toTransfer);
+
+        for(auto &copy : ring.pendingImageCopies) {
+            commandBuffer.copyBufferToImage(ring.buffer.buffer, copy.dst,
+                                            vk::ImageLayout::eTransferDstOptimal, copy.region);
+        }
+
+        if(!toShader.empty()) {
+            commandBuffer.pipelineBarrier(  vk::PipelineStageFlagBits::eTransfer,
+                                            vk::PipelineStageFlagBits::eFragmentShader,
+                                            {}, {}, {}, toShader);
+        }
+    }
+
+    if(transferOwnership) {
+        // Release every buffer written during the batch (once each, after its last
+        // copy, which may have been in an earlier flush) to the owner queue family
+        if(releaseOwnership) {
+            for(VkBuffer dst : ring.transferBuffers) {
+                releaseBuffers.push_back(vk::BufferMemoryBarrier(
+                    vk::AccessFlagBits::eTransferWrite, {},
+                    ring.queue.index, ring.ownerQueue.index,
+                    vk::Buffer(dst), 0, VK_WHOLE_SIZE));
+                submit.acquireBuffers.push_back(vk::BufferMemoryBarrier(
+                    {}, vk::AccessFlagBits::eVertexAttributeRead
+                        | vk::AccessFlagBits::eIndexRead
+                        | vk::AccessFlagBits::eUniformRead
+                        | vk::AccessFlagBits::eShaderRead,
+                    ring.queue.index, ring.ownerQueue.index,
+                    vk::Buffer(dst), 0, VK_WHOLE_SIZE));
+                ring.ownerBuffers.insert(dst);
+            }
+            ring.transferBuffers.clear();
+        }
+
+        commandBuffer.pipelineBarrier(  vk::PipelineStageFlagBits::eTransfer,
+                                        vk::PipelineStageFlagBits::eBottomOfPipe,
+                                        {}, {}, releaseBuffers, releaseImages);
+    }
+    else {
+        // Make the copies visible to anything later on this queue
+        vk::MemoryBarrier barrier(  vk::AccessFlagBits::eTransferWrite,
+                                    vk::AccessFlagBits::eVertexAttributeRead
+                                    | vk::AccessFlagBits::eIndexRead
+                                    | vk::AccessFlagBits::eUniformRead
+                                    | vk::AccessFlagBits::eShaderRead);
+        commandBuffer.pipelineBarrier(  vk::PipelineStageFlagBits::eTransfer,
+                                        vk::PipelineStageFlagBits::eVertexInput
+                                        | vk::PipelineStageFlagBits::eVertexShader
+                                        | vk::PipelineStageFlagBits::eFragmentShader,
+                                        {}, barrier, {}, {});
+    }
+
+    if(ring.profiler) {
+        endVulkanGPUUploadTimer(*ring.profiler, commandBuffer, timerSlot);
+    }
+
+    commandBuffer.end();
+
+    // Submit with a fence that guards this region of the ring
+    submit.serial = ++ring.lastSubmitted;
+    submit.start = ring.pendingStart;
+    submit.end = ring.head;
+    submit.fence = device.createFence(vk::FenceCreateInfo());
+    submit.commandBuffer = commandBuffer;
+    submit.timerSlot = timerSlot;
+
+    vk::SubmitInfo submitInfo = vk::SubmitInfo().setCommandBuffers(commandBuffer);
+    if(!submit.acquireBuffers.empty() || !submit.acquireImages.empty()) {
+        submit.releaseSemaphore = createVulkanSemaphore(device);
+        submitInfo.setSignalSemaphores(submit.releaseSemaphore);
+    }
+
+    vk::PipelineStageFlags reclaimWaitStage = vk::PipelineStageFlagBits::eTransfer;
+    if(submit.reclaimSemaphore) {
+        submitInfo.setWaitSemaphores(submit.reclaimSemaphore)
+                  .setWaitDstStageMask(reclaimWaitStage);
+    }
+
+    ring.queue.queue.submit(submitInfo, submit.fence);
+
+    ring.inFlight.push_back(submit);
+    ring.pendingCopies.clear();
+    ring.pendingImageCopies.clear();
+    ring.pendingStart = ring.head;
+
+    return submit.serial;
+}
+
+void updateVulkanStagingRing(vk::Device &device, VulkanStagingRing &ring) {
+    retireCompletedStaging(device, ring);
+}
+
+bool isVulkanStagingComplete(vk::Device &device, VulkanStagingRing &ring, uint64_t serial) {
+    retireCompletedStaging(device, ring);
+    return serial <= ring.lastCompleted;
+}
+
+void waitForVulkanStagingRing(vk::Device &device, VulkanStagingRing &ring, uint64_t serial) {
+    while(ring.lastCompleted < serial && !ring.inFlight.empty()) {
+        waitForOldestStaging(device, ring);
+    }
+}
+
+void copyDataToVulkanBufferViaStaging(  vk::Device &device,
+                                        VulkanStagingRing &ring,
+                                        VulkanBuffer &dst,
+                                        vk::DeviceSize size,
+                                        void *data) {
+
+    // Stage, submit, and wait for just this copy
+    stageDataToVulkanBuffer(device, ring, dst, 0, size, data);
+    uint64_t serial = flushVulkanStagingRing(device, ring);
+    waitForVulkanStagingRing(device, ring, serial);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CLEANUP
+///////////////////////////////////////////////////////////////////////////////
+
+void cleanupVulkanStagingRing(vk::Device &device, VulkanStagingRing &ring) {
+    flushVulkanStagingRing(device, ring);
+    while(!ring.inFlight.empty()) {
+        waitForOldestStaging(device, ring);
+    }
+    retireCompletedAcquires(device, ring, true);
+
+    cleanupVulkanBuffer(device, ring.buffer);
+    ring.mapped = nullptr;
+    ring.capacity = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// UPLOAD BATCHES
+///////////////////////////////////////////////////////////////////////////////
+
+VulkanUploadBatch beginVulkanUploadBatch(VulkanInitData &vkInitData, VulkanStagingRing &ring) {
+    VulkanUploadBatch batch;
+    batch.vkInitData = &vkInitData;
+    batch.ring = &ring;
+    return batch;
+}
+
+void queueVulkanBufferUpload(   VulkanUploadBatch &batch,
+                                VulkanBuffer &dst,
+                                vk::DeviceSize dstOffset,
+                                vk::DeviceSize size,
+                                const void *data) {
+    stageDataToVulkanBuffer(batch.vkInitData->device, *batch.ring, dst, dstOffset, size, data);
+    batch.uploadCnt++;
+}
+
+VulkanImage queueVulkanImageUpload( VulkanUploadBatch &batch,
+                                    int width, int height,
+                                    vk::Format format,
+                                    vk::DeviceSize size,
+                                    const void *pixels) {
+    // Create sampled image that can be copied into
+    VulkanImage image = createVulkanImage(  *batch.vkInitData, width, height, format,
+                                            vk::ImageUsageFlagBits::eTransferDst 
+                                            | vk::ImageUsageFlagBits::eSampled,
+                                            vk::ImageAspectFlagBits::eColor,
+                                            VulkanMemoryTag::Texture);
+
+    stageDataToVulkanImage(batch.vkInitData->device, *batch.ring, image, width, height, size, pixels);
+    batch.uploadCnt++;
+
+    return image;
+}
+
+VulkanUploadToken submitVulkanUploadBatch(VulkanUploadBatch &batch) {
+    // Serials complete in order, so the last one covers any early flushes
+    VulkanUploadToken token;
+    token.ring = batch.ring;
+    token.serial = flushVulkanStagingRing(batch.vkInitData->device, *batch.ring);
+
+    batch.uploadCnt = 0;
+    return token;
+}
+
+bool isVulkanUploadComplete(vk::Device &device, VulkanUploadToken &token) {
+    if(!token.ring) {
+        return true;
+    }
+    return isVulkanStagingComplete(device, *token.ring, token.serial);
+}
+
+void waitForVulkanUpload(vk::Device &device, VulkanUploadToken &token) {
+    if(token.ring) {
+        waitForVulkanStagingRing(device, *token.ring, token.serial);
+    }
+}
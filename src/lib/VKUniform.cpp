@@ -1,4 +1,5 @@
 #include "VKUniform.hpp"
+#include <algorithm>
 
 vk::DescriptorSetLayout createUniformDescriptorSetLayout(VulkanInitData &vkInitData) {
     // Create bindings
@@ -48,10 +49,11 @@ UBOData createVulkanUniformBufferData(vk::Device &device,
                                 device,
                                 bufferSize,
                                 vk::BufferUsageFlagBits::eUniformBuffer,
-                                vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+                                vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                                VulkanMemoryTag::Uniform);
 
-        // Keep the memory mapped
-        vkMapMemory(device, data.bufferData[i].memory, 0, bufferSize, 0, &data.mapped[i]);
+        // Memory is kept mapped by the allocator
+        data.mapped[i] = data.bufferData[i].allocation.mapped;
     }
 
     return data;
@@ -63,4 +65,68 @@ void cleanupVulkanUniformBufferData(vk::Device &device, UBOData &uboData) {
     }
     uboData.bufferData.clear();
     uboData.mapped.clear();  
-}
\ No newline at end of file
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Per-frame linear uniform allocator
+///////////////////////////////////////////////////////////////////////////////
+
+VulkanFrameUniformAllocator createVulkanFrameUniformAllocator(  vk::Device &device,
+                                                                vk::PhysicalDevice &physicalDevice,
+                                                                vk::DeviceSize frameSize,
+                                                                int maxFramesInFlight,
+                                                                vk::BufferUsageFlags extraUsage) {
+    VulkanFrameUniformAllocator allocator;
+
+    // Same buffer may be bound as uniform OR storage, so honor both alignments
+    vk::PhysicalDeviceLimits limits = physicalDevice.getProperties().limits;
+    allocator.alignment = max(limits.minUniformBufferOffsetAlignment, 
+                                limits.minStorageBufferOffsetAlignment);
+    allocator.alignment = max(allocator.alignment, (vk::DeviceSize)1);
+
+    // Keep every region start aligned
+    allocator.frameSize = ((frameSize + allocator.alignment - 1) / allocator.alignment) * allocator.alignment;
+    allocator.frameCnt = maxFramesInFlight;
+
+    allocator.buffer = createVulkanBuffer(
+                            physicalDevice,
+                            device,
+                            allocator.frameSize * allocator.frameCnt,
+                            vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer
+                            | extraUsage,
+                            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                            VulkanMemoryTag::Uniform);
+
+    // Memory is kept mapped by the allocator
+    allocator.mapped = static_cast<char*>(allocator.buffer.allocation.mapped);
+
+    return allocator;
+}
+
+void beginVulkanFrameUniforms(VulkanFrameUniformAllocator &allocator, unsigned int frameIndex) {
+    // The caller has already waited on this frame's fence, so its region is free again
+    allocator.frameIndex = frameIndex % allocator.frameCnt;
+    allocator.head = 0;
+}
+
+VulkanFrameUniformBlock allocateVulkanFrameUniform(VulkanFrameUniformAllocator &allocator, vk::DeviceSize size) {
+    vk::DeviceSize start = allocator.head;
+    if(start + size > allocator.frameSize) {
+        throw runtime_error("allocateVulkanFrameUniform: Out of per-frame uniform space!");
+    }
+
+    // Next block starts at an aligned offset
+    allocator.head = ((start + size + allocator.alignment - 1) / allocator.alignment) * allocator.alignment;
+
+    vk::DeviceSize offset = allocator.frameSize * allocator.frameIndex + start;
+
+    VulkanFrameUniformBlock block;
+    block.mapped = allocator.mapped + offset;
+    block.dynamicOffset = static_cast<uint32_t>(offset);
+    return block;
+}
+
+void cleanupVulkanFrameUniformAllocator(vk::Device &device, VulkanFrameUniformAllocator &allocator) {
+    cleanupVulkanBuffer(device, allocator.buffer);
+    allocator = VulkanFrameUniformAllocator();
+}
@@ -0,0 +1,104 @@
+#include "VertexQuantize.hpp"
+#include <algorithm>
+#include <cmath>
+
+///////////////////////////////////////////////////////////////////////////////
+// SCALARS
+///////////////////////////////////////////////////////////////////////////////
+
+// Round to nearest, matching how the GPU converts UNORM/SNORM back to float
+uint16_t quantizeUnorm16(float v) {
+    v = std::min(std::max(v, 0.0f), 1.0f);
+    return (uint16_t)(v * 65535.0f + 0.5f);
+}
+
+int16_t quantizeSnorm16(float v) {
+    v = std::min(std::max(v, -1.0f), 1.0f);
+    return (int16_t)std::lround(v * 32767.0f);
+}
+
+uint8_t quantizeUnorm8(float v) {
+    v = std::min(std::max(v, 0.0f), 1.0f);
+    return (uint8_t)(v * 255.0f + 0.5f);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// NORMALS
+///////////////////////////////////////////////////////////////////////////////
+
+static float signNotZero(float v) {
+    return (v >= 0.0f) ? 1.0f : -1.0f;
+}
+
+glm::vec2 encodeOctahedronNormal(glm::vec3 n) {
+    float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    if(l1 <= 0.0f) {
+        return glm::vec2(0.0f);
+    }
+    n /= l1;
+
+    // Lower hemisphere folds over the diagonals
+    glm::vec2 e(n.x, n.y);
+    if(n.z < 0.0f) {
+        e = glm::vec2(  (1.0f - std::fabs(n.y)) * signNotZero(n.x),
+                        (1.0f - std::fabs(n.x)) * signNotZero(n.y));
+    }
+    return e;
+}
+
+glm::vec3 decodeOctahedronNormal(glm::vec2 e) {
+    // Same as decodeOctahedron() in the quantized vertex shader
+    glm::vec3 n(e.x, e.y, 1.0f - std::fabs(e.x) - std::fabs(e.y));
+    float t = std::max(-n.z, 0.0f);
+    n.x += (n.x >= 0.0f) ? -t : t;
+    n.y += (n.y >= 0.0f) ? -t : t;
+
+    float length = glm::length(n);
+    return (length > 0.0f) ? n / length : glm::vec3(0.0f, 0.0f, 1.0f);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// VERTICES
+///////////////////////////////////////////////////////////////////////////////
+
+VertexDequantize getVertexDequantize(const AABB &box) {
+    VertexDequantize dequant;
+    dequant.offset = box.min;
+
+    // Flat meshes keep a non-zero scale so quantizing never divides by zero
+    glm::vec3 extent = box.max - box.min;
+    dequant.scale = glm::vec3(  std::max(extent.x, 1e-8f),
+                                std::max(extent.y, 1e-8f),
+                                std::max(extent.z, 1e-8f));
+    return dequant;
+}
+
+glm::mat4 getVertexDequantizeMatrix(const VertexDequantize &dequant) {
+    glm::mat4 mat(1.0f);
+    mat[0][0] = dequant.scale.x;
+    mat[1][1] = dequant.scale.y;
+    mat[2][2] = dequant.scale.z;
+    mat[3] = glm::vec4(dequant.offset, 1.0f);
+    return mat;
+}
+
+QuantizedVertex quantizeVertex( const glm::vec3 &pos, const glm::vec4 &color, const glm::vec3 &normal,
+                                const VertexDequantize &dequant) {
+    QuantizedVertex v;
+
+    glm::vec3 t = (pos - dequant.offset) / dequant.scale;
+    v.pos[0] = quantizeUnorm16(t.x);
+    v.pos[1] = quantizeUnorm16(t.y);
+    v.pos[2] = quantizeUnorm16(t.z);
+    v.pos[3] = 0;
+
+    glm::vec2 e = encodeOctahedronNormal(normal);
+    v.normal[0] = quantizeSnorm16(e.x);
+    v.normal[1] = quantizeSnorm16(e.y);
+
+    v.color[0] = quantizeUnorm8(color.r);
+    v.color[1] = quantizeUnorm8(color.g);
+    v.color[2] = quantizeUnorm8(color.b);
+    v.color[3] = quantizeUnorm8(color.a);
+    return v;
+}
@@ -0,0 +1,35 @@
+#version 450
+
+layout(std140, binding = 0) uniform matrices {
+    mat4 viewMat;
+    mat4 projMat;
+}ubo;
+
+// QuantizedVertex: UNORM position within the mesh AABB (inModelMat includes
+// the dequantize matrix), RGBA8 color, octahedron-encoded SNORM normal
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) in vec2 inNormalOct;
+
+// Per instance (binding 1)
+layout(location = 3) in mat4 inModelMat;
+layout(location = 7) in mat4 inNormMat;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec4 interPos;
+layout(location = 2) out vec3 interNormal;
+
+vec3 decodeOctahedron(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += (n.x >= 0.0) ? -t : t;
+    n.y += (n.y >= 0.0) ? -t : t;
+    return normalize(n);
+}
+
+void main() {
+    gl_Position = ubo.projMat * ubo.viewMat * inModelMat * vec4(inPosition, 1.0);
+    fragColor = inColor;
+    interPos = ubo.viewMat * inModelMat * vec4(inPosition, 1.0);
+    interNormal = mat3(inNormMat)*decodeOctahedron(inNormalOct);
+} 